@@ -29,7 +29,17 @@ namespace Trivia_client.CommunicationHandling
         SUBMIT_ANSWER_REQUEST, SUBMIT_ANSWER_RESPONSE,
         GET_QUESTION_REQUEST, GET_QUESTION_RESPONSE,
         GET_GAME_RESULTS_REQUEST, GET_GAME_RESULTS_RESPONSE,
-        LEAVE_GAME_REQUEST, LEAVE_GAME_RESPONSE
+        LEAVE_GAME_REQUEST, LEAVE_GAME_RESPONSE,
+        BATCH_REQUEST, BATCH_RESPONSE,
+        SUBSCRIBE_REQUEST, SUBSCRIBE_RESPONSE,
+        UNSUBSCRIBE_REQUEST, UNSUBSCRIBE_RESPONSE,
+        ROOM_STATE_EVENT,
+        ANSWER_REVEALED_EVENT, NEXT_QUESTION_EVENT, GAME_OVER_EVENT,
+        NOT_MODIFIED_RESPONSE,
+        PING, PONG,
+        BUSY_RESPONSE,
+        RATE_LIMITED_RESPONSE,
+        RESUME_REQUEST, RESUME_RESPONSE
     }
 
     /// <summary>
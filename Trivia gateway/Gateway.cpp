@@ -0,0 +1,333 @@
+#include "Gateway.h"
+#include "EpollEventLoop.h"
+#include "PollEventLoop.h"
+#include "UringEventLoop.h"
+#include "FrameParser.h"
+#include "LinkFrame.h"
+#include "Config.h"
+#include <iostream>
+#include <algorithm>
+#include <thread>
+
+
+Gateway::Gateway()
+{
+	Config* config = Config::getInstance();
+	mSharedListener = false;
+	mTlsListener = INVALID_SOCKET;
+	mTls = nullptr;
+	mNextLoop = 0;
+	mServerAddress = config->getString("server_address", DEFAULT_SERVER_ADDRESS);
+	mServerPort = config->getInt("server_port", DEFAULT_SERVER_PORT);
+	mIdleTimeout = (unsigned int)std::max(0, config->getInt("idle_timeout", DEFAULT_IDLE_TIMEOUT)) * 1000;
+}
+
+Gateway::~Gateway()
+{
+	for (Front* front : mFronts)
+	{
+		front->reactor->getLoop()->stop();
+	}
+	for (Front* front : mFronts)
+	{
+		delete front->reactor;
+		delete front;
+	}
+	mFronts.clear();
+}
+
+bool Gateway::start(const int port)
+{
+	Config* config = Config::getInstance();
+	unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+	unsigned int count = (unsigned int)std::max(1, config->getInt("reactors", (int)cores));
+	int tlsPort = config->getInt("tls_port", 0);
+	mSharedListener = count > 1 && !Socket::supportsReusePort();
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		Front* front = new Front();
+		front->reactor = new Reactor(createLoop(), NO_CORE);
+		front->linkSocket = INVALID_SOCKET;
+		front->down = true;
+		front->nextSession = 0;
+		mFronts.push_back(front);
+		mFrontsByLoop[front->reactor->getLoop()] = front;
+		if (i == 0 || !mSharedListener)
+		{
+			front->reactor->listen(Socket::createListener(port, !mSharedListener && count > 1));
+		}
+	}
+	for (Front* front : mFronts)
+	{
+		if (!connectLink(front))
+		{
+			std::cout << "Could not reach the server at " << mServerAddress << ":" << mServerPort << std::endl;
+			return false;
+		}
+	}
+	if (tlsPort != 0)
+	{
+		try
+		{
+			mTlsListener = Socket::createListener(tlsPort);
+			mTls = new TlsAcceptor(config->getString("tls_certificate", ""), config->getString("tls_private_key", ""),
+				[this](SOCKET client, TlsSession* tls)
+				{
+					Front* front = mFronts[mNextLoop++ % mFronts.size()];
+					if (front->down)
+					{
+						delete tls;
+						Socket::closeSocket(client);
+						return;
+					}
+					front->reactor->getLoop()->adopt(client, tls);
+				});
+			mFronts[0]->reactor->listen(mTlsListener);
+			std::cout << "Listening for TLS on port " << tlsPort << std::endl;
+		}
+		catch (const std::runtime_error& e)
+		{
+			std::cout << "No TLS: " << e.what() << std::endl;
+			if (mTlsListener != INVALID_SOCKET) Socket::closeSocket(mTlsListener);
+			mTlsListener = INVALID_SOCKET;
+		}
+	}
+	std::cout << "Listening on port " << port << " with " << count << " links to " << mServerAddress << ":" << mServerPort << std::endl;
+
+	for (unsigned int i = 1; i < count; i++)
+	{
+		mFronts[i]->reactor->start();
+	}
+	return true;
+}
+
+void Gateway::run()
+{
+	mFronts[0]->reactor->run();
+	//Handshakes that finish now would go to loops that are stopping.
+	delete mTls;
+	mTls = nullptr;
+	for (size_t i = 1; i < mFronts.size(); i++)
+	{
+		mFronts[i]->reactor->stop();
+	}
+}
+
+void Gateway::stop()
+{
+	//The first reactor runs on the thread of run, which stops the others once it returns.
+	if (!mFronts.empty()) mFronts[0]->reactor->getLoop()->stop();
+}
+
+void Gateway::reconnect()
+{
+	for (Front* front : mFronts)
+	{
+		if (front->down && connectLink(front))
+		{
+			std::cout << "Link to the server is back" << std::endl;
+		}
+	}
+}
+
+bool Gateway::connectLink(Front* front)
+{
+	SOCKET link = Socket::connectTo(mServerAddress, mServerPort);
+	if (link == INVALID_SOCKET) return false;
+	front->down = false;
+	IEventLoop* loop = front->reactor->getLoop();
+	//Set on the loop's thread, onOpen tells the link from the clients by it.
+	loop->post([front, loop, link]()
+		{
+			front->linkSocket = link;
+			loop->adopt(link);
+		});
+	return true;
+}
+
+void Gateway::onAccept(IEventLoop& loop, SOCKET listener, SOCKET client)
+{
+	if (listener == mTlsListener)
+	{
+		mTls->handshake(client);
+		return;
+	}
+	IEventLoop* target = mSharedListener ? mFronts[mNextLoop++ % mFronts.size()]->reactor->getLoop() : &loop;
+	if (mFrontsByLoop[target]->down)
+	{
+		//Without a link there is no server to talk to, the client retries later.
+		Socket::closeSocket(client);
+		return;
+	}
+	target->adopt(client);
+}
+
+void Gateway::onOpen(Connection& connection)
+{
+	Front* front = mFrontsByLoop[connection.getLoop()];
+	if (connection.getSocket() == front->linkSocket)
+	{
+		front->link = connection.shared_from_this();
+		//A link carries thousands of clients: it is never reaped, paused or evicted.
+		connection.setIdleTimeout(0);
+		connection.setOutboundLimit(0);
+		return;
+	}
+	connection.setIdleTimeout(mIdleTimeout);
+	//The link dropped after the client was accepted, onData turns it away.
+	if (front->link == nullptr) return;
+	unsigned int session = front->nextSession++;
+	front->clients[session] = connection.shared_from_this();
+	front->sessions[&connection] = Client{ session, 0 };
+	string address = connection.getLoop()->getPeerAddress(connection);
+	sendFrame(front, linkHeader(LINK_OPEN, session, address.size()) + address);
+}
+
+void Gateway::onData(Connection& connection)
+{
+	Front* front = mFrontsByLoop[connection.getLoop()];
+	if (front->link.get() == &connection)
+	{
+		receive(front);
+		return;
+	}
+	auto it = front->sessions.find(&connection);
+	if (it == front->sessions.end() || front->link == nullptr)
+	{
+		connection.getLoop()->close(connection);
+		return;
+	}
+	//The bytes go on as they came, the server cuts them into requests.
+	RingBuffer& inbound = connection.getInbound();
+	while (!inbound.empty())
+	{
+		size_t len = std::min(inbound.size(), (size_t)MAX_MESSAGE_SIZE);
+		string frame = linkHeader(LINK_DATA, it->second.session, len);
+		frame.resize(LINK_HEADER_SIZE + len);
+		inbound.peek(0, &frame[LINK_HEADER_SIZE], len);
+		inbound.consume(len);
+		sendFrame(front, std::move(frame));
+	}
+}
+
+void Gateway::onClose(Connection& connection)
+{
+	Front* front = mFrontsByLoop[connection.getLoop()];
+	if (front->link.get() == &connection)
+	{
+		std::cout << "Link to the server dropped, closing its " << front->clients.size() << " clients" << std::endl;
+		front->link = nullptr;
+		front->linkSocket = INVALID_SOCKET;
+		map<unsigned int, shared_ptr<Connection>> clients;
+		clients.swap(front->clients);
+		front->sessions.clear();
+		for (auto& it : clients)
+		{
+			connection.getLoop()->close(*it.second);
+		}
+		front->down = true;
+		return;
+	}
+	auto it = front->sessions.find(&connection);
+	if (it == front->sessions.end()) return;
+	unsigned int session = it->second.session;
+	front->sessions.erase(it);
+	front->clients.erase(session);
+	if (front->link != nullptr) sendFrame(front, linkHeader(LINK_CLOSE, session, 0));
+}
+
+bool Gateway::onIdle(Connection& /*connection*/)
+{
+	return false;
+}
+
+void Gateway::onDrained(Connection& connection)
+{
+	Front* front = mFrontsByLoop[connection.getLoop()];
+	auto it = front->sessions.find(&connection);
+	if (it != front->sessions.end()) acknowledge(front, it->second);
+}
+
+void Gateway::acknowledge(Front* front, Client& client)
+{
+	if (client.unacked < LINK_ACK_STEP || front->link == nullptr) return;
+	sendFrame(front, linkAck(client.session, (unsigned int)client.unacked));
+	client.unacked = 0;
+}
+
+void Gateway::receive(Front* front)
+{
+	// One frame per loop thread, its payload is moved to the client.
+	static thread_local RequestInfo frame;
+	shared_ptr<Connection> link = front->link;
+	IEventLoop* loop = link->getLoop();
+	FrameParser::Result result;
+	while (!link->isClosed() && (result = FrameParser::next(link->getInbound(), frame)) != FrameParser::INCOMPLETE)
+	{
+		if (result == FrameParser::OVERSIZED)
+		{
+			loop->close(*link);
+			return;
+		}
+		auto it = front->clients.find(frame.requestId);
+		//A client that went away, the server did not see its LINK_CLOSE yet.
+		if (it == front->clients.end()) continue;
+		shared_ptr<Connection> client = it->second;
+		if (frame.code == LINK_DATA)
+		{
+			Client& state = front->sessions[client.get()];
+			state.unacked += frame.data.size();
+			client->getOutbound().pushBytes(std::move(frame.data));
+			loop->cork(*client);
+			//A backed up client is acknowledged once it drained, the server holds the rest until then.
+			if (!client->isBackedUp()) acknowledge(front, state);
+		}
+		else if (frame.code == LINK_CLOSE)
+		{
+			front->sessions.erase(client.get());
+			front->clients.erase(it);
+			//What the server sent before it closed the session still goes out.
+			loop->flush(*client);
+			loop->close(*client);
+		}
+	}
+}
+
+void Gateway::sendFrame(Front* front, string&& frame)
+{
+	front->link->getOutbound().pushBytes(std::move(frame));
+	front->link->getLoop()->cork(*front->link);
+}
+
+IEventLoop* Gateway::createLoop()
+{
+	Config* config = Config::getInstance();
+	string backend = config->getString("io_backend", DEFAULT_IO_BACKEND);
+	IEventLoop* loop = nullptr;
+#ifdef __linux__
+	if (backend == "uring")
+	{
+		try
+		{
+			loop = new UringEventLoop(this);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << e.what() << ", falling back to epoll" << std::endl;
+		}
+	}
+	if (loop == nullptr && backend != "poll")
+	{
+		loop = new EpollEventLoop(this);
+	}
+#endif
+	if (loop == nullptr)
+	{
+		loop = new PollEventLoop(this);
+	}
+	loop->setOutboundLimits((size_t)std::max(0, config->getInt("outbound_high_watermark", OUTBOUND_HIGH_WATERMARK)),
+		(size_t)std::max(0, config->getInt("outbound_low_watermark", OUTBOUND_LOW_WATERMARK)),
+		(unsigned int)std::max(1, config->getInt("slow_consumer_timeout", SLOW_CONSUMER_TIMEOUT_MS / 1000)) * 1000);
+	return loop;
+}
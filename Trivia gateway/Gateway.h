@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Socket.h"
+#include "IEventLoop.h"
+#include "Reactor.h"
+#include "TlsAcceptor.h"
+#include <map>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+using std::map;
+using std::vector;
+using std::shared_ptr;
+
+#define PORT 8177 // Next to the server's 8175, so both run on one host.
+#define DEFAULT_SERVER_ADDRESS "127.0.0.1"
+#define DEFAULT_SERVER_PORT 8176 // The "gateway_port" of the server.
+#define DEFAULT_IO_BACKEND "epoll"
+#define DEFAULT_IDLE_TIMEOUT 0 // Seconds of silence before a client is reaped, 0 never: a player may sit in the menu for long.
+#define LINK_RETRY_MS 1000
+
+/*
+A front end that terminates the client connections in front of a game server.
+Every reactor accepts clients and keeps one long-lived link to the server, over which it
+forwards the byte streams of its clients, each tagged with a session ID (see LinkFrame.h).
+The server runs the protocol, the gateway only moves bytes, so thousands of client sockets
+(and their TLS) cost the server a handful of connections.
+*/
+class Gateway : public IConnectionEvents
+{
+public:
+	Gateway();
+	~Gateway();
+	/*
+	* Starts one reactor per core ("reactors" setting), each with its own listener on the port
+	* where the platform supports SO_REUSEPORT, and links them to the server ("server_address",
+	* "server_port" settings). With the "tls_port" setting, clients may also connect there with
+	* TLS, like to the server itself. The first reactor waits for run().
+	* @returns False if the server could not be reached.
+	* @throws std::runtime_error If a port could not be listened on.
+	*/
+	bool start(const int port);
+
+	/*
+	* Runs the first reactor on the calling thread until stop() is called, then stops the others.
+	*/
+	void run();
+
+	/*
+	* Stops the reactors, run returns. The clients are closed. Safe to call from any thread.
+	*/
+	void stop();
+
+	/*
+	* Connects the links that went down again. Clients that arrive while the link of their
+	* reactor is down are turned away. Called periodically from any thread but the reactors'.
+	*/
+	void reconnect();
+
+	/*
+	* Keeps an accepted socket on the loop that accepted it, like the server does.
+	*/
+	virtual void onAccept(IEventLoop& loop, SOCKET listener, SOCKET client) override;
+	/*
+	* Opens a session on the server for a new client.
+	*/
+	virtual void onOpen(Connection& connection) override;
+	/*
+	* Forwards what a client sent to the server, and what the server sent to its clients.
+	*/
+	virtual void onData(Connection& connection) override;
+	/*
+	* Tells the server a client went away. A link that closes closes the clients it carried.
+	*/
+	virtual void onClose(Connection& connection) override;
+	/*
+	* Reaps a silent client, the server does not reap the sessions of gateways.
+	*/
+	virtual bool onIdle(Connection& connection) override;
+	/*
+	* Acknowledges what a client that was backed up took since.
+	*/
+	virtual void onDrained(Connection& connection) override;
+private:
+	/*
+	* A client and what the server sent it that was not acknowledged yet.
+	*/
+	struct Client
+	{
+		unsigned int session;
+		size_t unacked; //Acknowledged in steps of LINK_ACK_STEP, and not while the client is backed up.
+	};
+
+	/*
+	* The clients of one reactor and its link.
+	*/
+	struct Front
+	{
+		Reactor* reactor;
+		shared_ptr<Connection> link; //nullptr while it is down, only touched on the reactor's thread.
+		SOCKET linkSocket;
+		std::atomic<bool> down;
+		map<unsigned int, shared_ptr<Connection>> clients; //By session ID.
+		map<const Connection*, Client> sessions; //By client.
+		unsigned int nextSession;
+	};
+
+	/*
+	* Connects a front's link to the server and passes it to its loop.
+	* @returns False if the server could not be reached.
+	*/
+	bool connectLink(Front* front);
+
+	/*
+	* Handles every complete frame the server sent over a link.
+	*/
+	void receive(Front* front);
+
+	/*
+	* Acknowledges the bytes a client was sent once they add up to a step.
+	*/
+	void acknowledge(Front* front, Client& client);
+
+	/*
+	* Queues a link frame, header and payload, and writes it with the rest of the pass.
+	*/
+	void sendFrame(Front* front, string&& frame);
+
+	/*
+	* Creates the event loop chosen by the "io_backend" setting, like the server's.
+	*/
+	IEventLoop* createLoop();
+
+	vector<Front*> mFronts;
+	map<IEventLoop*, Front*> mFrontsByLoop; //Filled before the reactors start, read-only after.
+	bool mSharedListener;
+	SOCKET mTlsListener; //INVALID_SOCKET without one.
+	TlsAcceptor* mTls;
+	std::atomic<unsigned int> mNextLoop;
+	string mServerAddress;
+	int mServerPort;
+	unsigned int mIdleTimeout; //Milliseconds, 0 never reaps.
+};
@@ -0,0 +1,62 @@
+#ifdef _WIN32
+#pragma comment (lib, "ws2_32.lib")
+#endif
+
+#include "WSAInitializer.h"
+#include "Gateway.h"
+#include "Config.h"
+#include <iostream>
+#include <exception>
+#include <thread>
+#include <chrono>
+#include <csignal>
+
+static volatile std::sig_atomic_t sShutdown = 0;
+
+/*
+* Requests a shutdown, a second signal kills the process.
+*/
+static void onSignal(int signal)
+{
+	std::signal(signal, SIG_DFL);
+	sShutdown = 1;
+}
+
+int main(int argc, char* argv[])
+{
+	Config* config = Config::getInstance();
+	config->load(CONFIG_FILE);
+	//Arguments in the form --key=value override config.txt, e.g. --server_address=10.0.0.5
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		size_t separator = arg.find('=');
+		if (arg.rfind("--", 0) == 0 && separator != string::npos)
+		{
+			config->set(arg.substr(2, separator - 2), arg.substr(separator + 1));
+		}
+	}
+	std::signal(SIGINT, &onSignal);
+	std::signal(SIGTERM, &onSignal);
+	try
+	{
+		WSAInitializer wsaInit;
+		Gateway gateway;
+		if (!gateway.start(config->getInt("port", PORT))) return 1;
+		std::thread reactors(&Gateway::run, &gateway);
+		while (sShutdown == 0)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(LINK_RETRY_MS));
+			gateway.reconnect();
+		}
+		gateway.stop();
+		reactors.join();
+	}
+	catch (std::exception& e)
+	{
+		std::cout << "Error occured: " << e.what() << std::endl;
+		return 1;
+	}
+	std::cout << "Gateway stopped" << std::endl;
+	return 0;
+}
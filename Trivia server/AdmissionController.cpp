@@ -0,0 +1,60 @@
+#include "AdmissionController.h"
+#include "CommunicationStructs.h"
+#include "Config.h"
+#include <algorithm>
+
+AdmissionController* AdmissionController::instancePtr = nullptr;
+
+AdmissionController* AdmissionController::getInstance()
+{
+	if (instancePtr == nullptr)
+	{
+		instancePtr = new AdmissionController();
+	}
+	return instancePtr;
+}
+
+AdmissionController::AdmissionController()
+{
+	Config* config = Config::getInstance();
+	mThresholds[GAMEPLAY_CLASS] = 0;
+	mThresholds[LOBBY_CLASS] = (unsigned int)std::max(0, config->getInt("shed_lobby_ms", DEFAULT_SHED_LOBBY_MS));
+	mThresholds[AUTH_CLASS] = (unsigned int)std::max(0, config->getInt("shed_auth_ms", DEFAULT_SHED_AUTH_MS));
+	mThresholds[STATISTICS_CLASS] = (unsigned int)std::max(0, config->getInt("shed_statistics_ms", DEFAULT_SHED_STATISTICS_MS));
+}
+
+RequestClass AdmissionController::classify(const unsigned char code)
+{
+	switch (code)
+	{
+	case CODES::LOGIN_REQUEST:
+	case CODES::SIGNUP_REQUEST:
+	case CODES::RESUME_REQUEST:
+		return AUTH_CLASS;
+	case CODES::GET_HIGH_SCORE_REQUEST:
+	case CODES::GET_PERSONAL_STATS_REQUEST:
+		return STATISTICS_CLASS;
+	case CODES::GET_PLAYERS_IN_ROOM_REQUEST:
+	case CODES::JOIN_ROOM_REQUEST:
+	case CODES::CREATE_ROOM_REQUEST:
+	case CODES::GET_ROOMS_REQUEST:
+	case CODES::START_GAME_REQUEST:
+	case CODES::GET_ROOM_STATE_REQUEST:
+		return LOBBY_CLASS;
+	default:
+		//The game itself and everything that frees state: leaving, closing, logging out.
+		return GAMEPLAY_CLASS;
+	}
+}
+
+bool AdmissionController::admit(const unsigned char code, const unsigned int loopDelay, const unsigned int workerDelay, unsigned int& retryAfter)
+{
+	RequestClass requestClass = classify(code);
+	unsigned int threshold = mThresholds[requestClass];
+	if (threshold == 0) return true;
+	unsigned int delay = requestClass == STATISTICS_CLASS ? std::max(loopDelay, workerDelay) : loopDelay;
+	if (delay <= threshold) return true;
+	// The further behind the server is, the longer the client backs off.
+	retryAfter = (unsigned int)std::min((unsigned long long)BUSY_RETRY_MAX_MS, (unsigned long long)BUSY_RETRY_MS * delay / threshold);
+	return false;
+}
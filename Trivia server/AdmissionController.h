@@ -0,0 +1,69 @@
+#pragma once
+
+#define DEFAULT_SHED_LOBBY_MS 100 // Queue delay above which lobby requests are shed ("shed_lobby_ms" setting).
+#define DEFAULT_SHED_AUTH_MS 50 // ("shed_auth_ms" setting)
+#define DEFAULT_SHED_STATISTICS_MS 20 // ("shed_statistics_ms" setting)
+#define BUSY_RETRY_MS 1000 // The retry hint of a request shed right at its threshold.
+#define BUSY_RETRY_MAX_MS 30000
+
+/*
+* The classes requests are admitted by, from the one shed last to the one shed first.
+*/
+enum RequestClass
+{
+	GAMEPLAY_CLASS, // A running game, and requests that leave a room or game or log out: never shed.
+	LOBBY_CLASS, // Room list and room membership.
+	AUTH_CLASS, // Login and signup, new sessions wait before the existing ones do.
+	STATISTICS_CLASS, // High scores and personal statistics, database reads nobody waits on.
+	REQUEST_CLASSES
+};
+
+/****
+ * @brief Sheds load by request class when the server falls behind.
+ *
+ * The loops and the worker pool measure how long work waits in them. Each class
+ * but gameplay has a queue delay threshold; a request of a class whose threshold
+ * is crossed is answered with a BUSY_RESPONSE instead of being handled, which
+ * costs no JSON parsing, lock or query. Statistics go first, then logins, then
+ * the lobby, so live games keep their share of the loops.
+ ****/
+class AdmissionController
+{
+public:
+    /****
+     * @brief Deleted copy constructor to enforce singleton pattern.
+     ****/
+    AdmissionController(const AdmissionController& obj) = delete;
+
+    /****
+     * @brief Gets the singleton instance of AdmissionController.
+     *
+     * @returns A pointer to the singleton instance of AdmissionController.
+     ****/
+    static AdmissionController* getInstance();
+
+    /****
+     * @brief Gets the class of a request code.
+     *
+     * @param code The request code.
+     * @returns The class.
+     ****/
+    static RequestClass classify(const unsigned char code);
+
+    /****
+     * @brief Decides whether a request is handled now. Safe from any thread.
+     *
+     * @param code The request code.
+     * @param loopDelay The queue delay of the loop that received the request, in milliseconds.
+     * @param workerDelay The queue delay of the worker pool, in milliseconds, it only counts for statistics.
+     * @param retryAfter Set to the milliseconds the client should wait when the request is shed.
+     * @returns False if the request is shed.
+     ****/
+    bool admit(const unsigned char code, const unsigned int loopDelay, const unsigned int workerDelay, unsigned int& retryAfter);
+
+private:
+    AdmissionController();
+
+    unsigned int mThresholds[REQUEST_CLASSES]; // Milliseconds, 0 never sheds.
+    static AdmissionController* instancePtr;
+};
@@ -0,0 +1,116 @@
+"""
+Load generator that compares the server's I/O backends.
+
+Every client signs up once and then keeps GET_ROOMS requests in flight
+(pipelined, --depth per connection). The script starts the server once per
+backend, each time in a scratch directory holding a copy of the server's
+database, so both runs see the same data and the real one never gets the
+benchmark's users.
+
+usage: python Benchmark.py --server "./Trivia server" --backends epoll uring
+"""
+import argparse
+import json
+import os
+import random
+import selectors
+import shutil
+import socket
+import struct
+import subprocess
+import tempfile
+import time
+
+SIGNUP_REQUEST = 2
+GET_ROOMS_REQUEST = 13
+HEADERS = 5
+
+
+def frame(code, body=b""):
+    return bytes([code]) + struct.pack("<I", len(body)) + body
+
+
+def signup(port):
+    sock = socket.create_connection(("127.0.0.1", port))
+    sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    user = "bench%d" % random.randint(0, 10 ** 12)
+    body = json.dumps({"username": user, "password": "Bench1!x", "email": "bench@bench.com"}).encode()
+    sock.sendall(frame(SIGNUP_REQUEST, body))
+    header = sock.recv(HEADERS, socket.MSG_WAITALL)
+    sock.recv(struct.unpack("<I", header[1:])[0], socket.MSG_WAITALL)
+    sock.setblocking(False)
+    return sock
+
+
+def run_load(port, clients, depth, seconds):
+    selector = selectors.DefaultSelector()
+    request = frame(GET_ROOMS_REQUEST)
+    state = {}
+    for _ in range(clients):
+        sock = signup(port)
+        state[sock] = {"buffer": b"", "sent": [], "latencies": []}
+        selector.register(sock, selectors.EVENT_READ)
+        for _ in range(depth):
+            state[sock]["sent"].append(time.perf_counter())
+        sock.sendall(request * depth)
+
+    done = 0
+    end = time.perf_counter() + seconds
+    while time.perf_counter() < end:
+        for key, _ in selector.select(timeout=0.1):
+            sock = key.fileobj
+            client = state[sock]
+            client["buffer"] += sock.recv(1 << 16)
+            replies = 0
+            while len(client["buffer"]) >= HEADERS:
+                length = struct.unpack("<I", client["buffer"][1:HEADERS])[0]
+                if len(client["buffer"]) < HEADERS + length:
+                    break
+                client["buffer"] = client["buffer"][HEADERS + length:]
+                client["latencies"].append(time.perf_counter() - client["sent"].pop(0))
+                replies += 1
+            if replies:
+                done += replies
+                now = time.perf_counter()
+                client["sent"].extend([now] * replies)
+                sock.sendall(request * replies)
+
+    latencies = sorted(l for client in state.values() for l in client["latencies"])
+    for sock in state:
+        sock.close()
+    if not latencies:
+        return 0, 0, 0
+    return done / seconds, latencies[len(latencies) // 2] * 1e6, latencies[int(len(latencies) * 0.99)] * 1e6
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--server", required=True, help="path of the server executable")
+    parser.add_argument("--backends", nargs="+", default=["epoll", "uring"])
+    parser.add_argument("--port", type=int, default=8175)
+    parser.add_argument("--clients", type=int, default=200)
+    parser.add_argument("--depth", type=int, default=4)
+    parser.add_argument("--seconds", type=float, default=10)
+    args = parser.parse_args()
+
+    print("%-8s %12s %12s %12s" % ("backend", "requests/s", "p50 (us)", "p99 (us)"))
+    server_dir = os.path.dirname(os.path.abspath(args.server))
+    for backend in args.backends:
+        with tempfile.TemporaryDirectory() as scratch:
+            for name in ("triviaDB.sqlite", "config.txt"):
+                if os.path.exists(os.path.join(server_dir, name)):
+                    shutil.copy(os.path.join(server_dir, name), scratch)
+            # Every client comes from one address at many times a real client's rate, the limiter would refuse them.
+            server = subprocess.Popen([os.path.abspath(args.server), "--io_backend=" + backend, "--verbose=0", "--port=%d" % args.port, "--rate_limits=0"],
+                                      stdin=subprocess.PIPE, stdout=subprocess.DEVNULL, cwd=scratch)
+            time.sleep(1)
+            try:
+                rate, p50, p99 = run_load(args.port, args.clients, args.depth, args.seconds)
+                print("%-8s %12.0f %12.0f %12.0f" % (backend, rate, p50, p99))
+            finally:
+                server.kill()
+                server.wait()
+
+
+if __name__ == "__main__":
+    main()
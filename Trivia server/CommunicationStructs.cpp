@@ -40,6 +40,23 @@ std::string get_code_string(const CODES code) {
         {CODES::GET_QUESTION_RESPONSE, "get question response"},
         {CODES::LEAVE_GAME_REQUEST, "leave game request"},
         {CODES::LEAVE_GAME_RESPONSE, "leave game response"},
+        {CODES::BATCH_REQUEST, "batch request"},
+        {CODES::BATCH_RESPONSE, "batch response"},
+        {CODES::SUBSCRIBE_REQUEST, "subscribe request"},
+        {CODES::SUBSCRIBE_RESPONSE, "subscribe response"},
+        {CODES::UNSUBSCRIBE_REQUEST, "unsubscribe request"},
+        {CODES::UNSUBSCRIBE_RESPONSE, "unsubscribe response"},
+        {CODES::ROOM_STATE_EVENT, "room state event"},
+        {CODES::ANSWER_REVEALED_EVENT, "answer revealed event"},
+        {CODES::NEXT_QUESTION_EVENT, "next question event"},
+        {CODES::GAME_OVER_EVENT, "game over event"},
+        {CODES::NOT_MODIFIED_RESPONSE, "not modified response"},
+        {CODES::PING, "ping"},
+        {CODES::PONG, "pong"},
+        {CODES::BUSY_RESPONSE, "busy response"},
+        {CODES::RATE_LIMITED_RESPONSE, "rate limited response"},
+        {CODES::RESUME_REQUEST, "resume request"},
+        {CODES::RESUME_RESPONSE, "resume response"},
     };
 
     auto it = code_map.find(code);
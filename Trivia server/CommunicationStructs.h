@@ -3,6 +3,7 @@
 #define _CRT_SECURE_NO_WARNINGS
 
 #include "Room.h"
+#include "Packet.h"
 #include <string>
 #include <ctime>
 #include <iostream>
@@ -13,6 +14,8 @@ using std::vector;
 
 #define SUCCESS 1
 #define FAILURE 0
+#define MAX_BATCH_SIZE 32
+#define NO_POLL_HINT 0 //A response that is not polled carries no "pollAfter" hint.
 
 /*
 * codes for tcp communication.
@@ -35,7 +38,17 @@ enum CODES {
 	SUBMIT_ANSWER_REQUEST, SUBMIT_ANSWER_RESPONSE,
 	GET_QUESTION_REQUEST, GET_QUESTION_RESPONSE,
 	GET_GAME_RESULT_REQUEST, GET_GAME_RESULT_RESPONSE,
-	LEAVE_GAME_REQUEST, LEAVE_GAME_RESPONSE
+	LEAVE_GAME_REQUEST, LEAVE_GAME_RESPONSE,
+	BATCH_REQUEST, BATCH_RESPONSE,
+	SUBSCRIBE_REQUEST, SUBSCRIBE_RESPONSE,
+	UNSUBSCRIBE_REQUEST, UNSUBSCRIBE_RESPONSE,
+	ROOM_STATE_EVENT,
+	ANSWER_REVEALED_EVENT, NEXT_QUESTION_EVENT, GAME_OVER_EVENT,
+	NOT_MODIFIED_RESPONSE,
+	PING, PONG,
+	BUSY_RESPONSE,
+	RATE_LIMITED_RESPONSE,
+	RESUME_REQUEST, RESUME_RESPONSE
 };
 
 /*
@@ -72,11 +85,38 @@ struct RequestInfo
 	unsigned char code;
 	std::time_t receivalTime;
 	string data;
+	bool hasRequestId; //Sent with the request ID protocol extension, may be answered out of order.
+	unsigned int requestId;
+	bool hasVersion; //Sent with the version protocol extension, a conditional read.
+	unsigned int version; //The version of the state the client already has.
 
+	RequestInfo()
+	{
+		code = 0;
+		receivalTime = 0;
+		hasRequestId = false;
+		requestId = 0;
+		hasVersion = false;
+		version = NO_VERSION;
+	}
 	RequestInfo(const char* msg, unsigned char status_code)
 	{
 		code = status_code;
 		data = string(msg);
+		hasRequestId = false;
+		requestId = 0;
+		hasVersion = false;
+		version = NO_VERSION;
+		std::time(&receivalTime);
+	}
+	RequestInfo(const string& msg, unsigned char status_code)
+	{
+		code = status_code;
+		data = msg;
+		hasRequestId = false;
+		requestId = 0;
+		hasVersion = false;
+		version = NO_VERSION;
 		std::time(&receivalTime);
 	}
 	friend std::ostream& operator<<(std::ostream& os, const RequestInfo reqInfo)
@@ -96,6 +136,7 @@ struct RequestInfo
 struct LoginResponse
 {
 	unsigned int status;
+	string resumeToken; //Presented in a RESUME_REQUEST after a dropped connection.
 };
 
 /*
@@ -104,6 +145,7 @@ struct LoginResponse
 struct SignupResponse
 {
 	unsigned int status;
+	string resumeToken; //Presented in a RESUME_REQUEST after a dropped connection.
 };
 
 /*
@@ -121,6 +163,7 @@ struct GetRoomsResponse
 {
 	unsigned int status;
 	vector<RoomData> rooms;
+	unsigned int pollAfter; //Milliseconds to wait before polling again.
 };
 
 /*
@@ -228,6 +271,7 @@ struct GetRoomStateResponse
 		answerTimeout,
 		state;
 	vector<string> players;
+	unsigned int pollAfter; //Milliseconds to wait before polling again.
 };
 
 struct LeaveGameResponse
@@ -251,6 +295,7 @@ struct SubmitAnswerResponse
 {
 	unsigned int status;
 	unsigned int correctAnswerId;
+	unsigned int pollAfter; //Milliseconds to wait before submitting again while the others answer.
 };
 
 struct PlayerResults 
@@ -276,3 +321,131 @@ struct ErrorResponse
 {
 	string message;
 };
+
+/*
+* A struct that represents a batch of requests sent in one frame.
+* The requests run in order through the current handler.
+*/
+struct BatchRequest
+{
+	vector<RequestInfo> requests;
+};
+
+/*
+* A struct that represents the responses of a batch, in the order of the requests.
+*/
+struct BatchResponse
+{
+	unsigned int status;
+	vector<Packet> responses;
+};
+
+/*
+* A struct that represents a request to (un)subscribe to pushed events.
+* topic - "room" for ROOM_STATE_EVENT, "game" for the game phase events.
+*/
+struct SubscribeRequest
+{
+	string topic;
+};
+
+/*
+* A struct that represents a response for (un)subscribing.
+*/
+struct SubscribeResponse
+{
+	unsigned int status;
+};
+
+/*
+* A struct that represents a pushed room state, sent when a room's roster or state changes.
+*/
+struct RoomStateEvent
+{
+	unsigned int roomId;
+	GetRoomStateResponse roomState;
+};
+
+/*
+* A struct that represents a pushed answer, sent once every active player answered the question.
+*/
+struct AnswerRevealedEvent
+{
+	unsigned int gameId;
+	unsigned int questionIndex;
+	unsigned int correctAnswerId;
+};
+
+/*
+* A struct that represents a pushed question, sent right after the answer of the previous one.
+*/
+struct NextQuestionEvent
+{
+	unsigned int gameId;
+	unsigned int questionIndex;
+	GetQuestionResponse question;
+};
+
+/*
+* A struct that represents the pushed results, sent once the game is finished.
+*/
+struct GameOverEvent
+{
+	unsigned int gameId;
+	GetGameResultsResponse results;
+};
+
+/*
+* A struct that represents the answer to a conditional read whose version still matches.
+* The client keeps the payload it already has, the body only carries the poll hint.
+*/
+struct NotModifiedResponse
+{
+	unsigned int pollAfter; //NO_POLL_HINT leaves the body empty.
+};
+
+/*
+* A struct that represents a BUSY_RESPONSE: the server shed the request under load
+* without handling it, the client may send it again after retryAfter milliseconds.
+*/
+struct BusyResponse
+{
+	unsigned int retryAfter;
+};
+
+/*
+* A struct that represents a RATE_LIMITED_RESPONSE: the client sent more requests of the
+* class than its budget, the request was dropped unread. A token is back after retryAfter milliseconds.
+*/
+struct RateLimitedResponse
+{
+	unsigned int retryAfter;
+};
+
+/*
+* A struct that represents a RESUME_REQUEST: a new connection takes the session of a
+* dropped one back, without logging in again.
+*/
+struct ResumeRequest
+{
+	string token; //The last token the server gave the user.
+};
+
+/*
+* A struct that represents a response for resuming a session.
+*/
+struct ResumeResponse
+{
+	unsigned int status;
+	string resumeToken; //Replaces the presented token, which is spent.
+	string username;
+	string state; //Where the user is: "menu", "room" or "game".
+};
+
+/*
+* A struct that represents a PING or a PONG. Either side may ping, the other answers with a PONG.
+* It has no body, any received bytes count as a sign of life.
+*/
+struct HeartbeatMessage
+{
+};
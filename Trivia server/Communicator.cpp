@@ -1,215 +1,990 @@
 #include "Communicator.h"
+#include "EpollEventLoop.h"
+#include "PollEventLoop.h"
+#include "UringEventLoop.h"
+#include "Config.h"
+#include "PollAdvisor.h"
+#include "AdmissionController.h"
+#include "RateLimiter.h"
+#include "JsonResponsePacketSerializer.h"
+#include "JsonRequestPacketDeserializer.h"
 #include <exception>
+#include <stdexcept>
 #include <iostream>
 #include <string>
 #include <thread>
 #include <fstream>
 #include <chrono>
+#include <cstring>
+#include <memory>
 
 
 Communicator::Communicator()
 {
 	mHandlerFactory = RequestHandlerFactory::getInstance();
-	// this server use TCP. that why SOCK_STREAM & IPPROTO_TCP
-	// if the server use UDP we will use: SOCK_DGRAM & IPPROTO_UDP
-	mServerSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	mSharedListener = false;
+	mLocalListener = INVALID_SOCKET;
+	mTlsListener = INVALID_SOCKET;
+	mTls = nullptr;
+	mGatewayListener = INVALID_SOCKET;
+	mGatewayPort = Config::getInstance()->getInt("gateway_port", 0);
+	mGatewayAddress = Config::getInstance()->getString("gateway_address", DEFAULT_GATEWAY_ADDRESS);
+	mNextLoop = 0;
+	mStopped = false;
+	mRestorePending = false;
+	mVerbose = Config::getInstance()->getInt("verbose", 1) != 0;
+	mIdleTimeout = (unsigned int)std::max(0, Config::getInstance()->getInt("idle_timeout", DEFAULT_IDLE_TIMEOUT)) * 1000;
+	mHeartbeatInterval = (unsigned int)std::max(1, Config::getInstance()->getInt("heartbeat_interval", DEFAULT_HEARTBEAT_INTERVAL)) * 1000;
+	mWorkers = new WorkerPool((unsigned int)std::max(1, Config::getInstance()->getInt("workers", DEFAULT_WORKERS)));
+	AdmissionController::getInstance(); //Reads its thresholds before the loops start.
+	RateLimiter::getInstance();
+	PollAdvisor::getInstance(); //Every reactor thread counts its requests there.
 
-	if (mServerSocket == INVALID_SOCKET)
-		throw std::exception(__FUNCTION__ " - socket");
+	NotificationCenter::getInstance()->setListener(this);
+	mHandlerFactory->getSessionManager()->setCloser([this](IRequestHandler* handler)
+		{
+			handler = unpark(handler);
+			closeSafe(handler);
+			delete handler;
+		});
 
-	//Creates a thread that removes fnished games and rooms.
-	GameManager::getInstance()->startRemoveFinishedGames().detach(); 
+	//Creates a thread that removes fnished games and rooms, under the lock of the handlers.
+	mReaper = GameManager::getInstance()->startRemoveFinishedGames(mHandlersLock);
 
 }
 
 Communicator::~Communicator()
 {
-	try
+	stopReaper();
+	// Workers post their results to the loops, so they go first.
+	delete mWorkers;
+	for (Reactor* reactor : mReactors)
 	{
-		// the only use of the destructor should be for freeing 
-		// resources that was allocated in the constructor
-		closesocket(mServerSocket);
+		reactor->getLoop()->stop();
 	}
-	catch (...) {}
-	for (auto& it : mClients)
+	for (Reactor* reactor : mReactors)
 	{
-		delete it.second;
-		it.second = nullptr;
+		delete reactor;
 	}
-	mClients.erase(mClients.begin(), mClients.end());
+	mReactors.clear();
+	for (GatewayLink* link : mGatewayLinks)
+	{
+		delete link;
+	}
+	mGatewayLinks.clear();
 }
 
 void Communicator::startHandleRequests(const int port)
 {
+	Config* config = Config::getInstance();
+	unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+	unsigned int count = (unsigned int)std::max(1, config->getInt("reactors", (int)cores));
+	bool pin = config->getInt("pin_reactors", 0) != 0;
+	int tlsPort = config->getInt("tls_port", 0);
+	mSharedListener = count > 1 && !Socket::supportsReusePort();
 
-	struct sockaddr_in sa = { 0 };
+	{
+		std::lock_guard<mutex> lock(mHandlersLock);
+		if (mStopped) return;
+		vector<SOCKET> inherited;
+		for (SOCKET listener : mInheritedListeners)
+		{
+			int listenerPort = Socket::getLocalPort(listener);
+			if (Socket::isLocal(listener)) mLocalListener = listener;
+			else if (listenerPort == port) inherited.push_back(listener);
+			else if (tlsPort != 0 && listenerPort == tlsPort) mTlsListener = listener;
+			else if (mGatewayPort != 0 && listenerPort == mGatewayPort) mGatewayListener = listener;
+			else Socket::closeSocket(listener); //The settings of the new process do not use it.
+		}
+		if (!inherited.empty()) mSharedListener = inherited.size() < count;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			Reactor* reactor = new Reactor(createLoop(), pin ? (int)(i % cores) : NO_CORE);
+			mReactors.push_back(reactor);
+			if (inherited.empty() && (i == 0 || !mSharedListener))
+			{
+				reactor->listen(Socket::createListener(port, !mSharedListener && count > 1));
+			}
+		}
+		for (size_t i = 0; i < inherited.size(); i++)
+		{
+			mReactors[i % count]->listen(inherited[i]);
+		}
+		string localSocket = config->getString("local_socket", "");
+		if (mLocalListener == INVALID_SOCKET && !localSocket.empty())
+		{
+			mLocalListener = Socket::createLocalListener(localSocket, true);
+			if (mLocalListener == INVALID_SOCKET) std::cout << "Could not listen on " << localSocket << std::endl;
+			else std::cout << "Listening on " << localSocket << std::endl;
+		}
+		//A path cannot be bound twice, so one listener feeds every reactor.
+		if (mLocalListener != INVALID_SOCKET) mReactors[0]->listen(mLocalListener);
+		if (tlsPort != 0)
+		{
+			try
+			{
+				if (mTlsListener == INVALID_SOCKET) mTlsListener = Socket::createListener(tlsPort);
+				mTls = new TlsAcceptor(config->getString("tls_certificate", ""), config->getString("tls_private_key", ""),
+					[this](SOCKET client, TlsSession* tls) { mReactors[mNextLoop++ % mReactors.size()]->getLoop()->adopt(client, tls); });
+				//Handshakes do not run on the reactors, so one listener is enough.
+				mReactors[0]->listen(mTlsListener);
+				std::cout << "Listening for TLS on port " << tlsPort << std::endl;
+			}
+			catch (const std::runtime_error& e)
+			{
+				std::cout << "No TLS: " << e.what() << std::endl;
+				if (mTlsListener != INVALID_SOCKET) Socket::closeSocket(mTlsListener);
+				mTlsListener = INVALID_SOCKET;
+			}
+		}
+		if (mGatewayPort != 0)
+		{
+			try
+			{
+				if (mGatewayListener == INVALID_SOCKET) mGatewayListener = Socket::createListener(mGatewayPort, false, mGatewayAddress);
+				//A few long-lived links, one listener is enough.
+				mReactors[0]->listen(mGatewayListener);
+				std::cout << "Listening for gateways on " << mGatewayAddress << ":" << mGatewayPort << std::endl;
+			}
+			catch (const std::runtime_error& e)
+			{
+				std::cout << "No gateways: " << e.what() << std::endl;
+				mGatewayListener = INVALID_SOCKET;
+			}
+		}
+		//Clients taken over are spread over the reactors like new ones, onOpen restores them.
+		for (auto& it : mRestoring)
+		{
+			mReactors[mNextLoop++ % count]->getLoop()->adopt(it.first);
+		}
+	}
+	std::cout << "Listening on port " << port << " with " << count << " reactors" << std::endl;
 
-	sa.sin_port = htons(port); // port that server will listen for
-	sa.sin_family = AF_INET;   // must be AF_INET
-	sa.sin_addr.s_addr = INADDR_ANY;    // when there are few ip's for the machine. We will use always "INADDR_ANY"
+	for (unsigned int i = 1; i < count; i++)
+	{
+		mReactors[i]->start();
+	}
+	std::cout << "Waiting for client connection request" << std::endl;
+	mReactors[0]->run();
+	//Handshakes that finish now would go to loops that are stopping.
+	delete mTls;
+	mTls = nullptr;
+	for (unsigned int i = 1; i < count; i++)
+	{
+		mReactors[i]->stop();
+	}
+}
 
-	// Connects between the socket and the configuration (port and etc..)
-	if (bind(mServerSocket, (struct sockaddr*)&sa, sizeof(sa)) == SOCKET_ERROR)
-		throw std::exception(__FUNCTION__ " - bind");
+void Communicator::drain(const unsigned int timeoutMs)
+{
+	GameManager* gameManager = mHandlerFactory->getGameManager();
+	{
+		std::lock_guard<mutex> lock(mHandlersLock);
+		if (mStopped) return;
+		for (Reactor* reactor : mReactors)
+		{
+			reactor->getLoop()->stopAccepting();
+		}
+		mHandlerFactory->getRoomManager()->setDraining();
+	}
+	//No game is removed from here on, the drain reads and ends them.
+	stopReaper();
+	std::cout << "Draining: waiting up to " << timeoutMs / 1000 << " seconds for the running games" << std::endl;
 
-	// Start listening for incoming requests of clients
-	if (listen(mServerSocket, SOMAXCONN) == SOCKET_ERROR)
-		throw std::exception(__FUNCTION__ " - listen");
-	std::cout << "Listening on port " << port << std::endl;
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
 	while (true)
 	{
-		// the main thread is only accepting clients 
-		// and add then to the list of handlers
-		std::cout << "Waiting for client connection request" << std::endl;
-		bindAndListen();
+		{
+			std::lock_guard<mutex> lock(mHandlersLock);
+			//A parked player holds its game up until its grace period ends.
+			mHandlerFactory->getSessionManager()->expire();
+			if (!gameManager->hasRunningGames()) break;
+		}
+		if (std::chrono::steady_clock::now() >= deadline)
+		{
+			std::cout << "Drain timed out, ending the running games" << std::endl;
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_POLL_MS));
+	}
+
+	std::lock_guard<mutex> lock(mHandlersLock);
+	gameManager->submitUnfinishedGames();
+	mStopped = true;
+	mHandlerFactory->getSessionManager()->expire(true);
+	//The first reactor runs on the thread of startHandleRequests, which stops the others once it returns.
+	if (!mReactors.empty())
+	{
+		mReactors[0]->getLoop()->stop();
+	}
+}
+
+void Communicator::beginHandOff()
+{
+	//The games go to the new process as they are.
+	stopReaper();
+	std::lock_guard<mutex> lock(mHandlersLock);
+	if (mStopped) return;
+	mStopped = true;
+	//Parked sessions have no connection to hand over, their users are logged out.
+	mHandlerFactory->getSessionManager()->expire(true);
+	//The first reactor goes last: once it returns, startHandleRequests stops the others.
+	for (size_t i = mReactors.size(); i > 0; i--)
+	{
+		mReactors[i - 1]->getLoop()->handOff();
+	}
+}
+
+bool Communicator::handOff(SOCKET channel)
+{
+	vector<SOCKET> listeners;
+	vector<std::shared_ptr<Connection>> connections;
+	for (Reactor* reactor : mReactors)
+	{
+		reactor->getLoop()->release(listeners, connections);
+	}
+	vector<SOCKET> sockets;
+	for (const std::shared_ptr<Connection>& connection : connections)
+	{
+		sockets.push_back(connection->getSocket());
+	}
+	sockets.insert(sockets.end(), listeners.begin(), listeners.end());
+
+	string snapshot;
+	{
+		std::lock_guard<mutex> lock(mHandlersLock);
+		snapshot = Snapshot::save(connections);
+	}
+	std::cout << "Handing " << connections.size() << " clients over (" << snapshot.size() << " bytes of state)" << std::endl;
+	bool tookOver = Snapshot::send(channel, snapshot, sockets);
+	if (!tookOver)
+	{
+		std::cout << "The new process did not take over, closing the clients" << std::endl;
+	}
+
+	//The new process holds its own copies of the sockets, closing these does not end the connections.
+	for (const std::shared_ptr<Connection>& connection : connections)
+	{
+		if (!tookOver) onClose(*connection);
+		Socket::closeSocket(connection->getSocket());
+	}
+	for (SOCKET listener : listeners)
+	{
+		Socket::closeSocket(listener);
+	}
+	if (!tookOver)
+	{
+		std::lock_guard<mutex> lock(mHandlersLock);
+		mHandlerFactory->getGameManager()->submitUnfinishedGames();
+	}
+	return tookOver;
+}
+
+bool Communicator::takeOver(SOCKET channel)
+{
+	string snapshot;
+	vector<SOCKET> sockets;
+	vector<nlohmann::json> states;
+	bool restored = Snapshot::receive(channel, snapshot, sockets);
+	if (restored)
+	{
+		try
+		{
+			states = Snapshot::restore(snapshot, sockets.size());
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "Could not restore the state of the old process: " << e.what() << std::endl;
+			restored = false;
+		}
+	}
+	if (!restored)
+	{
+		for (SOCKET socket : sockets)
+		{
+			Socket::closeSocket(socket);
+		}
+		//The old process closes its listeners and clients before it goes away, then the port is free.
+		char ignored;
+		Socket::receiveAll(channel, &ignored, 1);
+		return false;
 	}
+
+	{
+		std::lock_guard<mutex> lock(mHandlersLock);
+		for (size_t i = 0; i < states.size(); i++)
+		{
+			mRestoring[sockets[i]] = states[i];
+		}
+		mRestorePending = !mRestoring.empty();
+		mInheritedListeners.assign(sockets.begin() + states.size(), sockets.end());
+	}
+	Snapshot::acknowledge(channel);
+	std::cout << "Took " << states.size() << " clients over from the old process" << std::endl;
+	return true;
 }
 
+void Communicator::stopReaper()
+{
+	mHandlerFactory->getGameManager()->stopRemovingFinishedGames();
+	if (mReaper.joinable()) mReaper.join();
+}
 
-void Communicator::bindAndListen()
+void Communicator::expireSessions()
 {
+	std::lock_guard<mutex> lock(mHandlersLock);
+	mHandlerFactory->getSessionManager()->expire();
+}
 
-	// this accepts the client and create a specific socket from server to this client
-	// the process will not continue until a client connects to the server
-	SOCKET client_socket = accept(mServerSocket, NULL, NULL);
-	if (client_socket == INVALID_SOCKET)
-		throw std::exception(__FUNCTION__);
+void Communicator::onAccept(IEventLoop& loop, SOCKET listener, SOCKET client)
+{
+	if (mVerbose) std::cout << "Client accepted. Server and client can speak" << std::endl;
+	if (listener == mTlsListener)
+	{
+		mTls->handshake(client);
+		return;
+	}
+	if (mSharedListener || listener == mLocalListener || listener == mGatewayListener)
+	{
+		mReactors[mNextLoop++ % mReactors.size()]->getLoop()->adopt(client);
+		return;
+	}
+	loop.adopt(client);
+}
 
-	std::cout << "Client accepted. Server and client can speak" << std::endl;
-	// the function that handle the conversation with the client
-	thread(&Communicator::handleNewClient, this, client_socket).detach();
+void Communicator::onOpen(Connection& connection)
+{
+	//Sessions of a link share its socket, only a connection of a real loop can be a link.
+	if (mGatewayListener != INVALID_SOCKET && dynamic_cast<GatewayLink*>(connection.getLoop()) == nullptr &&
+		Socket::getLocalPort(connection.getSocket()) == mGatewayPort)
+	{
+		GatewayLink* link = new GatewayLink(this, connection);
+		connection.setLink(link);
+		//A link carries thousands of clients: it is never reaped, paused or evicted.
+		connection.setIdleTimeout(0);
+		connection.setOutboundLimit(0);
+		std::lock_guard<mutex> lock(mHandlersLock);
+		mGatewayLinks.push_back(link);
+		std::cout << "Gateway connected on socket " << connection.getSocket() << std::endl;
+		return;
+	}
+	connection.setIdleTimeout(mIdleTimeout);
+	connection.setLimits(RateLimiter::getInstance()->open(connection.getLoop()->getPeerAddress(connection)));
+	if (mRestorePending)
+	{
+		std::lock_guard<mutex> lock(mHandlersLock);
+		auto restoring = mRestoring.find(connection.getSocket());
+		if (restoring != mRestoring.end())
+		{
+			Snapshot::restoreConnection(connection, restoring->second);
+			mRestoring.erase(restoring);
+			mRestorePending = !mRestoring.empty();
+			return;
+		}
+	}
+	connection.setHandler(mHandlerFactory->createLoginRequestHandler());
+	//Currently user isn't signed in.
+	connection.setUsername(NO_USER);
 }
 
+void Communicator::onData(Connection& connection)
+{
+	// One request per loop thread, its data buffer is reused by every frame.
+	static thread_local RequestInfo reqInfo;
+	if (connection.getLink() != nullptr)
+	{
+		if (!connection.getLink()->receive()) connection.getLoop()->close(connection);
+		return;
+	}
+	FrameParser::Result result;
+	while (!connection.isClosed() && !connection.isBackedUp() && !connection.isAwaiting() && (result = FrameParser::next(connection.getInbound(), reqInfo, connection.getLimits())) != FrameParser::INCOMPLETE)
+	{
+		if (result == FrameParser::OVERSIZED)
+		{
+			connection.getLoop()->close(connection);
+			return;
+		}
+		if (result == FrameParser::RATE_LIMITED)
+		{
+			answerRateLimited(connection, reqInfo);
+			continue;
+		}
+		handleRequest(connection, reqInfo);
+	}
+}
+
+void Communicator::onClose(Connection& connection)
+{
+	if (connection.getLink() != nullptr)
+	{
+		std::cout << "Gateway on socket " << connection.getSocket() << " disconnected" << std::endl;
+		//Its sessions lock on their own.
+		connection.getLink()->closeAll();
+		connection.setLink(nullptr);
+		return;
+	}
+	std::lock_guard<mutex> lock(mHandlersLock);
+	string username = connection.getUsername();
+	SessionManager* sessions = mHandlerFactory->getSessionManager();
+	if (username != NO_USER) NotificationCenter::getInstance()->unregisterUser(username);
+	//The user keeps its place for the grace period, a RESUME_REQUEST takes the handler back.
+	if (username == NO_USER || mStopped || !sessions->park(username, connection.getHandler()))
+	{
+		if (username != NO_USER) sessions->revoke(username);
+		closeSafe(connection.getHandler());
+		delete connection.getHandler();
+	}
+	connection.setHandler(nullptr);
+	delete connection.getLimits();
+	connection.setLimits(nullptr);
+}
 
-void Communicator::handleNewClient(SOCKET clientSocket)
+void Communicator::handleRequest(Connection& connection, const RequestInfo& reqInfo)
 {
-	//Initialize new user at beggining of state machine.
-	mClients[clientSocket] = mHandlerFactory->createLoginRequestHandler();
-	char data[HEADERS] = { 0 };
-	//Currently user isn't signed in. 
-	mUsernames[clientSocket] = NO_USER;
-	bool loginTry = false;
+	if (mVerbose)
+	{
+		std::cout << "receiving from " << connection.describe() << std::endl;
+		std::cout << reqInfo;
+	}
+
+	if (reqInfo.code == CODES::BATCH_REQUEST)
+	{
+		handleBatch(connection, reqInfo);
+		return;
+	}
+	if (reqInfo.code == CODES::SUBSCRIBE_REQUEST || reqInfo.code == CODES::UNSUBSCRIBE_REQUEST)
+	{
+		handleSubscribe(connection, reqInfo);
+		return;
+	}
+	if (reqInfo.code == CODES::PING || reqInfo.code == CODES::PONG)
+	{
+		handleHeartbeat(connection, reqInfo);
+		return;
+	}
+	if (reqInfo.code == CODES::RESUME_REQUEST)
+	{
+		handleResume(connection, reqInfo);
+		return;
+	}
+	if (!connection.getHandler()->isRequestRelevant(reqInfo))
+	{
+		//Request is not relevant.
+		connection.getLoop()->close(connection);
+		return;
+	}
+	BusyResponse busy;
+	if (!admit(connection, reqInfo, busy))
+	{
+		Packet packet = JsonResponsePacketSerializer::serializeResponse(busy);
+		if (reqInfo.hasRequestId) packet.setRequestId(reqInfo.requestId);
+		if (mVerbose) logPacket(connection, packet);
+		connection.queue(std::move(packet));
+		return;
+	}
+	PollAdvisor::getInstance()->onRequest();
+	unsigned int version = NO_VERSION;
+	if (reqInfo.hasVersion && answerNotModified(connection, reqInfo, version)) return;
+	if (reqInfo.hasRequestId && isIndependent(connection, reqInfo))
+	{
+		dispatch(connection, reqInfo, version);
+		return;
+	}
 	try
 	{
-		while(true)
-		{
-			recieve(clientSocket, data, HEADERS);
-			//Extarct data from received message.
-			unsigned char code = data[CODE_INDEX];
-			loginTry = code == CODES::LOGIN_REQUEST;
-			int* len = (int*)&(data[LEN_INDEX]);
-			char* msg = new char[*len + 1];
-			if(*len > 0) recieve(clientSocket, msg, *len);
-			msg[*len] = 0;
-			RequestInfo reqInfo(msg, code);
-			std::cout << "receiving from " 
-				<< ((mUsernames[clientSocket] == NO_USER) ? "socket " + std::to_string(clientSocket) : "user \"" + mUsernames[clientSocket] + "\"")
-				<< std::endl;
-			std::cout << reqInfo;
-			delete[] msg;
-
-			if (mClients[clientSocket]->isRequestRelevant(reqInfo))
+		IRequestHandler* handler = connection.getHandler();
+		Task<RequestResult> task;
+		{
+			std::lock_guard<mutex> lock(mHandlersLock);
+			task = handler->handleRequest(reqInfo);
+		}
+		if (!task.isReady())
+		{
+			// A coroutine: step() runs it, the next requests wait until it finished.
+			connection.getLoop()->setAwaiting(connection, true);
+			step(std::make_shared<PendingRequest>(this, connection, handler, reqInfo, version, std::move(task)), nullptr);
+			return;
+		}
+		RequestResult reqResult = task.get();
+		advance(connection, handler, reqResult, reqInfo.code);
+		respond(connection, reqResult.buffer, reqInfo, version);
+	}
+	catch (const std::exception& e)
+	{
+		connection.getLoop()->close(connection);
+	}
+}
+
+struct Communicator::PendingRequest : public RequestContext, public std::enable_shared_from_this<PendingRequest>
+{
+	PendingRequest(Communicator* communicator, Connection& connection, IRequestHandler* handler, const RequestInfo& reqInfo, const unsigned int version, Task<RequestResult> task)
+		: communicator(communicator), connection(connection.shared_from_this()), loop(connection.getLoop()), handler(handler), version(version), task(std::move(task))
+	{
+		info.code = reqInfo.code;
+		info.hasRequestId = reqInfo.hasRequestId;
+		info.requestId = reqInfo.requestId;
+	}
+
+	virtual void offload(std::function<void()> work, std::coroutine_handle<> next) override
+	{
+		std::shared_ptr<PendingRequest> self = shared_from_this();
+		communicator->mWorkers->submit([self, work, next]()
 			{
-				try
-				{
-					RequestResult reqResult = mClients[clientSocket]->handleRequest(reqInfo);
-					//Free memory if there is new state.
-					if(reqResult.nextHandler != mClients[clientSocket])
+				work();
+				self->loop->post([self, next]()
 					{
-						delete(mClients[clientSocket]);
-						mClients[clientSocket] = reqResult.nextHandler;
-					}
-					if (loginTry)
-					{
-						MenuRequestHandler* temp;
-						if ((temp = dynamic_cast<MenuRequestHandler*>(mClients[clientSocket])) != nullptr)
-						{
-							mUsernames[clientSocket] = temp->getUsername();
-						}
-					}
-					//Is logged out.
-					if (dynamic_cast<LoginRequestHandler*>(mClients[clientSocket]) != nullptr)
-					{
-						mUsernames[clientSocket] = NO_USER;
-					}
-					sendPacket(clientSocket, reqResult.buffer.c_str(), reqResult.buffer.size());
-				}
-				catch (std::exception e)
-				{
-					throw std::runtime_error("Error sending data!");
-				}
+						self->communicator->step(self, next);
+					});
+			});
+	}
+
+	Communicator* communicator;
+	std::weak_ptr<Connection> connection;
+	IEventLoop* loop;
+	IRequestHandler* handler; //The handler the request was passed to.
+	RequestInfo info; //The request without its data, for the response.
+	unsigned int version;
+	Task<RequestResult> task;
+};
+
+void Communicator::step(const std::shared_ptr<PendingRequest>& request, std::coroutine_handle<> next)
+{
+	std::shared_ptr<Connection> connection = request->connection.lock();
+	// Dropping the request of a closed connection destroys the coroutine where it waits.
+	if (connection == nullptr || connection->isClosed()) return;
+	RequestResult reqResult;
+	try
+	{
+		{
+			std::lock_guard<mutex> lock(mHandlersLock);
+			RequestContext::Scope scope(request.get());
+			if (next) next.resume();
+			else request->task.start();
+			if (!request->task.isReady()) return; //Suspended again, offload() resumes it.
+		}
+		reqResult = request->task.get();
+	}
+	catch (const std::exception& e)
+	{
+		connection->getLoop()->close(*connection);
+		return;
+	}
+	advance(*connection, request->handler, reqResult, request->info.code);
+	respond(*connection, reqResult.buffer, request->info, request->version);
+	connection->getLoop()->setAwaiting(*connection, false);
+	if (!next) return; //Finished without suspending, onData goes on with the next request.
+	// Resumed from the loop: the requests that arrived meanwhile, then the responses.
+	onData(*connection);
+	if (!connection->isClosed()) connection->getLoop()->cork(*connection);
+}
+
+void Communicator::respond(Connection& connection, Packet& packet, const RequestInfo& reqInfo, const unsigned int version)
+{
+	if (reqInfo.hasRequestId) packet.setRequestId(reqInfo.requestId);
+	if (version != NO_VERSION) packet.setVersion(version);
+	if (mVerbose) logPacket(connection, packet);
+	connection.queue(std::move(packet));
+}
+
+void Communicator::handleBatch(Connection& connection, const RequestInfo& reqInfo)
+{
+	BatchRequest batch;
+	try
+	{
+		batch = JsonRequestPacketDeserializer::deserializeBatchRequest(reqInfo);
+	}
+	catch (const std::exception& e)
+	{
+		connection.getLoop()->close(connection);
+		return;
+	}
+	if (batch.requests.size() > MAX_BATCH_SIZE)
+	{
+		connection.getLoop()->close(connection);
+		return;
+	}
+
+	BatchResponse response;
+	response.status = SUCCESS;
+	for (const RequestInfo& request : batch.requests)
+	{
+		// A bad sub-request gets an error response in its slot, the rest of the batch still runs.
+		ErrorResponse error;
+		if (request.code == CODES::BATCH_REQUEST || !connection.getHandler()->isRequestRelevant(request))
+		{
+			error.message = "Request is not relevant";
+			response.responses.push_back(JsonResponsePacketSerializer::serializeResponse(error));
+			continue;
+		}
+		if (!RateLimiter::getInstance()->take(connection.getLimits(), request.code))
+		{
+			RateLimitedResponse limited;
+			limited.retryAfter = connection.getLimits()->retryAfter;
+			response.responses.push_back(JsonResponsePacketSerializer::serializeResponse(limited));
+			continue;
+		}
+		BusyResponse busy;
+		if (!admit(connection, request, busy))
+		{
+			response.responses.push_back(JsonResponsePacketSerializer::serializeResponse(busy));
+			continue;
+		}
+		try
+		{
+			response.responses.push_back(std::move(run(connection, request).buffer));
+		}
+		catch (const std::exception& e)
+		{
+			error.message = e.what();
+			response.responses.push_back(JsonResponsePacketSerializer::serializeResponse(error));
+		}
+	}
+	Packet packet = JsonResponsePacketSerializer::serializeResponse(response);
+	if (reqInfo.hasRequestId) packet.setRequestId(reqInfo.requestId);
+	if (mVerbose) logPacket(connection, packet);
+	connection.queue(std::move(packet));
+}
+
+RequestResult Communicator::run(Connection& connection, const RequestInfo& reqInfo)
+{
+	IRequestHandler* handler = connection.getHandler();
+	RequestResult reqResult;
+	{
+		std::lock_guard<mutex> lock(mHandlersLock);
+		reqResult = handler->handleRequest(reqInfo).get();
+	}
+	advance(connection, handler, reqResult, reqInfo.code);
+	return reqResult;
+}
+
+void Communicator::advance(Connection& connection, IRequestHandler* handler, const RequestResult& reqResult, const unsigned char code)
+{
+	//Deleting a handler releases its game and logging out revokes the session, both shared with the other reactors.
+	std::lock_guard<mutex> lock(mHandlersLock);
+	//Free memory if there is new state.
+	if (reqResult.nextHandler != nullptr && reqResult.nextHandler != handler)
+	{
+		delete handler;
+		connection.setHandler(reqResult.nextHandler);
+	}
+	if (code == CODES::LOGIN_REQUEST || code == CODES::SIGNUP_REQUEST)
+	{
+		MenuRequestHandler* temp;
+		if ((temp = dynamic_cast<MenuRequestHandler*>(connection.getHandler())) != nullptr)
+		{
+			connection.setUsername(temp->getUsername());
+			NotificationCenter::getInstance()->registerUser(temp->getUsername(), connection.shared_from_this());
+		}
+	}
+	//Is logged out.
+	if (dynamic_cast<LoginRequestHandler*>(connection.getHandler()) != nullptr && connection.getUsername() != NO_USER)
+	{
+		NotificationCenter::getInstance()->unregisterUser(connection.getUsername());
+		mHandlerFactory->getSessionManager()->revoke(connection.getUsername());
+		connection.setUsername(NO_USER);
+	}
+}
+
+void Communicator::handleSubscribe(Connection& connection, const RequestInfo& reqInfo)
+{
+	bool subscribe = reqInfo.code == CODES::SUBSCRIBE_REQUEST;
+	SubscribeResponse response;
+	response.status = FAILURE;
+	try
+	{
+		SubscribeRequest request = JsonRequestPacketDeserializer::deserializeSubscribeRequest(reqInfo);
+		Topic topic = request.topic == "room" ? ROOM_STATE_TOPIC : GAME_TOPIC;
+		if ((request.topic == "room" || request.topic == "game") && connection.getUsername() != NO_USER)
+		{
+			NotificationCenter* center = NotificationCenter::getInstance();
+			if (subscribe)
+			{
+				response.status = center->subscribe(connection.getUsername(), topic) ? SUCCESS : FAILURE;
 			}
 			else
 			{
- 				throw std::runtime_error("Request is not relevant!");
+				center->unsubscribe(connection.getUsername(), topic);
+				response.status = SUCCESS;
 			}
 		}
-		// Closing the socket (in the level of the TCP protocol)
-		closesocket(clientSocket);
-		mClients.erase(clientSocket);
-		closeSafe(mClients[clientSocket]);
 	}
 	catch (const std::exception& e)
 	{
-		closesocket(clientSocket);
-		closeSafe(mClients[clientSocket]);
-		mClients.erase(clientSocket);
+		connection.getLoop()->close(connection);
+		return;
+	}
+	Packet packet = JsonResponsePacketSerializer::serializeResponse(response, subscribe ? CODES::SUBSCRIBE_RESPONSE : CODES::UNSUBSCRIBE_RESPONSE);
+	if (reqInfo.hasRequestId) packet.setRequestId(reqInfo.requestId);
+	if (mVerbose) logPacket(connection, packet);
+	connection.queue(std::move(packet));
+}
+
+void Communicator::handleResume(Connection& connection, const RequestInfo& reqInfo)
+{
+	ResumeRequest request;
+	try
+	{
+		request = JsonRequestPacketDeserializer::deserializeResumeRequest(reqInfo);
+	}
+	catch (const std::exception& e)
+	{
+		connection.getLoop()->close(connection);
+		return;
 	}
+	if (dynamic_cast<LoginRequestHandler*>(connection.getHandler()) == nullptr)
+	{
+		connection.getLoop()->close(connection);
+		return;
+	}
+	ResumeResponse response;
+	response.status = FAILURE;
+	string username;
+	std::shared_ptr<Connection> previous;
+	{
+		std::lock_guard<mutex> lock(mHandlersLock);
+		if (!resume(connection, request.token, response, username) && !username.empty())
+		{
+			previous = NotificationCenter::getInstance()->getConnection(username);
+		}
+	}
+	if (previous == nullptr)
+	{
+		Packet packet = JsonResponsePacketSerializer::serializeResponse(response);
+		respond(connection, packet, reqInfo, NO_VERSION);
+		return;
+	}
+
+	// Closing the previous connection on its own loop parks its session, then this loop takes it.
+	// Reading stops meanwhile, the requests after this one wait in the inbound buffer.
+	connection.getLoop()->setAwaiting(connection, true);
+	std::weak_ptr<Connection> weak = connection.shared_from_this();
+	IEventLoop* loop = connection.getLoop();
+	RequestInfo info;
+	info.code = reqInfo.code;
+	info.hasRequestId = reqInfo.hasRequestId;
+	info.requestId = reqInfo.requestId;
+	string token = request.token;
+	previous->getLoop()->post([this, previous, weak, loop, info, token]()
+		{
+			previous->getLoop()->close(*previous);
+			loop->post([this, weak, info, token]()
+				{
+					std::shared_ptr<Connection> connection = weak.lock();
+					if (connection == nullptr || connection->isClosed()) return;
+					ResumeResponse response;
+					response.status = FAILURE;
+					string username;
+					{
+						std::lock_guard<mutex> lock(mHandlersLock);
+						resume(*connection, token, response, username);
+					}
+					Packet packet = JsonResponsePacketSerializer::serializeResponse(response);
+					respond(*connection, packet, info, NO_VERSION);
+					connection->getLoop()->setAwaiting(*connection, false);
+					onData(*connection);
+					if (!connection->isClosed()) connection->getLoop()->cork(*connection);
+				});
+		});
+}
 
+bool Communicator::resume(Connection& connection, const string& token, ResumeResponse& response, string& username)
+{
+	SessionManager* sessions = mHandlerFactory->getSessionManager();
+	IRequestHandler* handler = sessions->resume(token, username);
+	if (handler == nullptr) return false;
+	handler = unpark(handler);
+	delete connection.getHandler();
+	connection.setHandler(handler);
+	connection.setUsername(username);
+	//Subscriptions are not kept, the client subscribes again.
+	NotificationCenter::getInstance()->registerUser(username, connection.shared_from_this());
+	response.status = SUCCESS;
+	response.resumeToken = sessions->issue(username);
+	response.username = username;
+	if (dynamic_cast<GameRequestHandler*>(handler) != nullptr) response.state = "game";
+	else if (dynamic_cast<MenuRequestHandler*>(handler) != nullptr) response.state = "menu";
+	else response.state = "room";
+	return true;
+}
 
+IRequestHandler* Communicator::unpark(IRequestHandler* handler)
+{
+	RoomMemberRequestHandler* member = dynamic_cast<RoomMemberRequestHandler*>(handler);
+	if (member == nullptr) return handler;
+	IRequestHandler* next = member->rejoin();
+	if (next != member) delete member;
+	return next;
 }
 
-void Communicator::recieve(SOCKET socket, char* data, const int len) const
+void Communicator::onNotify(Connection& connection, const Notification& notification)
 {
-	int res = recv(socket, data, len, FLAGS);
-	if (res == INVALID_SOCKET)
+	std::lock_guard<mutex> lock(mHandlersLock);
+	if (notification.topic == GAME_TOPIC)
 	{
-		std::string s = "Error while recieving from socket: ";
-		s += std::to_string(socket);
-		throw std::exception(s.c_str());
+		GameRequestHandler* player = dynamic_cast<GameRequestHandler*>(connection.getHandler());
+		//The player may have left the game since the event was published.
+		if (player == nullptr || player->getGameId() != notification.gameId) return;
+		IRequestHandler* next = player->applyPhase(notification.packet->code());
+		if (next != player)
+		{
+			delete player;
+			connection.setHandler(next);
+		}
+		return;
 	}
+	RoomMemberRequestHandler* member = dynamic_cast<RoomMemberRequestHandler*>(connection.getHandler());
+	if (member == nullptr || notification.room.state == RoomState::OPENED) return;
+	//The member may have moved to another room since the state was published.
+	if (notification.room.id != member->getRoomId()) return;
+	RoomData room = notification.room;
+	IRequestHandler* next = member->applyRoomState(room);
+	if (next != nullptr && next != member)
+	{
+		delete member;
+		connection.setHandler(next);
+	}
+}
 
+void Communicator::handleHeartbeat(Connection& connection, const RequestInfo& reqInfo)
+{
+	if (!connection.usesHeartbeat())
+	{
+		connection.setUsesHeartbeat(true);
+		connection.setIdleTimeout(mHeartbeatInterval);
+	}
+	if (reqInfo.code == CODES::PONG) return; //Receiving it already restarted the idle deadline.
+	Packet packet = JsonResponsePacketSerializer::serializeResponse(HeartbeatMessage(), CODES::PONG);
+	if (reqInfo.hasRequestId) packet.setRequestId(reqInfo.requestId);
+	if (mVerbose) logPacket(connection, packet);
+	connection.queue(std::move(packet));
 }
 
-void Communicator::sendPacket(SOCKET socket, const char* data, const int len) const
+bool Communicator::onIdle(Connection& connection)
 {
-	std::cout << "\nSent " << std::to_string(len) << " bytes to " 
-		<< ((mUsernames.at(socket) == NO_USER) ? "socket " + std::to_string(socket) : "user \"" + mUsernames.at(socket) + "\"")
-		<< std::endl;
+	if (connection.usesHeartbeat() && connection.getIdleStrikes() == 0)
+	{
+		Packet packet = JsonResponsePacketSerializer::serializeResponse(HeartbeatMessage(), CODES::PING);
+		if (mVerbose) logPacket(connection, packet);
+		connection.queue(std::move(packet));
+		return true;
+	}
+	if (mVerbose) std::cout << "reaping idle " << connection.describe() << std::endl;
+	return false;
+}
+
+void Communicator::answerRateLimited(Connection& connection, const RequestInfo& reqInfo)
+{
+	RateLimitedResponse response;
+	response.retryAfter = connection.getLimits()->retryAfter;
+	Packet packet = JsonResponsePacketSerializer::serializeResponse(response);
+	if (reqInfo.hasRequestId) packet.setRequestId(reqInfo.requestId);
+	if (mVerbose) logPacket(connection, packet);
+	connection.queue(std::move(packet));
+}
 
-	std::cout << "CODE: " << get_code_string((CODES)data[0]) << std::endl;
-	std::cout << "Data: " << string(data + HEADERS, len - HEADERS) << std::endl;
-	int res = send(socket, data, len, FLAGS);
-	if (res == INVALID_SOCKET)
+bool Communicator::admit(Connection& connection, const RequestInfo& reqInfo, BusyResponse& busy) const
+{
+	return AdmissionController::getInstance()->admit(reqInfo.code, connection.getLoop()->getQueueDelay(), mWorkers->getQueueDelay(), busy.retryAfter);
+}
+
+bool Communicator::isIndependent(const Connection& connection, const RequestInfo& reqInfo) const
+{
+	if (dynamic_cast<MenuRequestHandler*>(connection.getHandler()) == nullptr) return false;
+	return reqInfo.code == CODES::GET_HIGH_SCORE_REQUEST || reqInfo.code == CODES::GET_PERSONAL_STATS_REQUEST;
+}
+
+bool Communicator::answerNotModified(Connection& connection, const RequestInfo& reqInfo, unsigned int& version)
+{
+	NotModifiedResponse response;
 	{
-		std::string s = "Error while recieving from socket: ";
-		s += std::to_string(socket);
-		throw std::exception(s.c_str());
+		std::lock_guard<mutex> lock(mHandlersLock);
+		version = connection.getHandler()->getVersion(reqInfo);
+		if (version == NO_VERSION || version != reqInfo.version) return false;
+		response.pollAfter = connection.getHandler()->getPollInterval(reqInfo);
 	}
+
+	Packet packet = JsonResponsePacketSerializer::serializeResponse(response);
+	if (reqInfo.hasRequestId) packet.setRequestId(reqInfo.requestId);
+	packet.setVersion(version);
+	if (mVerbose) logPacket(connection, packet);
+	connection.queue(std::move(packet));
+	return true;
+}
+
+void Communicator::dispatch(Connection& connection, const RequestInfo& reqInfo, const unsigned int version)
+{
+	std::weak_ptr<Connection> weak = connection.shared_from_this();
+	IEventLoop* loop = connection.getLoop();
+	LoggedUser user(((MenuRequestHandler*)connection.getHandler())->getUsername());
+	RequestInfo request = reqInfo;
+	connection.setDispatched(connection.getDispatched() + 1);
+	mWorkers->submit([this, weak, loop, user, request, version]()
+		{
+			// A handler of its own: the connection's handler may change or be deleted meanwhile.
+			// These requests only read the database, so they don't need mHandlersLock.
+			auto packet = std::make_shared<Packet>();
+			try
+			{
+				std::unique_ptr<IRequestHandler> handler(mHandlerFactory->createMenuRequestHandler(user));
+				*packet = std::move(handler->handleRequest(request).get().buffer);
+				if (version != NO_VERSION) packet->setVersion(version);
+			}
+			catch (const std::exception& e)
+			{
+				ErrorResponse response;
+				response.message = e.what();
+				*packet = JsonResponsePacketSerializer::serializeResponse(response);
+			}
+			packet->setRequestId(request.requestId);
+			loop->post([this, weak, packet]()
+				{
+					std::shared_ptr<Connection> connection = weak.lock();
+					if (connection == nullptr) return;
+					connection->setDispatched(connection->getDispatched() - 1);
+					if (connection->isClosed()) return;
+					if (mVerbose) logPacket(*connection, *packet);
+					connection->queue(std::move(*packet));
+					connection->getLoop()->cork(*connection);
+				});
+		});
+}
+
+void Communicator::logPacket(const Connection& connection, const Packet& packet) const
+{
+	std::cout << "\nSent " << std::to_string(packet.size()) << " bytes to " << connection.describe() << std::endl;
+	std::cout << "CODE: " << get_code_string((CODES)packet.code()) << std::endl;
+	std::cout << "Data: " << packet.body << std::endl;
 }
 
 void Communicator::closeSafe(IRequestHandler* handler)
 {
-	try 
+	try
 	{
 		if (dynamic_cast<LoginRequestHandler*>(handler) != nullptr) return;
 		if (dynamic_cast<RoomAdminRequestHandler*>(handler) != nullptr)
 		{
 			RequestInfo info("", CODES::CLOSE_ROOM_REQUEST);
-			RequestResult res = ((RoomAdminRequestHandler*)handler)->handleRequest(info);
+			RequestResult res = ((RoomAdminRequestHandler*)handler)->handleRequest(info).get();
 			handler = res.nextHandler;
 		}
 		if (dynamic_cast<RoomMemberRequestHandler*>(handler) != nullptr)
 		{
 			RequestInfo info("", CODES::LEAVE_ROOM_REQUEST);
-			RequestResult res = ((RoomMemberRequestHandler*)handler)->handleRequest(info);
+			RequestResult res = ((RoomMemberRequestHandler*)handler)->handleRequest(info).get();
+			handler = res.nextHandler;
+		}
+		if (dynamic_cast<GameRequestHandler*>(handler) != nullptr)
+		{
+			//Retire the player so the others' round does not wait for its answer.
+			RequestInfo info("", CODES::LEAVE_GAME_REQUEST);
+			RequestResult res = ((GameRequestHandler*)handler)->handleRequest(info).get();
 			handler = res.nextHandler;
 		}
 		if (dynamic_cast<MenuRequestHandler*>(handler) != nullptr)
 		{
 			RequestInfo info("", CODES::LOGOUT_REQUEST);
 
-			((MenuRequestHandler*)handler)->handleRequest(info);
+			((MenuRequestHandler*)handler)->handleRequest(info).get();
 		}
 
 	}
@@ -218,3 +993,35 @@ void Communicator::closeSafe(IRequestHandler* handler)
 
 	}
 }
+
+IEventLoop* Communicator::createLoop()
+{
+	Config* config = Config::getInstance();
+	string backend = config->getString("io_backend", DEFAULT_IO_BACKEND);
+	IEventLoop* loop = nullptr;
+#ifdef __linux__
+	if (backend == "uring")
+	{
+		try
+		{
+			loop = new UringEventLoop(this);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << e.what() << ", falling back to epoll" << std::endl;
+		}
+	}
+	if (loop == nullptr && backend != "poll")
+	{
+		loop = new EpollEventLoop(this);
+	}
+#endif
+	if (loop == nullptr)
+	{
+		loop = new PollEventLoop(this);
+	}
+	loop->setOutboundLimits((size_t)std::max(0, config->getInt("outbound_high_watermark", OUTBOUND_HIGH_WATERMARK)),
+		(size_t)std::max(0, config->getInt("outbound_low_watermark", OUTBOUND_LOW_WATERMARK)),
+		(unsigned int)std::max(1, config->getInt("slow_consumer_timeout", SLOW_CONSUMER_TIMEOUT_MS / 1000)) * 1000);
+	return loop;
+}
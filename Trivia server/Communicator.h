@@ -1,12 +1,23 @@
 #pragma once
 
-#include <WinSock2.h>
-#include <Windows.h>
+#include "Socket.h"
+#include "IEventLoop.h"
+#include "Reactor.h"
+#include "FrameParser.h"
+#include "WorkerPool.h"
+#include "NotificationCenter.h"
+#include "Snapshot.h"
+#include "TlsAcceptor.h"
+#include "RequestContext.h"
+#include "GatewayLink.h"
 #include <queue>
 #include <string>
 #include <mutex>
 #include <thread>
 #include <map>
+#include <vector>
+#include <atomic>
+#include <memory>
 #include "IRequestHandler.h"
 #include "LoginRequestHandler.h"
 using std::queue;
@@ -14,50 +25,261 @@ using std::mutex;
 using std::string;
 using std::thread;
 using std::map;
+using std::vector;
 #define FLAGS 0
 #define HEADERS 5
 #define CODE_INDEX 0
 #define LEN_INDEX 1
-#define NO_USER "\1"
+#define DEFAULT_IO_BACKEND "epoll"
+#define DEFAULT_IDLE_TIMEOUT 0 // Seconds of silence before a client that does not answer PING is reaped, 0 never: a player may sit in the menu for long.
+#define DEFAULT_GATEWAY_ADDRESS "127.0.0.1" // Gateways are trusted, so by default only local ones may connect.
+#define DEFAULT_HEARTBEAT_INTERVAL 15 // Seconds of silence before a client that answers PING is pinged.
+#define DRAIN_POLL_MS 100
 
 /*
-A class that is used for running a TCP server and handling client requests
+A class that is used for running a TCP server and handling client requests.
+A small fixed set of reactors (an event loop each) drives every connection, there is no thread per client.
 */
-class Communicator
+class Communicator : public IConnectionEvents, public INotificationListener
 {
 public:
 	Communicator();
 	~Communicator();
 	/*
 	* Starts to listen in the port that passed.
+	* Starts one reactor per core ("reactors" setting), each with its own listener
+	* where the platform supports SO_REUSEPORT. Blocks while the reactors run.
+	* With the "local_socket" setting, co-located clients may also connect to that
+	* Unix domain socket path, with the same framing and handlers.
+	* With the "tls_port" setting, clients may also connect there with TLS, the server
+	* presents the "tls_certificate" chain and proves it with "tls_private_key" (PEM files).
+	* With the "gateway_port" setting, gateways connect there and forward the clients they
+	* terminate over their links (see GatewayLink). The server trusts the client addresses
+	* they send and does not limit their sessions, so that port listens on "gateway_address"
+	* only, 127.0.0.1 by default. Widen it to gateways on other hosts only behind a firewall.
 	*/
 	void startHandleRequests(const int port);
+
+	/*
+	* Shuts the server down gracefully: stops accepting, refuses new rooms and games,
+	* waits up to timeoutMs for the running games to finish, saves the scores of the
+	* players still in a game after that, and stops the reactors so startHandleRequests
+	* returns. The loops write what they can of every outbound queue before they close it.
+	* Safe to call from any thread, also before startHandleRequests.
+	*/
+	void drain(const unsigned int timeoutMs);
+
+	/*
+	* Starts a hot upgrade: the reactors stop without closing anything and startHandleRequests returns.
+	* Safe to call from any thread.
+	*/
+	void beginHandOff();
+
+	/*
+	* Passes the listeners, the connections and a snapshot of the state to the new process
+	* and waits until it took over. Call it once startHandleRequests returned after beginHandOff.
+	* If the new process fails, the clients are logged out and closed as on a normal shutdown.
+	* @returns True if the new process took over.
+	*/
+	bool handOff(SOCKET channel);
+
+	/*
+	* Takes the clients over from the old process before startHandleRequests: restores the
+	* rooms, the games and the logged in users, and serves the passed listeners and
+	* connections instead of opening listeners of its own.
+	* @returns False if nothing was taken over, the old process then closed its clients.
+	*/
+	bool takeOver(SOCKET channel);
+
+	/*
+	* Logs out the users whose dropped sessions outlived the "resume_grace" setting.
+	* Safe to call from any thread, the server calls it periodically.
+	*/
+	void expireSessions();
+
+	/*
+	* Keeps an accepted socket on the loop that accepted it. With a single shared
+	* listener, and for the Unix domain listener, the sockets are handed to the loops round robin instead.
+	* Sockets of the TLS listener go to the handshake thread first, gateway links are spread round robin.
+	*/
+	virtual void onAccept(IEventLoop& loop, SOCKET listener, SOCKET client) override;
+	/*
+	* Initialize new user at beggining of state machine.
+	* A connection to the gateway port becomes a link, its sessions are opened by GatewayLink.
+	*/
+	virtual void onOpen(Connection& connection) override;
+	/*
+	* Extracts every complete request from the inbound buffer and handles it,
+	* so pipelined requests are all served in one wakeup. Stops early once the
+	* client's outbound queue is backed up, the loop calls it again when it drained,
+	* and while a request is suspended on a co_await, step() calls it again after it.
+	* The frames of a gateway link go to its sessions instead.
+	*/
+	virtual void onData(Connection& connection) override;
+	/*
+	* Parks the session of a logged in user for a RESUME_REQUEST, or
+	* logs the user out of all activity and frees its handler.
+	* A gateway link that closes closes its sessions the same way.
+	*/
+	virtual void onClose(Connection& connection) override;
+	/*
+	* Moves a room member to the next state when a pushed room state closes or starts its room.
+	*/
+	virtual void onNotify(Connection& connection, const Notification& notification) override;
+	/*
+	* Pings a silent client that uses heartbeats once; reaps it if it stays silent,
+	* and reaps clients without heartbeats right away. Reaped users are logged out by onClose.
+	*/
+	virtual bool onIdle(Connection& connection) override;
 private:
 	/*
-	* Accepts a client and opens a new thread for him.
+	* Handles one request of a client and queues the response.
+	*/
+	void handleRequest(Connection& connection, const RequestInfo& reqInfo);
+
+	/*
+	* Runs the sub-requests of a BATCH_REQUEST in order through the current handler
+	* and queues one BATCH_RESPONSE with all their responses.
+	*/
+	void handleBatch(Connection& connection, const RequestInfo& reqInfo);
+
+	/*
+	* Passes one request to the connection's handler and moves it to the next state.
+	* A handler that awaits I/O finishes inline here, without a RequestContext.
+	* @throws std::exception If the handler failed.
+	*/
+	RequestResult run(Connection& connection, const RequestInfo& reqInfo);
+
+	/*
+	* Moves the connection to the state a handler returned, and registers or
+	* unregisters its user when it logged in or out. Call it without mHandlersLock.
 	*/
-	void bindAndListen();
+	void advance(Connection& connection, IRequestHandler* handler, const RequestResult& reqResult, const unsigned char code);
+
 	/*
-	* Handles client's requests.
+	* Tags a response with the request's ID and version, if any, and queues it.
 	*/
-	void handleNewClient(SOCKET clientSocket);
+	void respond(Connection& connection, Packet& packet, const RequestInfo& reqInfo, const unsigned int version);
+
 	/*
-	* Recieves len bytes into data.
+	* A request whose handler coroutine suspended. It holds the coroutine, and its
+	* RequestContext sends awaited work to the workers and resumes it on the loop.
 	*/
-	void recieve(SOCKET socket, char* data, const int len) const;
+	struct PendingRequest;
+
 	/*
-	* Sends len bytes from data.
+	* Runs a suspended request's coroutine on its loop until it suspends again or
+	* finishes, with mHandlersLock held. Once it finished, queues the response and
+	* handles the requests the connection sent meanwhile.
+	* @param next The coroutine to resume, or none to start the request.
 	*/
-	void sendPacket(SOCKET socket, const char* data, const int len) const;
+	void step(const std::shared_ptr<PendingRequest>& request, std::coroutine_handle<> next);
+
+	/*
+	* Handles SUBSCRIBE_REQUEST and UNSUBSCRIBE_REQUEST, valid in any state after login.
+	*/
+	void handleSubscribe(Connection& connection, const RequestInfo& reqInfo);
+	/*
+	* Handles RESUME_REQUEST, valid before login: the connection takes the parked session
+	* of the token back. If the token's connection is still open, as a half-open one stays
+	* until it is reaped, that connection is closed first and the request waits for it.
+	*/
+	void handleResume(Connection& connection, const RequestInfo& reqInfo);
+
+	/*
+	* Moves a parked session to the connection, with mHandlersLock held.
+	* @param username Set to the user of the token, empty if the token is not valid.
+	* @returns False if the token's session is not parked.
+	*/
+	bool resume(Connection& connection, const string& token, ResumeResponse& response, string& username);
+
+	/*
+	* Catches a handler up with what it missed while its session was parked.
+	*/
+	IRequestHandler* unpark(IRequestHandler* handler);
+
+	/*
+	* Answers a PING with a PONG and switches the client to heartbeats. A PONG needs no answer.
+	*/
+	void handleHeartbeat(Connection& connection, const RequestInfo& reqInfo);
+
+	/*
+	* Answers a request the frame parser dropped for its rate limit, with the time until
+	* the client has a token again. The request ID is kept so a pipelining client can match it.
+	*/
+	void answerRateLimited(Connection& connection, const RequestInfo& reqInfo);
+
+	/*
+	* Asks the admission controller whether a request is handled now, by its class and
+	* the queue delay of the connection's loop and of the workers.
+	* @returns False if the request is shed, busy then holds the retry hint.
+	*/
+	bool admit(Connection& connection, const RequestInfo& reqInfo, BusyResponse& busy) const;
+
+	/*
+	* Checks whether a request only reads the database and does not change the state of the handler.
+	* Such requests may run on a worker next to the following requests of the same connection.
+	*/
+	bool isIndependent(const Connection& connection, const RequestInfo& reqInfo) const;
+
+	/*
+	* Runs an independent request on a worker and queues the response, tagged with
+	* the request ID (and the version, if any), on the connection's loop once it is ready.
+	*/
+	void dispatch(Connection& connection, const RequestInfo& reqInfo, const unsigned int version);
+
+	/*
+	* Reads the current version of a conditional read into version. When it matches the
+	* client's, queues NOT_MODIFIED_RESPONSE (with the poll hint) without running the handler.
+	* @returns True if the request was answered.
+	*/
+	bool answerNotModified(Connection& connection, const RequestInfo& reqInfo, unsigned int& version);
+
+	/*
+	* Prints a response that is about to be sent.
+	*/
+	void logPacket(const Connection& connection, const Packet& packet) const;
 
 	/*
 	* Ensures that state machine logs out of all activity before closing the connection.
 	*/
 	void closeSafe(IRequestHandler* handler);
 
-	SOCKET mServerSocket;
+	/*
+	* Stops the thread that removes the finished games and waits for it. Call it without mHandlersLock,
+	* the thread takes it for its passes.
+	*/
+	void stopReaper();
+
+	/*
+	* Creates the event loop chosen by the "io_backend" setting:
+	* "epoll" (default), "uring" or "poll". Platforms without epoll always use poll.
+	* Its outbound queues are bounded by "outbound_high_watermark", "outbound_low_watermark"
+	* (bytes) and "slow_consumer_timeout" (seconds).
+	*/
+	IEventLoop* createLoop();
+
 	RequestHandlerFactory* mHandlerFactory;
-	map<SOCKET, IRequestHandler*> mClients;
-	map<SOCKET, string> mUsernames;
+	WorkerPool* mWorkers; //Runs independent requests that carry a request ID and awaited work ("workers" setting).
+	vector<Reactor*> mReactors;
+	bool mSharedListener; //One listener on the first reactor, used where SO_REUSEPORT does not balance.
+	SOCKET mLocalListener; //Unix domain listener on the first reactor, INVALID_SOCKET without one.
+	SOCKET mTlsListener; //TLS listener on the first reactor, INVALID_SOCKET without one.
+	TlsAcceptor* mTls; //Runs the handshakes of the TLS listener, hands finished ones to the loops round robin.
+	SOCKET mGatewayListener; //Listener of the gateway links on the first reactor, INVALID_SOCKET without one.
+	int mGatewayPort; //"gateway_port" setting, 0 without gateways.
+	string mGatewayAddress; //"gateway_address" setting, the address the gateway listener binds to.
+	//Every link that connected. Kept until the end: tasks of their sessions may still be posted to them.
+	vector<GatewayLink*> mGatewayLinks;
+	std::atomic<unsigned int> mNextLoop;
+	bool mVerbose; //Print every request and response ("verbose" setting).
+	unsigned int mIdleTimeout; //Milliseconds, 0 never reaps ("idle_timeout" setting, in seconds).
+	unsigned int mHeartbeatInterval; //Milliseconds ("heartbeat_interval" setting, in seconds).
+	bool mStopped; //drain() or beginHandOff() ran, guarded by mHandlersLock like the reactor list.
+	vector<SOCKET> mInheritedListeners; //Listeners taken over from the old process.
+	map<SOCKET, nlohmann::json> mRestoring; //Connections taken over and not opened yet, guarded by mHandlersLock.
+	std::atomic<bool> mRestorePending; //mRestoring is not empty, new clients skip the lock otherwise.
+	thread mReaper; //Removes the finished games and their rooms, stopped once the server shuts down or hands off.
+	// Handlers and managers are not thread safe, requests of different loops are handled one at a time.
+	mutex mHandlersLock;
 };
-
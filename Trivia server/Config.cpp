@@ -0,0 +1,52 @@
+#include "Config.h"
+#include <fstream>
+#include <cstdlib>
+
+Config* Config::instancePtr = nullptr;
+
+Config* Config::getInstance()
+{
+	if (instancePtr == nullptr)
+	{
+		instancePtr = new Config();
+	}
+	return instancePtr;
+}
+
+void Config::load(const string& path)
+{
+	std::ifstream configFile(path);
+	string line = "";
+	while (std::getline(configFile, line))
+	{
+		size_t separator = line.find('=');
+		if (separator == string::npos) continue;
+		string key = line.substr(0, separator);
+		string value = line.substr(separator + 1);
+		//Trim spaces around the key and the value.
+		key.erase(key.find_last_not_of(" \t\r") + 1);
+		key.erase(0, key.find_first_not_of(" \t"));
+		value.erase(value.find_last_not_of(" \t\r") + 1);
+		value.erase(0, value.find_first_not_of(" \t"));
+		if (!key.empty()) mValues[key] = value;
+	}
+}
+
+string Config::getString(const string& key, const string& defaultValue) const
+{
+	auto it = mValues.find(key);
+	return it == mValues.end() ? defaultValue : it->second;
+}
+
+int Config::getInt(const string& key, const int defaultValue) const
+{
+	auto it = mValues.find(key);
+	if (it == mValues.end()) return defaultValue;
+	int value = atoi(it->second.c_str());
+	return (value == 0 && it->second != "0") ? defaultValue : value;
+}
+
+void Config::set(const string& key, const string& value)
+{
+	mValues[key] = value;
+}
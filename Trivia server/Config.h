@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <map>
+
+using std::string;
+using std::map;
+
+#define CONFIG_FILE "config.txt"
+
+/****
+ * @brief Settings of the server, read from config.txt.
+ *
+ * Every line of the file has the form "key = value". Unknown keys are kept,
+ * missing keys fall back to the default the caller passes.
+ ****/
+class Config
+{
+public:
+    /****
+     * @brief Deleted copy constructor to enforce singleton pattern.
+     ****/
+    Config(const Config& obj) = delete;
+
+    /****
+     * @brief Gets the singleton instance of Config.
+     *
+     * @returns A pointer to the singleton instance of Config.
+     ****/
+    static Config* getInstance();
+
+    /****
+     * @brief Reads the settings from a file. A missing file leaves every setting at its default.
+     *
+     * @param path The path of the config file.
+     ****/
+    void load(const string& path);
+
+    /****
+     * @brief Gets a text setting.
+     *
+     * @param key The name of the setting.
+     * @param defaultValue The value to return when the setting is missing.
+     * @returns The setting.
+     ****/
+    string getString(const string& key, const string& defaultValue) const;
+
+    /****
+     * @brief Gets a numeric setting.
+     *
+     * @param key The name of the setting.
+     * @param defaultValue The value to return when the setting is missing or not a number.
+     * @returns The setting.
+     ****/
+    int getInt(const string& key, const int defaultValue) const;
+
+    /****
+     * @brief Overrides a setting, used for command line arguments.
+     *
+     * @param key The name of the setting.
+     * @param value The new value.
+     ****/
+    void set(const string& key, const string& value);
+
+private:
+    Config() = default;
+
+    map<string, string> mValues;
+    static Config* instancePtr;
+};
@@ -0,0 +1,255 @@
+#include "Connection.h"
+#include "TlsSession.h"
+
+Connection::Connection(SOCKET socket, IEventLoop* loop)
+{
+	mSocket = socket;
+	mLoop = loop;
+	mHandler = nullptr;
+	mUsername = NO_USER;
+	mLimits = nullptr;
+	mLink = nullptr;
+	mTls = nullptr;
+	mIdleTimeout = 0;
+	mIdleStrikes = 0;
+	mUsesHeartbeat = false;
+	mReadPaused = false;
+	mOutboundLimit = 0;
+	mAwaiting = false;
+	mDispatched = 0;
+	mPeerClosed = false;
+	mCorked = false;
+	mClosed = false;
+}
+
+Connection::~Connection()
+{
+	delete mTls;
+}
+
+SOCKET Connection::getSocket() const
+{
+	return mSocket;
+}
+
+IEventLoop* Connection::getLoop() const
+{
+	return mLoop;
+}
+
+IRequestHandler* Connection::getHandler() const
+{
+	return mHandler;
+}
+
+void Connection::setHandler(IRequestHandler* handler)
+{
+	mHandler = handler;
+}
+
+const string& Connection::getUsername() const
+{
+	return mUsername;
+}
+
+void Connection::setUsername(const string& username)
+{
+	mUsername = username;
+}
+
+ClientLimits* Connection::getLimits() const
+{
+	return mLimits;
+}
+
+void Connection::setLimits(ClientLimits* limits)
+{
+	mLimits = limits;
+}
+
+GatewayLink* Connection::getLink() const
+{
+	return mLink;
+}
+
+void Connection::setLink(GatewayLink* link)
+{
+	mLink = link;
+}
+
+RingBuffer& Connection::getInbound()
+{
+	return mInbound;
+}
+
+OutboundQueue& Connection::getOutbound()
+{
+	return mOutbound;
+}
+
+TlsSession* Connection::getTls() const
+{
+	return mTls;
+}
+
+void Connection::setTls(TlsSession* tls)
+{
+	mTls = tls;
+}
+
+bool Connection::receivesRecords() const
+{
+	return mTls != nullptr && mTls->decryptsReceived();
+}
+
+bool Connection::append(const char* data, const size_t len)
+{
+	if (!receivesRecords())
+	{
+		mInbound.write(data, len);
+		return true;
+	}
+	return mTls->decrypt(data, len, mInbound);
+}
+
+OutboundQueue& Connection::seal()
+{
+	if (mTls == nullptr || !mTls->encryptsSent()) return mOutbound;
+	mTls->seal(mOutbound);
+	return mTls->getRecords();
+}
+
+size_t Connection::getUnsentBytes() const
+{
+	return mOutbound.size() + (mTls != nullptr ? mTls->getRecords().size() : 0);
+}
+
+void Connection::queue(Packet&& packet)
+{
+	mOutbound.push(std::move(packet));
+}
+
+void Connection::queue(std::shared_ptr<const Packet> packet)
+{
+	mOutbound.push(std::move(packet));
+}
+
+unsigned int Connection::getIdleTimeout() const
+{
+	return mIdleTimeout;
+}
+
+void Connection::setIdleTimeout(const unsigned int timeoutMs)
+{
+	mIdleTimeout = timeoutMs;
+}
+
+unsigned int Connection::getIdleStrikes() const
+{
+	return mIdleStrikes;
+}
+
+void Connection::setIdleStrikes(const unsigned int strikes)
+{
+	mIdleStrikes = strikes;
+}
+
+bool Connection::usesHeartbeat() const
+{
+	return mUsesHeartbeat;
+}
+
+void Connection::setUsesHeartbeat(const bool usesHeartbeat)
+{
+	mUsesHeartbeat = usesHeartbeat;
+}
+
+bool Connection::isReadPaused() const
+{
+	return mReadPaused;
+}
+
+void Connection::setReadPaused(const bool paused)
+{
+	mReadPaused = paused;
+}
+
+bool Connection::isReadStopped() const
+{
+	return mReadPaused || mAwaiting;
+}
+
+void Connection::setOutboundLimit(const size_t limit)
+{
+	mOutboundLimit = limit;
+}
+
+size_t Connection::getOutboundLimit() const
+{
+	return mOutboundLimit;
+}
+
+bool Connection::isBackedUp() const
+{
+	return mOutboundLimit != 0 && getUnsentBytes() >= mOutboundLimit;
+}
+
+bool Connection::isAwaiting() const
+{
+	return mAwaiting;
+}
+
+void Connection::setAwaiting(const bool awaiting)
+{
+	mAwaiting = awaiting;
+}
+
+unsigned int Connection::getDispatched() const
+{
+	return mDispatched;
+}
+
+void Connection::setDispatched(const unsigned int dispatched)
+{
+	mDispatched = dispatched;
+}
+
+bool Connection::isBusy() const
+{
+	return mAwaiting || mDispatched != 0;
+}
+
+bool Connection::isPeerClosed() const
+{
+	return mPeerClosed;
+}
+
+void Connection::setPeerClosed(const bool peerClosed)
+{
+	mPeerClosed = peerClosed;
+}
+
+bool Connection::isCorked() const
+{
+	return mCorked;
+}
+
+void Connection::setCorked(const bool corked)
+{
+	mCorked = corked;
+}
+
+bool Connection::isClosed() const
+{
+	return mClosed;
+}
+
+void Connection::markClosed()
+{
+	mClosed = true;
+}
+
+string Connection::describe() const
+{
+	return (mUsername == NO_USER) ? "socket " + std::to_string(mSocket) : "user \"" + mUsername + "\"";
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "Socket.h"
+#include "RingBuffer.h"
+#include "OutboundQueue.h"
+#include "TimerWheel.h"
+#include <string>
+#include <memory>
+
+using std::string;
+
+#define NO_USER "\1" // The username of a connection that did not log in.
+
+class IEventLoop;
+class IRequestHandler;
+class TlsSession;
+class GatewayLink;
+struct ClientLimits;
+
+/****
+ * @brief The state of one client connection.
+ *
+ * A connection belongs to exactly one event loop and is only touched from that
+ * loop's thread. Other threads that want to reach it post a task to the loop.
+ * It is its own idle deadline in the loop's timer wheel.
+ ****/
+class Connection : public std::enable_shared_from_this<Connection>, public TimerNode
+{
+public:
+    /****
+     * @brief Constructs a connection for an accepted socket.
+     *
+     * @param socket The client socket, already non-blocking.
+     * @param loop The event loop that owns the socket.
+     ****/
+    Connection(SOCKET socket, IEventLoop* loop);
+    ~Connection();
+
+    SOCKET getSocket() const; //getter
+    IEventLoop* getLoop() const; //getter
+
+    /****
+     * @returns The state machine handler that serves the next request.
+     ****/
+    IRequestHandler* getHandler() const;
+
+    /****
+     * @brief Replaces the current handler. The previous one is not deleted.
+     *
+     * @param handler The new handler.
+     ****/
+    void setHandler(IRequestHandler* handler);
+
+    /****
+     * @returns The logged in username, or NO_USER.
+     ****/
+    const string& getUsername() const;
+    void setUsername(const string& username); //setter
+
+    /****
+     * @returns The rate limit buckets of the client, or nullptr. Like the handler they are owned by the protocol layer.
+     ****/
+    ClientLimits* getLimits() const;
+    void setLimits(ClientLimits* limits); //setter
+
+    /****
+     * @returns The sessions a gateway multiplexes over this connection, or nullptr for a client. Owned by the protocol layer like the handler.
+     ****/
+    GatewayLink* getLink() const;
+    void setLink(GatewayLink* link); //setter
+
+    /****
+     * @returns Bytes received and not parsed yet.
+     ****/
+    RingBuffer& getInbound();
+
+    /****
+     * @returns Responses waiting to be written to the socket.
+     ****/
+    OutboundQueue& getOutbound();
+
+    /****
+     * @returns The TLS state of the connection, or nullptr for a plain one.
+     ****/
+    TlsSession* getTls() const;
+    void setTls(TlsSession* tls); //setter, the connection deletes the session
+
+    /****
+     * @returns Whether received bytes have to go through append(), false if they may be read straight into the inbound buffer.
+     ****/
+    bool receivesRecords() const;
+
+    /****
+     * @brief Appends received bytes to the inbound buffer, decrypting them first on a TLS connection.
+     *
+     * @returns False if the TLS session broke or the client ended it.
+     ****/
+    bool append(const char* data, const size_t len);
+
+    /****
+     * @brief Turns the queued responses into the bytes that go on the wire.
+     *
+     * @returns The outbound queue of a plain connection, the TLS records of a TLS one.
+     ****/
+    OutboundQueue& seal();
+
+    /****
+     * @returns The bytes queued and not written yet, responses and records.
+     ****/
+    size_t getUnsentBytes() const;
+
+    /****
+     * @brief Appends a serialized response to the outbound queue.
+     *
+     * @param packet The response, moved into the queue.
+     ****/
+    void queue(Packet&& packet);
+
+    /****
+     * @brief Appends a broadcast frame to the outbound queue without copying it.
+     *
+     * @param packet The frame, shared with every other connection it goes to.
+     ****/
+    void queue(std::shared_ptr<const Packet> packet);
+
+    /****
+     * @returns The silence in milliseconds after which IConnectionEvents::onIdle is raised, 0 never.
+     ****/
+    unsigned int getIdleTimeout() const;
+    void setIdleTimeout(const unsigned int timeoutMs); //setter, takes effect on the next activity
+
+    /****
+     * @returns How many idle deadlines passed since the last received bytes.
+     ****/
+    unsigned int getIdleStrikes() const;
+    void setIdleStrikes(const unsigned int strikes); //setter
+
+    /****
+     * @returns Whether the client answers PING, so it is pinged before it is reaped.
+     ****/
+    bool usesHeartbeat() const;
+    void setUsesHeartbeat(const bool usesHeartbeat); //setter
+
+    bool isReadPaused() const; //getter
+    void setReadPaused(const bool paused); //setter, only the loop pauses and resumes reads
+
+    /****
+     * @returns Whether the loop does not read from the connection now: reads are paused,
+     * or a request is awaiting. Only a paused connection counts towards eviction.
+     ****/
+    bool isReadStopped() const;
+
+    /****
+     * @brief Sets the outbound queue size from which the connection counts as backed up, 0 never.
+     * The loop does not pause or evict a connection without a limit either.
+     ****/
+    void setOutboundLimit(const size_t limit);
+    size_t getOutboundLimit() const; //getter
+
+    /****
+     * @returns Whether the queued responses reached the limit. The protocol layer stops
+     * handling buffered requests until the loop wrote them out.
+     ****/
+    bool isBackedUp() const;
+
+    /****
+     * @returns Whether a request of the connection is suspended on a co_await. The
+     * protocol layer keeps the requests after it buffered until it finished.
+     ****/
+    bool isAwaiting() const;
+    void setAwaiting(const bool awaiting); //setter
+
+    /****
+     * @returns How many independent requests of the connection run on the workers.
+     ****/
+    unsigned int getDispatched() const;
+    void setDispatched(const unsigned int dispatched); //setter
+
+    /****
+     * @returns Whether a reply is still to come: a request is awaiting or runs on the workers.
+     ****/
+    bool isBusy() const;
+
+    /****
+     * @returns Whether the peer shut down its side while the connection was busy. The loop
+     * stops reading and closes the connection once the replies still to come are written.
+     ****/
+    bool isPeerClosed() const;
+    void setPeerClosed(const bool peerClosed); //setter, only the loop sets it
+
+    bool isCorked() const; //getter
+    void setCorked(const bool corked); //setter, only the loop corks, see IEventLoop::cork
+
+    bool isClosed() const; //getter
+
+    /****
+     * @brief Marks the connection as closed, pending tasks that still hold it will skip it.
+     ****/
+    void markClosed();
+
+    /****
+     * @returns A printable name for logs: the username or the socket number.
+     ****/
+    string describe() const;
+
+private:
+    SOCKET mSocket;
+    IEventLoop* mLoop;
+    IRequestHandler* mHandler;
+    string mUsername;
+    ClientLimits* mLimits;
+    GatewayLink* mLink;
+    TlsSession* mTls;
+    RingBuffer mInbound;
+    OutboundQueue mOutbound;
+    unsigned int mIdleTimeout;
+    unsigned int mIdleStrikes;
+    bool mUsesHeartbeat;
+    bool mReadPaused;
+    size_t mOutboundLimit;
+    bool mAwaiting;
+    unsigned int mDispatched;
+    bool mPeerClosed;
+    bool mCorked;
+    bool mClosed;
+};
@@ -0,0 +1,125 @@
+#include "EpollEventLoop.h"
+
+#ifdef __linux__
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <stdexcept>
+#include <algorithm>
+
+EpollEventLoop::EpollEventLoop(IConnectionEvents* events) : EventLoop(events)
+{
+	mEpoll = epoll_create1(EPOLL_CLOEXEC);
+	if (mEpoll == -1)
+		throw std::runtime_error("EpollEventLoop - epoll_create1");
+	mWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (mWakeFd == -1)
+		throw std::runtime_error("EpollEventLoop - eventfd");
+
+	epoll_event ev = {};
+	ev.events = EPOLLIN | EPOLLET;
+	ev.data.fd = mWakeFd;
+	epoll_ctl(mEpoll, EPOLL_CTL_ADD, mWakeFd, &ev);
+}
+
+EpollEventLoop::~EpollEventLoop()
+{
+	::close(mWakeFd);
+	::close(mEpoll);
+}
+
+void EpollEventLoop::addListener(SOCKET listener)
+{
+	post([this, listener]()
+		{
+			mListeners.push_back(listener);
+			epoll_event ev = {};
+			ev.events = EPOLLIN | EPOLLET;
+			ev.data.fd = listener;
+			epoll_ctl(mEpoll, EPOLL_CTL_ADD, listener, &ev);
+			acceptAll(listener); //Connections that arrived before registration give no edge.
+		});
+}
+
+void EpollEventLoop::run()
+{
+	mThreadId = std::this_thread::get_id();
+	epoll_event events[MAX_EVENTS];
+	while (!mStopping)
+	{
+		uncork();
+		endPass();
+		int count = epoll_wait(mEpoll, events, MAX_EVENTS, mTimers.getTimeout());
+		beginPass();
+		if (count == -1)
+		{
+			if (errno == EINTR) continue;
+			break;
+		}
+		expireTimers();
+		for (int i = 0; i < count; i++)
+		{
+			int fd = events[i].data.fd;
+			if (fd == mWakeFd)
+			{
+				uint64_t value;
+				while (read(mWakeFd, &value, sizeof(value)) > 0);
+				runTasks();
+				continue;
+			}
+			if (std::find(mListeners.begin(), mListeners.end(), fd) != mListeners.end())
+			{
+				acceptAll(fd);
+				continue;
+			}
+			shared_ptr<Connection> connection = find(fd);
+			if (connection == nullptr) continue;
+			if (events[i].events & EPOLLERR)
+			{
+				close(*connection);
+				continue;
+			}
+			if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP))
+			{
+				handleReadable(connection, (events[i].events & (EPOLLRDHUP | EPOLLHUP)) != 0);
+			}
+			if ((events[i].events & EPOLLOUT) && !connection->isClosed() && connection->getUnsentBytes() != 0)
+			{
+				flush(*connection);
+			}
+		}
+	}
+	runTasks();
+	closeAll();
+}
+
+void EpollEventLoop::watch(Connection& connection)
+{
+	epoll_event ev = {};
+	ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+	ev.data.fd = connection.getSocket();
+	epoll_ctl(mEpoll, EPOLL_CTL_ADD, connection.getSocket(), &ev);
+}
+
+void EpollEventLoop::unwatch(Connection& connection)
+{
+	epoll_ctl(mEpoll, EPOLL_CTL_DEL, connection.getSocket(), nullptr);
+}
+
+void EpollEventLoop::setReading(Connection& connection, const bool reading)
+{
+	epoll_event ev = {};
+	// Edge triggered: re-adding EPOLLIN reports data that arrived meanwhile right away.
+	ev.events = reading ? (EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET) : (EPOLLOUT | EPOLLET);
+	ev.data.fd = connection.getSocket();
+	epoll_ctl(mEpoll, EPOLL_CTL_MOD, connection.getSocket(), &ev);
+}
+
+void EpollEventLoop::wake()
+{
+	uint64_t one = 1;
+	ssize_t res = write(mWakeFd, &one, sizeof(one));
+	(void)res;
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#ifdef __linux__
+
+#include "EventLoop.h"
+
+#define MAX_EVENTS 256
+
+/****
+ * @brief An edge-triggered epoll loop (Linux only).
+ *
+ * Every socket is registered once for input and output with EPOLLET, so the
+ * loop never has to modify interest sets: it drains a socket on input and
+ * resumes a partial write on output.
+ ****/
+class EpollEventLoop : public EventLoop
+{
+public:
+    /****
+     * @brief Creates the epoll instance and its wakeup eventfd.
+     *
+     * @param events The receiver of connection callbacks.
+     * @throws std::runtime_error If epoll or eventfd could not be created.
+     ****/
+    EpollEventLoop(IConnectionEvents* events);
+    virtual ~EpollEventLoop();
+
+    virtual void addListener(SOCKET listener) override;
+    virtual void run() override;
+
+protected:
+    virtual void watch(Connection& connection) override;
+    virtual void unwatch(Connection& connection) override;
+    virtual void wake() override;
+    virtual void setReading(Connection& connection, const bool reading) override;
+
+private:
+    int mEpoll;
+    int mWakeFd;
+};
+
+#endif
@@ -0,0 +1,434 @@
+#include "EventLoop.h"
+#include "TlsSession.h"
+#include <algorithm>
+#include <climits>
+
+EventLoop::EventLoop(IConnectionEvents* events)
+{
+	mEvents = events;
+	mStopping = false;
+	mHandingOff = false;
+	mHighWatermark = OUTBOUND_HIGH_WATERMARK;
+	mLowWatermark = OUTBOUND_LOW_WATERMARK;
+	mEvictAfter = SLOW_CONSUMER_TIMEOUT_MS;
+	mPassStart = mPassEnd = mWindowStart = steady_clock::now();
+	mWindowMin = UINT_MAX;
+	mQueueDelay = 0;
+}
+
+void EventLoop::adopt(SOCKET client, TlsSession* tls)
+{
+	if (std::this_thread::get_id() == mThreadId.load())
+	{
+		open(client, tls);
+		return;
+	}
+	post([this, client, tls]() { open(client, tls); });
+}
+
+void EventLoop::post(std::function<void()> task)
+{
+	{
+		std::lock_guard<mutex> lock(mTasksLock);
+		mTasks.push_back(std::move(task));
+	}
+	wake();
+}
+
+void EventLoop::flush(Connection& connection)
+{
+	OutboundQueue& outbound = connection.seal();
+	Segment segments[SEND_SEGMENTS];
+	while (!outbound.empty() && !connection.isClosed())
+	{
+		int count = outbound.gather(segments, SEND_SEGMENTS);
+		int res = Socket::sendSegments(connection.getSocket(), segments, count);
+		if (res > 0)
+		{
+			outbound.advance(res);
+		}
+		else if (res == SOCKET_ERROR && Socket::wouldBlock())
+		{
+			break; //The rest is written once the socket is writable.
+		}
+		else
+		{
+			close(connection);
+			return;
+		}
+	}
+	if (connection.isPeerClosed() && !connection.isBusy() && outbound.empty())
+	{
+		close(connection);
+		return;
+	}
+	checkBackpressure(connection);
+}
+
+void EventLoop::cork(Connection& connection)
+{
+	if (connection.isCorked() || connection.isClosed()) return;
+	connection.setCorked(true);
+	mCorked.push_back(connection.shared_from_this());
+}
+
+void EventLoop::uncork()
+{
+	// By index: a flush that closes a connection runs callbacks, which may cork others.
+	for (size_t i = 0; i < mCorked.size(); i++)
+	{
+		shared_ptr<Connection> connection = mCorked[i];
+		connection->setCorked(false);
+		if (!connection->isClosed()) flush(*connection);
+	}
+	mCorked.clear();
+}
+
+void EventLoop::close(Connection& connection)
+{
+	if (connection.isClosed()) return;
+	connection.markClosed();
+	mTimers.cancel(connection);
+	mEvents->onClose(connection);
+	unwatch(connection);
+	Socket::closeSocket(connection.getSocket());
+	mConnections.erase(connection.getSocket());
+}
+
+void EventLoop::stopAccepting()
+{
+	post([this]()
+		{
+			for (SOCKET listener : mListeners)
+			{
+				unlisten(listener);
+				Socket::closeSocket(listener);
+			}
+			mListeners.clear();
+		});
+}
+
+void EventLoop::unlisten(SOCKET /*listener*/)
+{
+}
+
+void EventLoop::stop()
+{
+	mStopping = true;
+	wake();
+}
+
+void EventLoop::handOff()
+{
+	mHandingOff = true;
+	stop();
+}
+
+void EventLoop::release(vector<SOCKET>& listeners, vector<shared_ptr<Connection>>& connections)
+{
+	listeners.insert(listeners.end(), mListeners.begin(), mListeners.end());
+	mListeners.clear();
+	for (auto& it : mConnections)
+	{
+		connections.push_back(it.second);
+	}
+	mConnections.clear();
+}
+
+void EventLoop::setOutboundLimits(const size_t highWatermark, const size_t lowWatermark, const unsigned int evictAfterMs)
+{
+	mHighWatermark = highWatermark;
+	mLowWatermark = std::min(lowWatermark, highWatermark);
+	mEvictAfter = evictAfterMs;
+}
+
+unsigned int EventLoop::getQueueDelay() const
+{
+	return mQueueDelay;
+}
+
+string EventLoop::getPeerAddress(const Connection& connection) const
+{
+	return Socket::getPeerAddress(connection.getSocket());
+}
+
+void EventLoop::beginPass()
+{
+	steady_clock::time_point now = steady_clock::now();
+	// A wait that blocked means the loop ran out of work, nothing was queued behind it.
+	if (now - mPassEnd >= std::chrono::milliseconds(1)) mWindowMin = 0;
+	rollWindow(now);
+	mPassStart = now;
+}
+
+void EventLoop::endPass()
+{
+	mPassEnd = steady_clock::now();
+	unsigned int pass = (unsigned int)std::chrono::duration_cast<std::chrono::milliseconds>(mPassEnd - mPassStart).count();
+	mWindowMin = std::min(mWindowMin, pass);
+	rollWindow(mPassEnd);
+}
+
+void EventLoop::rollWindow(const steady_clock::time_point now)
+{
+	if (now - mWindowStart < std::chrono::milliseconds(QUEUE_DELAY_WINDOW_MS)) return;
+	mQueueDelay = mWindowMin == UINT_MAX ? 0 : mWindowMin;
+	mWindowMin = UINT_MAX;
+	mWindowStart = now;
+}
+
+void EventLoop::open(SOCKET client, TlsSession* tls)
+{
+	shared_ptr<Connection> connection = std::make_shared<Connection>(client, this);
+	connection->setTls(tls);
+	connection->setOutboundLimit(mHighWatermark);
+	mConnections[client] = connection;
+	watch(*connection);
+	mEvents->onOpen(*connection);
+	touch(*connection);
+	//A connection handed over by another process may come with requests and responses.
+	if (!connection->getInbound().empty() || connection->getUnsentBytes() != 0) drain(*connection);
+}
+
+void EventLoop::runTasks()
+{
+	vector<std::function<void()>> tasks;
+	{
+		std::lock_guard<mutex> lock(mTasksLock);
+		tasks.swap(mTasks);
+	}
+	for (auto& task : tasks)
+	{
+		task();
+	}
+}
+
+void EventLoop::acceptAll(SOCKET listener)
+{
+	SOCKET client;
+	while ((client = Socket::acceptClient(listener)) != INVALID_SOCKET)
+	{
+		mEvents->onAccept(*this, listener, client);
+	}
+}
+
+void EventLoop::handleReadable(shared_ptr<Connection> connection, const bool peerClosed)
+{
+	bool open = true;
+	bool full = true;
+	// A full inbound buffer is parsed before reading on; a backed up client is paused by the flush instead,
+	// an awaiting one stops until its request is done.
+	while (open && full && !connection->isClosed() && !connection->isReadStopped())
+	{
+		open = readAll(*connection, full) && (full || !peerClosed);
+		drain(*connection);
+	}
+	touch(*connection); //After onData, which may change the idle timeout.
+	if (!open) closeWhenReplied(*connection);
+}
+
+void EventLoop::setAwaiting(Connection& connection, const bool awaiting)
+{
+	connection.setAwaiting(awaiting);
+	// A paused connection reads again once checkBackpressure resumes it.
+	if (connection.isClosed() || connection.isReadPaused()) return;
+	setReading(connection, !awaiting);
+}
+
+void EventLoop::closeWhenReplied(Connection& connection)
+{
+	connection.setPeerClosed(true);
+	flush(connection); //The replies to its last requests are corked, they go before the close.
+	if (connection.isClosed()) return;
+	// A request suspended on a co_await or running on the workers still answers, the flush that writes its reply closes the connection.
+	mTimers.schedule(connection, mEvictAfter); //A peer that does not take the reply either is not waited for.
+	if (connection.isReadPaused()) return;
+	connection.setReadPaused(true);
+	setReading(connection, false);
+}
+
+void EventLoop::touch(Connection& connection)
+{
+	connection.setIdleStrikes(0);
+	if (connection.isClosed() || connection.isReadPaused()) return; //A paused connection keeps its eviction deadline.
+	if (connection.getIdleTimeout() == 0)
+	{
+		mTimers.cancel(connection);
+		return;
+	}
+	mTimers.schedule(connection, connection.getIdleTimeout());
+}
+
+void EventLoop::expireTimers()
+{
+	if (mTimers.empty()) return;
+	vector<TimerNode*> expired;
+	mTimers.advance(expired);
+	for (TimerNode* node : expired)
+	{
+		// Held, the callbacks may close it.
+		shared_ptr<Connection> connection = static_cast<Connection*>(node)->shared_from_this();
+		if (connection->isClosed()) continue;
+		if (connection->isReadPaused() || !mEvents->onIdle(*connection))
+		{
+			close(*connection);
+			continue;
+		}
+		connection->setIdleStrikes(connection->getIdleStrikes() + 1);
+		cork(*connection);
+		if (!connection->isClosed() && connection->getIdleTimeout() != 0)
+		{
+			mTimers.schedule(*connection, connection->getIdleTimeout());
+		}
+	}
+}
+
+size_t EventLoop::getPendingBytes(Connection& connection)
+{
+	return connection.getUnsentBytes();
+}
+
+void EventLoop::checkBackpressure(Connection& connection)
+{
+	if (mHighWatermark == 0 || connection.getOutboundLimit() == 0 || connection.isClosed()) return;
+	size_t pending = getPendingBytes(connection);
+	if (pending > mHighWatermark * OUTBOUND_HARD_LIMIT_FACTOR)
+	{
+		close(connection);
+		return;
+	}
+	if (pending <= mLowWatermark) mEvents->onDrained(connection);
+	if (!connection.isReadPaused() && pending >= mHighWatermark)
+	{
+		connection.setReadPaused(true);
+		setReading(connection, false);
+		mTimers.schedule(connection, mEvictAfter);
+	}
+	else if (connection.isReadPaused() && pending <= mLowWatermark && !mHandingOff && !connection.isPeerClosed())
+	{
+		connection.setReadPaused(false);
+		setReading(connection, !connection.isAwaiting());
+		touch(connection);
+		if (connection.getInbound().empty()) return;
+		// Requests that arrived before the pause are handled on the next iteration, not inside this flush.
+		std::weak_ptr<Connection> weak = connection.shared_from_this();
+		post([this, weak]()
+			{
+				shared_ptr<Connection> connection = weak.lock();
+				if (connection == nullptr) return;
+				drain(*connection);
+			});
+	}
+}
+
+void EventLoop::drain(Connection& connection)
+{
+	bool backedUp = true;
+	while (backedUp && !connection.isClosed() && !connection.isReadStopped())
+	{
+		if (!connection.getInbound().empty())
+		{
+			mEvents->onData(connection);
+		}
+		backedUp = connection.isBackedUp() && !connection.getInbound().empty();
+		if (connection.isClosed()) break;
+		if (backedUp)
+		{
+			flush(connection); //Pauses the connection if the replies did not fit, which ends the loop.
+		}
+		else
+		{
+			cork(connection); //Written with whatever else it gets this pass.
+		}
+	}
+}
+
+void EventLoop::closeAll()
+{
+	for (shared_ptr<Connection>& connection : mCorked)
+	{
+		connection->setCorked(false);
+	}
+	mCorked.clear(); //Everything is flushed below anyway.
+	if (mHandingOff)
+	{
+		detachAll();
+		return;
+	}
+	while (!mConnections.empty())
+	{
+		shared_ptr<Connection> connection = mConnections.begin()->second;
+		flush(*connection);
+		close(*connection);
+	}
+	for (SOCKET listener : mListeners)
+	{
+		Socket::closeSocket(listener);
+	}
+	mListeners.clear();
+}
+
+void EventLoop::detachAll()
+{
+	for (SOCKET listener : mListeners)
+	{
+		unlisten(listener);
+	}
+	vector<shared_ptr<Connection>> connections;
+	for (auto& it : mConnections)
+	{
+		connections.push_back(it.second);
+	}
+	for (shared_ptr<Connection>& connection : connections)
+	{
+		// The reply of a busy connection would come back to this process after it let go.
+		if (connection->getTls() != nullptr || connection->getLink() != nullptr || connection->isBusy())
+		{
+			close(*connection);
+			continue;
+		}
+		flush(*connection); //A failed write closes the connection, it is not handed over.
+		if (connection->isClosed()) continue;
+		mTimers.cancel(*connection);
+		unwatch(*connection);
+	}
+}
+
+shared_ptr<Connection> EventLoop::find(SOCKET socket)
+{
+	auto it = mConnections.find(socket);
+	return it == mConnections.end() ? nullptr : it->second;
+}
+
+bool EventLoop::readAll(Connection& connection, bool& full)
+{
+	static thread_local char records[TLS_RECORD_SIZE];
+	RingBuffer& inbound = connection.getInbound();
+	bool decrypts = connection.receivesRecords();
+	full = false;
+	while (true)
+	{
+		if (inbound.size() >= INBOUND_READ_LIMIT)
+		{
+			full = true;
+			return true;
+		}
+		char* space = records;
+		size_t len = decrypts ? sizeof(records) : inbound.prepare(space);
+		int res = Socket::receive(connection.getSocket(), space, (int)len);
+		if (res > 0)
+		{
+			if (!decrypts) inbound.commit(res);
+			else if (!connection.append(space, res)) return false;
+			if ((size_t)res < len) return true; //Drained, no need for another syscall.
+		}
+		else if (res == SOCKET_ERROR && Socket::wouldBlock())
+		{
+			return true;
+		}
+		else
+		{
+			return false;
+		}
+	}
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "IEventLoop.h"
+#include "TimerWheel.h"
+#include <map>
+#include <mutex>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+using std::map;
+using std::vector;
+using std::mutex;
+using std::shared_ptr;
+using std::chrono::steady_clock;
+
+#define OUTBOUND_HIGH_WATERMARK (1 << 20)
+#define OUTBOUND_LOW_WATERMARK (256 << 10)
+#define SLOW_CONSUMER_TIMEOUT_MS 10000
+#define OUTBOUND_HARD_LIMIT_FACTOR 4 // Pushes still queue while reads are paused, this caps them.
+#define INBOUND_READ_LIMIT (4 << 20) // Unparsed bytes read ahead per connection, above the largest frame so one always fits.
+#define QUEUE_DELAY_WINDOW_MS 100
+
+/****
+ * @brief The parts every readiness based loop shares.
+ *
+ * Holds the connection table and the cross-thread task queue and knows how to
+ * drain a readable socket and how to write an outbound queue. Subclasses only
+ * add the platform wait call (epoll on Linux, poll/WSAPoll elsewhere).
+ ****/
+class EventLoop : public IEventLoop
+{
+public:
+    /****
+     * @brief Constructs a loop that reports to the given protocol layer.
+     *
+     * @param events The receiver of connection callbacks.
+     ****/
+    EventLoop(IConnectionEvents* events);
+    virtual ~EventLoop() = default;
+
+    virtual void adopt(SOCKET client, TlsSession* tls = nullptr) override;
+    virtual void post(std::function<void()> task) override;
+    virtual void stopAccepting() override;
+    virtual void flush(Connection& connection) override;
+    virtual void cork(Connection& connection) override;
+    virtual void close(Connection& connection) override;
+    virtual void setAwaiting(Connection& connection, const bool awaiting) override;
+    virtual void stop() override;
+    virtual void handOff() override;
+    virtual void release(vector<SOCKET>& listeners, vector<shared_ptr<Connection>>& connections) override;
+    virtual void setOutboundLimits(const size_t highWatermark, const size_t lowWatermark, const unsigned int evictAfterMs) override;
+    virtual unsigned int getQueueDelay() const override;
+    virtual string getPeerAddress(const Connection& connection) const override;
+
+protected:
+    /****
+     * @brief Starts watching a newly registered connection.
+     *
+     * @param connection The connection to watch.
+     ****/
+    virtual void watch(Connection& connection) = 0;
+
+    /****
+     * @brief Stops watching a connection that is about to be closed.
+     *
+     * @param connection The connection to forget.
+     ****/
+    virtual void unwatch(Connection& connection) = 0;
+
+    /****
+     * @brief Stops watching a listener that is about to be closed. Closing is enough for
+     * readiness based loops, so the default does nothing.
+     *
+     * @param listener The listening socket.
+     ****/
+    virtual void unlisten(SOCKET listener);
+
+    /****
+     * @brief Interrupts the platform wait call so posted tasks run.
+     ****/
+    virtual void wake() = 0;
+
+    /****
+     * @brief Stops or restarts reading from a connection, for backpressure.
+     *
+     * @param connection The connection.
+     * @param reading Whether to read from it.
+     ****/
+    virtual void setReading(Connection& connection, const bool reading) = 0;
+
+    /****
+     * @returns The bytes queued for a connection and not written yet.
+     ****/
+    virtual size_t getPendingBytes(Connection& connection);
+
+    /****
+     * @brief Pauses or resumes reading from a connection by the watermarks of its pending bytes,
+     * and evicts it past the hard limit. Called after every flush.
+     *
+     * @param connection The connection.
+     ****/
+    void checkBackpressure(Connection& connection);
+
+    /****
+     * @brief Hands the inbound bytes to the events and flushes the replies, again while the client
+     * was only backed up and the flush made room, until the buffer runs dry or reading is paused.
+     *
+     * @param connection The connection.
+     ****/
+    void drain(Connection& connection);
+
+    /****
+     * @brief Flushes every connection corked during the pass. Subclasses call it before they wait.
+     ****/
+    void uncork();
+
+    /****
+     * @brief Runs every task posted so far.
+     ****/
+    void runTasks();
+
+    /****
+     * @brief Accepts every pending connection of a listener.
+     *
+     * @param listener The listening socket that became readable.
+     ****/
+    void acceptAll(SOCKET listener);
+
+    /****
+     * @brief Handles a readable socket: drains it, lets the protocol layer parse it and flushes the replies.
+     *
+     * @param connection The readable connection.
+     * @param peerClosed Whether the peer already shut down its side, the connection is closed after the replies are written.
+     ****/
+    void handleReadable(shared_ptr<Connection> connection, const bool peerClosed);
+
+    /****
+     * @brief Closes a connection whose peer shut down its side once its replies are written.
+     * While it is busy, reading stops and the flush of the last reply closes it instead.
+     *
+     * @param connection The connection.
+     ****/
+    void closeWhenReplied(Connection& connection);
+
+    /****
+     * @brief Restarts the idle deadline of a connection that showed activity. O(1).
+     *
+     * @param connection The connection.
+     ****/
+    void touch(Connection& connection);
+
+    /****
+     * @brief Raises IConnectionEvents::onIdle for every connection whose deadline passed,
+     * closing the ones it gives up on. Subclasses call it on every iteration.
+     ****/
+    void expireTimers();
+
+    /****
+     * @brief Marks the start of a pass over the ready events. Subclasses call it when their wait returns.
+     ****/
+    void beginPass();
+
+    /****
+     * @brief Measures the pass that began last towards the queue delay. Subclasses call it before they wait.
+     ****/
+    void endPass();
+
+    /****
+     * @brief Writes what it can of every outbound queue and closes every connection, used when the loop stops.
+     * After handOff() it detaches them instead.
+     ****/
+    void closeAll();
+
+    /****
+     * @brief Writes what it can of every outbound queue and stops watching the listeners and the
+     * connections, leaving them open for release(). TLS connections are closed, their session
+     * state cannot move to another process, and so are gateway links with their sessions and the
+     * connections with a request awaiting or on the workers, whose reply would come back here.
+     ****/
+    virtual void detachAll();
+
+    /****
+     * @brief Finds a connection by its socket.
+     *
+     * @returns The connection or nullptr.
+     ****/
+    shared_ptr<Connection> find(SOCKET socket);
+
+    IConnectionEvents* mEvents;
+    std::atomic<std::thread::id> mThreadId; // Set by run(), adopt() skips the task queue on this thread.
+    map<SOCKET, shared_ptr<Connection>> mConnections;
+    TimerWheel mTimers; // Idle deadlines of the connections, eviction deadlines of the paused ones.
+    size_t mHighWatermark;
+    size_t mLowWatermark;
+    unsigned int mEvictAfter;
+    steady_clock::time_point mPassStart;
+    steady_clock::time_point mPassEnd;
+    steady_clock::time_point mWindowStart;
+    unsigned int mWindowMin; // Shortest pass of the current window, in milliseconds.
+    unsigned int mQueueDelay; // Shortest pass of the last full window.
+    vector<SOCKET> mListeners;
+    vector<shared_ptr<Connection>> mCorked; // Flushed by uncork(), each one once.
+    std::atomic<bool> mStopping;
+    std::atomic<bool> mHandingOff; // Stopping for a hot upgrade, connections are detached, not closed.
+
+private:
+    /****
+     * @brief Registers an accepted socket and raises IConnectionEvents::onOpen.
+     *
+     * @param client The accepted socket.
+     * @param tls Its TLS state, or nullptr.
+     ****/
+    void open(SOCKET client, TlsSession* tls);
+
+    /****
+     * @brief Reads everything the socket has straight into the inbound ring buffer,
+     * up to INBOUND_READ_LIMIT unparsed bytes. TLS records are read into a buffer
+     * of their own and decrypted into it.
+     *
+     * @param full Set when the read stopped at the limit, the socket may have more.
+     * @returns False if the peer closed the connection or the read failed.
+     ****/
+    bool readAll(Connection& connection, bool& full);
+
+    /****
+     * @brief Publishes the shortest pass as the queue delay once the window is over and starts the next one.
+     ****/
+    void rollWindow(const steady_clock::time_point now);
+
+    mutex mTasksLock;
+    vector<std::function<void()>> mTasks;
+};
@@ -0,0 +1,50 @@
+#include "FrameParser.h"
+
+/*
+* Reads a four bytes little endian number.
+*/
+static unsigned int readInt(const unsigned char* bytes)
+{
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+}
+
+FrameParser::Result FrameParser::next(RingBuffer& inbound, RequestInfo& request, ClientLimits* limits)
+{
+	if (inbound.size() < FRAME_HEADER_SIZE) return INCOMPLETE;
+
+	unsigned char header[MAX_HEADER_SIZE];
+	inbound.peek(0, (char*)header, FRAME_HEADER_SIZE);
+	size_t headerSize = FRAME_HEADER_SIZE;
+	if (header[0] & REQUEST_ID_FLAG) headerSize += REQUEST_ID_SIZE;
+	if (header[0] & VERSION_FLAG) headerSize += VERSION_SIZE;
+	unsigned int len = readInt(header + 1);
+	if (len > MAX_MESSAGE_SIZE) return OVERSIZED;
+	if (inbound.size() < headerSize || inbound.size() - headerSize < len) return INCOMPLETE; //Rest of the message didn't arrive yet.
+
+	request.code = header[0] & CODE_MASK;
+	request.hasRequestId = (header[0] & REQUEST_ID_FLAG) != 0;
+	request.hasVersion = (header[0] & VERSION_FLAG) != 0;
+	request.requestId = 0;
+	request.version = NO_VERSION;
+	inbound.peek(FRAME_HEADER_SIZE, (char*)header + FRAME_HEADER_SIZE, headerSize - FRAME_HEADER_SIZE);
+	size_t at = FRAME_HEADER_SIZE;
+	if (request.hasRequestId)
+	{
+		request.requestId = readInt(header + at);
+		at += REQUEST_ID_SIZE;
+	}
+	if (request.hasVersion)
+	{
+		request.version = readInt(header + at);
+	}
+	if (!RateLimiter::getInstance()->take(limits, request.code))
+	{
+		request.data.clear();
+		inbound.consume(headerSize + len);
+		return RATE_LIMITED;
+	}
+	inbound.peek(headerSize, request.data, len);
+	std::time(&request.receivalTime);
+	inbound.consume(headerSize + len);
+	return COMPLETE;
+}
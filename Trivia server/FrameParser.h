@@ -0,0 +1,36 @@
+#pragma once
+
+#include "RingBuffer.h"
+#include "CommunicationStructs.h"
+#include "Packet.h"
+#include "RateLimiter.h"
+
+#define MAX_MESSAGE_SIZE (1 << 20)
+
+/****
+ * @brief Cuts the received byte stream into [code][len][payload] frames,
+ * or [code | REQUEST_ID_FLAG | VERSION_FLAG][len][id][version][payload] frames of the
+ * request ID and version extensions (either field is only there if its flag is set).
+ *
+ * A read can end anywhere: in the middle of a header, of a body, or after
+ * several frames. The parser only takes a frame once all of it arrived and
+ * leaves the rest in the buffer for the next read.
+ ****/
+class FrameParser
+{
+public:
+    enum Result { COMPLETE, INCOMPLETE, OVERSIZED, RATE_LIMITED };
+
+    /****
+     * @brief Takes the next complete frame from the front of the buffer.
+     *
+     * @param inbound The received bytes, the frame is consumed from it.
+     * @param request Receives the code and body. Its buffers are reused, so keeping
+     * one RequestInfo across calls avoids an allocation per message.
+     * @param limits The rate limit buckets of the connection, nullptr for none.
+     * @returns COMPLETE if a frame was taken, INCOMPLETE if more bytes are needed,
+     * OVERSIZED if the declared length is above MAX_MESSAGE_SIZE (the stream cannot be trusted anymore),
+     * RATE_LIMITED if the frame was dropped by its header, request then has no body.
+     ****/
+    static Result next(RingBuffer& inbound, RequestInfo& request, ClientLimits* limits = nullptr);
+};
@@ -1,10 +1,19 @@
 #include "Game.h"
+#include "VersionCounter.h"
+#include "NotificationCenter.h"
+#include "JsonResponsePacketSerializer.h"
+#include "StatisticsManager.h"
 
 Game::Game(const vector<Question>& questions, const unsigned int gameId)
 {
 	mQuestions = questions;
 	mGameId = gameId;
 	mDataBase = SqliteDataBase::getInstance();
+	mRound = 0;
+	mSynced = true;
+	mOver = false;
+	mVersion = VersionCounter::next();
+	mHandlers = 0;
 }
 
 Question& Game::getQuestionForUser(const LoggedUser& user)
@@ -39,17 +48,21 @@ int Game::submitAnswer(const unsigned int id, const LoggedUser& user, const unsi
 	{
 		submitGameStatsToDB(mPlayers.at(user), user);
 	}
-	return mQuestions[mPlayers.at(user).currentQuestion++].getCorrectAnswerId();
+	int correctId = mQuestions[mPlayers.at(user).currentQuestion++].getCorrectAnswerId();
+	updatePhase();
+	return correctId;
 }
 
 void Game::removePlayer(const LoggedUser& user)
 {
 	mPlayers[user].HasRetired = 1;
+	updatePhase();
 }
 
 void Game::addPlayer(const LoggedUser& user)
 {
 	mPlayers[user] = GameData();
+	updatePhase();
 }
 
 unsigned int Game::getGameId() const
@@ -57,6 +70,11 @@ unsigned int Game::getGameId() const
 	return mGameId;
 }
 
+unsigned int Game::getVersion() const
+{
+	return mVersion;
+}
+
 vector<PlayerResults> Game::getResults()
 {
 	vector<PlayerResults> results;
@@ -84,24 +102,38 @@ bool Game::isFinished() const
 	return true;
 }
 
-bool Game::nextQuestion()
+void Game::submitUnfinished()
 {
-	if (mPlayers.size() < 1) return true;
-	int currQuestion = 0;
-	for (auto it = mPlayers.begin(); it != mPlayers.end(); it++)
+	for (auto& it : mPlayers)
 	{
-		currQuestion = it->second.currentQuestion;
-		if (!it->second.HasRetired) 
+		if (it.second.HasRetired || it.second.currentQuestion >= mQuestions.size()) continue;
+		if (it.second.currentQuestion > 0)
 		{
-			break;
+			submitGameStatsToDB(it.second, it.first);
 		}
+		it.second.HasRetired = 1;
 	}
-	for (auto& it : mPlayers)
-	{
-		if (it.second.HasRetired) continue;
-		if (it.second.currentQuestion != currQuestion) return false;
-	}
-	return true;
+	updatePhase();
+}
+
+void Game::retain()
+{
+	mHandlers++;
+}
+
+void Game::release()
+{
+	mHandlers--;
+}
+
+bool Game::isReferenced() const
+{
+	return mHandlers > 0;
+}
+
+bool Game::nextQuestion()
+{
+	return mSynced;
 }
 
 bool Game::operator==(const Game& other)
@@ -112,4 +144,84 @@ bool Game::operator==(const Game& other)
 void Game::submitGameStatsToDB(const GameData& gameData, const LoggedUser& user)
 {
 	mDataBase->submitGameStatistics(gameData, user.getUsername(), mGameId);
+	StatisticsManager::getInstance()->markChanged();
+}
+
+void Game::updatePhase()
+{
+	mVersion = VersionCounter::next();
+	//Find the question of the first active player and check that everyone else is on it.
+	bool synced = true;
+	bool found = false;
+	unsigned int currQuestion = 0;
+	for (auto& it : mPlayers)
+	{
+		if (it.second.HasRetired) continue;
+		if (!found)
+		{
+			currQuestion = it.second.currentQuestion;
+			found = true;
+		}
+		else if (it.second.currentQuestion != currQuestion)
+		{
+			synced = false;
+			break;
+		}
+	}
+	mSynced = synced;
+	if (mOver || !synced) return;
+
+	bool revealed = found && currQuestion > mRound;
+	bool over = isFinished() && !mPlayers.empty();
+	if (!revealed && !over) return;
+
+	NotificationCenter* center = NotificationCenter::getInstance();
+	vector<string> users = getActivePlayers();
+	Notification notification;
+	notification.topic = GAME_TOPIC;
+	notification.gameId = mGameId;
+	bool subscribed = center->hasSubscribers(users, GAME_TOPIC);
+
+	if (revealed)
+	{
+		mRound = currQuestion;
+		if (subscribed)
+		{
+			AnswerRevealedEvent event{ mGameId, mRound - 1, (unsigned int)mQuestions.at(mRound - 1).getCorrectAnswerId() };
+			notification.packet = std::make_shared<const Packet>(JsonResponsePacketSerializer::serializeResponse(event));
+			center->publish(users, notification);
+		}
+	}
+	if (over)
+	{
+		mOver = true;
+		if (subscribed)
+		{
+			GameOverEvent event{ mGameId, GetGameResultsResponse{ SUCCESS, getResults() } };
+			notification.packet = std::make_shared<const Packet>(JsonResponsePacketSerializer::serializeResponse(event));
+			center->publish(users, notification);
+		}
+	}
+	else if (revealed && subscribed)
+	{
+		Question& question = mQuestions.at(mRound);
+		vector<string> answers = question.getPossibleAnswers();
+		NextQuestionEvent event{ mGameId, mRound, GetQuestionResponse{ SUCCESS, question.getQuestion(), {} } };
+		for (size_t i = 0; i < answers.size(); ++i)
+		{
+			event.question.answers[i] = answers[i];
+		}
+		notification.packet = std::make_shared<const Packet>(JsonResponsePacketSerializer::serializeResponse(event));
+		center->publish(users, notification);
+	}
+}
+
+vector<string> Game::getActivePlayers() const
+{
+	vector<string> users;
+	for (auto& it : mPlayers)
+	{
+		if (!it.second.HasRetired) users.push_back(it.first.getUsername());
+	}
+	return users;
 }
@@ -63,6 +63,18 @@ public:
 
 	unsigned int getGameId() const; //getter
 
+	/**
+	* @brief Counts a handler that points at the game, released by its destructor.
+	*
+	* The game manager keeps a finished game while one is left, so a player whose session is
+	* parked still reads the results when it resumes. Called under the handlers' lock.
+	*/
+	void retain();
+	void release();
+	bool isReferenced() const; //getter
+
+	unsigned int getVersion() const; //Grows whenever a player answers, joins or retires.
+
 	/**
 	* @brief Generates a vector containing player results (username, correct answers, wrong answers, average answer time, retired flag).
 	* @return A vector of `PlayerResults` objects for each player in the game.
@@ -80,11 +92,19 @@ public:
 	*/
 	bool isFinished() const;
 
+	/**
+	* @brief Ends the game for the players that are still playing, used when the server shuts down.
+	*
+	* Their scores so far are saved like those of a player who answered every question,
+	* then they count as retired and the game is over.
+	*/
+	void submitUnfinished();
+
 	/**
 	* @brief Checks if all players are on the same question and can proceed to the next one.
 	* @return True if all active players are on the same question, false otherwise.
 	*
-	* This method iterates through the `mPlayers` map and checks if all non-retired players are on the same question (based on their `currentQuestion` value). If all active players are on the same question, true is returned, indicating it's safe to proceed to the next question. Otherwise, false is returned.
+	* The answer is kept up to date by `updatePhase` whenever a player moves, so repeated calls don't scan the players.
 	*/
 	bool nextQuestion();
 
@@ -97,10 +117,29 @@ public:
 	*/
 	bool operator==(const Game& other);
 private:
+	friend class Snapshot; //Saves and restores the state for a hot upgrade.
 	vector<Question> mQuestions; //Game's questions
 	map<LoggedUser, GameData> mPlayers; //Current players' states
 	unsigned int mGameId;
 	IDataBase* mDataBase; //DB handler instance
+	unsigned int mRound; //Number of questions every active player answered, their answers were revealed
+	bool mSynced; //All active players are on the same question
+	bool mOver; //The game over event was published
+	unsigned int mVersion; //Version of the players' progress
+	unsigned int mHandlers; //Game handlers that point at the game, see retain()
+
+	/**
+	* @brief Recalculates the phase of the game after a player answered, joined or retired.
+	*
+	* When the last active player answers the current question, pushes its answer and then
+	* either the next question or, after the last one, the results to the players that subscribed to "game".
+	*/
+	void updatePhase();
+
+	/**
+	* @brief Gets the usernames of the players that did not retire.
+	*/
+	vector<string> getActivePlayers() const;
 
 	/**
 	* @brief Submits game statistics for a user to the database using the SqliteDataBase object.
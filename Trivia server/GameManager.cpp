@@ -38,46 +38,95 @@ void GameManager::deleteGame(const unsigned int gameId)
     {
         if (it->getGameId() == gameId)
         {
+            mFinishedAt.erase(gameId);
             mGames.erase(it);
             break;
         }
     }
 }
 
-std::thread GameManager::startRemoveFinishedGames()
+std::thread GameManager::startRemoveFinishedGames(std::mutex& lock)
 {
-    return std::thread(&GameManager::removeFinishedGames, this);
+    mStopReaping = false;
+    return std::thread(&GameManager::removeFinishedGames, this, std::ref(lock));
 }
 
-void GameManager::removeFinishedGames()
+void GameManager::stopRemovingFinishedGames()
+{
+    {
+        std::lock_guard<std::mutex> guard(mReaperLock);
+        mStopReaping = true;
+    }
+    mReaperWake.notify_all();
+}
+
+bool GameManager::hasRunningGames() const
+{
+    for (const Game& game : mGames)
+    {
+        if (!game.isFinished())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GameManager::submitUnfinishedGames()
+{
+    for (Game& game : mGames)
+    {
+        if (!game.isFinished())
+        {
+            game.submitUnfinished();
+        }
+    }
+}
+
+void GameManager::removeFinishedGames(std::mutex& lock)
 {
     RoomManager* roomManager = RoomManager::getInstance();
-    while (true) {
-        if (mGames.size() > 0)
+    while (true)
+    {
         {
-            for (int i = 0; i < mGames.size();) 
+            std::unique_lock<std::mutex> wait(mReaperLock);
+            if (mReaperWake.wait_for(wait, std::chrono::seconds(REAP_INTERVAL), [this]() { return mStopReaping; })) return;
+        }
+        {
+            //Deleting a room publishes its CLOSED state and bumps the room versions, like the handlers do under this lock.
+            std::lock_guard<std::mutex> guard(lock);
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            for (auto it = mGames.begin(); it != mGames.end();)
             {
-                if(mGames.at(i).isFinished())
+                if (!it->isFinished())
                 {
-                    std::this_thread::sleep_for(std::chrono::seconds(10)); //Let the users take game results before game is freed.
-                    roomManager->deleteRoom(mGames.at(i).getGameId());
-                    mGames.erase(mGames.begin() + i);
+                    it++;
+                    continue;
                 }
-                else
+                auto finished = mFinishedAt.try_emplace(it->getGameId(), now).first;
+                if (now - finished->second < std::chrono::seconds(GAME_RESULTS_DELAY)) //Let the users take game results before game is freed.
                 {
-                    i++;
+                    it++;
+                    continue;
                 }
-
+                roomManager->deleteRoom(it->getGameId()); //Does nothing once the room is gone.
+                //A player that did not take the results yet, or whose session is parked, still points at the game.
+                if (it->isReferenced())
+                {
+                    it++;
+                    continue;
+                }
+                mFinishedAt.erase(finished);
+                it = mGames.erase(it);
             }
-
         }
-        std::this_thread::sleep_for(std::chrono::seconds(10));
     }
 }
 
 GameManager::GameManager()
 {
     mDataBase = SqliteDataBase::getInstance();
+    mStopReaping = false;
 }
 
 GameManager::~GameManager()
@@ -5,6 +5,13 @@
 #include "IDatabase.h"
 #include <thread>
 #include <chrono>
+#include <list>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+
+#define REAP_INTERVAL 10 // Seconds between passes over the finished games.
+#define GAME_RESULTS_DELAY 10 // Seconds a finished game is kept so the players can take its results.
 
 /****
  * @brief The GameManager class is responsible for managing game instances.
@@ -58,17 +65,38 @@ public:
      *
      * This method spawns a new thread that continuously checks for finished games and removes them.
      *
+     * @param lock The lock the handlers use the games under, held during each pass.
      * @returns A std::thread object running the removeFinishedGames method.
      ****/
-    std::thread startRemoveFinishedGames();
+    std::thread startRemoveFinishedGames(std::mutex& lock);
+
+    /****
+     * @brief Stops the thread of startRemoveFinishedGames, which returns right away or after its current pass.
+     *
+     * Join it afterwards, without holding the lock it was started with.
+     ****/
+    void stopRemovingFinishedGames();
+    /****
+     * @brief Checks whether any game still has players that did not answer every question.
+     *
+     * @returns True if a game is running.
+     ****/
+    bool hasRunningGames() const;
+    /****
+     * @brief Ends every running game, saving the scores of the players that are still in it.
+     ****/
+    void submitUnfinishedGames();
 
 private:
+    friend class Snapshot; //Saves and restores the state for a hot upgrade.
     /****
      * @brief Periodically removes finished games from the game list.
      *
-     * This method continuously checks the game list and removes games that have finished.
+     * This method continuously checks the game list and removes games that finished
+     * GAME_RESULTS_DELAY seconds ago and that no game handler points at anymore.
+     * Each pass holds the lock, the waits between them do not.
      ****/
-    void removeFinishedGames();
+    void removeFinishedGames(std::mutex& lock);
 
     /****
      * @brief Private constructor to enforce singleton pattern.
@@ -85,6 +113,10 @@ private:
     ~GameManager();
 
     IDataBase* mDataBase;             ///< Pointer to the database instance.
-    vector<Game> mGames;              ///< List of active games.
+    std::list<Game> mGames;           ///< List of active games, a list so the handlers' Game pointers stay valid.
+    std::map<unsigned int, std::chrono::steady_clock::time_point> mFinishedAt; ///< When a pass first saw a game finished, by game ID.
+    std::mutex mReaperLock;           ///< Guards mStopReaping.
+    std::condition_variable mReaperWake; ///< Wakes the reaper early when it is stopped.
+    bool mStopReaping;                ///< stopRemovingFinishedGames() was called.
     static GameManager* instancePtr;  ///< Pointer to the singleton instance.
 };
\ No newline at end of file
@@ -1,10 +1,12 @@
 #include "GameRequestHandler.h"
 #include "JsonResponsePacketSerializer.h"
 #include "JsonRequestPacketDeserializer.h"
+#include "PollAdvisor.h"
 GameRequestHandler::GameRequestHandler(Game* game, const LoggedUser& user, const unsigned int answerTimeOut)
 {
 	mGame = game;
 	mGame->addPlayer(user);
+	mGame->retain();
 	mUser = user;
 	mGameManager = GameManager::getInstance();
 	mFacroty = RequestHandlerFactory::getInstance();
@@ -14,6 +16,11 @@ GameRequestHandler::GameRequestHandler(Game* game, const LoggedUser& user, const
 	mAnswered = false;
 }
 
+GameRequestHandler::~GameRequestHandler()
+{
+	mGame->release();
+}
+
 bool GameRequestHandler::isRequestRelevant(const RequestInfo& reqInfo)
 {
 	switch (reqInfo.code)
@@ -28,7 +35,7 @@ bool GameRequestHandler::isRequestRelevant(const RequestInfo& reqInfo)
 	};
 }
 
-RequestResult GameRequestHandler::handleRequest(const RequestInfo& reqInfo)
+Task<RequestResult> GameRequestHandler::handleRequest(const RequestInfo& reqInfo)
 {
 	switch (reqInfo.code)
 	{
@@ -44,6 +51,38 @@ RequestResult GameRequestHandler::handleRequest(const RequestInfo& reqInfo)
 	return RequestResult();
 }
 
+unsigned int GameRequestHandler::getVersion(const RequestInfo& reqInfo)
+{
+	return reqInfo.code == GET_QUESTION_REQUEST ? mGame->getVersion() : NO_VERSION;
+}
+
+unsigned int GameRequestHandler::getPollInterval(const RequestInfo& reqInfo)
+{
+	return reqInfo.code == SUBMIT_ANSWER_REQUEST ? PollAdvisor::getInstance()->forGame() : NO_POLL_HINT;
+}
+
+IRequestHandler* GameRequestHandler::applyPhase(const unsigned char code)
+{
+	switch (code)
+	{
+	case NEXT_QUESTION_EVENT:
+		//The question was pushed, it counts as asked now.
+		mAnswered = false;
+		mLastTime = std::chrono::steady_clock::now();
+		return this;
+	case GAME_OVER_EVENT:
+		//The results were pushed, the player is back in the menu.
+		mLastRequest = true;
+		return mFacroty->createMenuRequestHandler(mUser);
+	}
+	return this;
+}
+
+unsigned int GameRequestHandler::getGameId() const
+{
+	return mGame->getGameId();
+}
+
 RequestResult GameRequestHandler::getQuestion(RequestInfo info)
 {
 	mAnswered = false;
@@ -96,7 +135,7 @@ RequestResult GameRequestHandler::submitAnswer(RequestInfo info)
 		status = FAILURE;
 		idToSend = FALSE_ID;
 	}
-	SubmitAnswerResponse response{ status, id };
+	SubmitAnswerResponse response{ status, id, status == SUCCESS ? NO_POLL_HINT : getPollInterval(info) };
 	return RequestResult{ JsonResponsePacketSerializer::serializeResponse(response), this };
 }
 
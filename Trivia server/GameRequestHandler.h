@@ -14,6 +14,10 @@ class GameRequestHandler : public IRequestHandler
 public:
 	GameRequestHandler(Game* game, const LoggedUser& user, const unsigned int answerTimeOut);
 	/**
+	* Releases the game, which the game manager may free once no handler points at it anymore.
+	*/
+	virtual ~GameRequestHandler();
+	/**
 	* Determines if a request is relevant to the current handler.
 	*
 	* This virtual function allows a handler to specify the types of requests
@@ -36,9 +40,39 @@ public:
 	* @param reqInfo A reference to a RequestInfo object containing information about the request.
 	* @return A RequestResult object containing the response data and potentially the next handler.
 	*/
-	virtual RequestResult handleRequest(const RequestInfo& reqInfo) override;
+	virtual Task<RequestResult> handleRequest(const RequestInfo& reqInfo) override;
+
+	/**
+	* Gets the version of the state a read request returns.
+	*
+	* @param reqInfo A reference to a RequestInfo object containing information about the request.
+	* @return The current version, or NO_VERSION if the request is not versioned.
+	*/
+	virtual unsigned int getVersion(const RequestInfo& reqInfo) override;
+
+	/**
+	* Gets how long a client should wait before it polls a request again.
+	*
+	* @param reqInfo A reference to a RequestInfo object containing information about the request.
+	* @return The interval in milliseconds, or NO_POLL_HINT if the request is not polled.
+	*/
+	virtual unsigned int getPollInterval(const RequestInfo& reqInfo) override;
+
+	/**
+	* @brief Applies a pushed game phase event to this player.
+	* @param code NEXT_QUESTION_EVENT starts the answer timer of the new question, GAME_OVER_EVENT ends the game.
+	* @return The next handler, a new menu handler once the game is over, this handler otherwise.
+	*/
+	IRequestHandler* applyPhase(const unsigned char code);
+
+	unsigned int getGameId() const; //getter
 
 private:
+	friend class Snapshot; //Saves and restores the state for a hot upgrade.
+	/**
+	* @brief Leaves every member unset, Snapshot fills them in and retains the game without adding the player to it again.
+	*/
+	GameRequestHandler() = default;
 
 	/**
 	* @brief Handles a request to get a question for the current user.
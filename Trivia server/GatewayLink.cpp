@@ -0,0 +1,207 @@
+#include "GatewayLink.h"
+#include "FrameParser.h"
+#include "EventLoop.h"
+#include <algorithm>
+
+/*
+* Reads a four bytes little endian number.
+*/
+static unsigned int readInt(const unsigned char* bytes)
+{
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((unsigned int)bytes[3] << 24);
+}
+
+GatewayLink::GatewayLink(IConnectionEvents* events, Connection& link)
+{
+	mEvents = events;
+	mLoop = link.getLoop();
+	mLink = link.shared_from_this();
+}
+
+bool GatewayLink::receive()
+{
+	// One frame per loop thread, like the requests of the clients.
+	static thread_local RequestInfo frame;
+	std::shared_ptr<Connection> link = mLink.lock();
+	if (link == nullptr) return true;
+	FrameParser::Result result;
+	while (!link->isClosed() && (result = FrameParser::next(link->getInbound(), frame)) != FrameParser::INCOMPLETE)
+	{
+		if (result == FrameParser::OVERSIZED) return false;
+		if (frame.code == LINK_OPEN)
+		{
+			open(frame.requestId, frame.data);
+			continue;
+		}
+		auto it = mSessions.find(frame.requestId);
+		//A session the server closed, the gateway did not see its LINK_CLOSE yet.
+		if (it == mSessions.end()) continue;
+		std::shared_ptr<Connection> session = it->second.connection;
+		if (frame.code == LINK_CLOSE)
+		{
+			drop(*session, false);
+			continue;
+		}
+		if (frame.code == LINK_ACK)
+		{
+			if (frame.data.size() == 4) acknowledge(*session, readInt((const unsigned char*)frame.data.data()));
+			continue;
+		}
+		if (frame.code != LINK_DATA) continue;
+		//A backed up session buffers what its client sends on. The loops would stop reading such a
+		//client at INBOUND_READ_LIMIT, a link cannot stop for one session, so it is closed there.
+		if (session->getInbound().size() + frame.data.size() > INBOUND_READ_LIMIT)
+		{
+			drop(*session, true);
+			continue;
+		}
+		session->getInbound().write(frame.data.data(), frame.data.size());
+		mEvents->onData(*session);
+		if (!session->isClosed()) cork(*session);
+	}
+	return true;
+}
+
+void GatewayLink::closeAll()
+{
+	while (!mSessions.empty())
+	{
+		std::shared_ptr<Connection> session = mSessions.begin()->second.connection;
+		drop(*session, false);
+	}
+}
+
+void GatewayLink::open(const unsigned int session, const string& address)
+{
+	if (mSessions.count(session)) return;
+	std::shared_ptr<Connection> link = mLink.lock();
+	std::shared_ptr<Connection> connection = std::make_shared<Connection>(link->getSocket(), this);
+	//Responses only pile up in the session while its window is used up.
+	connection->setOutboundLimit(LINK_WINDOW);
+	mSessions[session] = Session{ connection, address, 0 };
+	mIds[connection.get()] = session;
+	mEvents->onOpen(*connection);
+}
+
+void GatewayLink::drop(Connection& connection, const bool notify)
+{
+	if (connection.isClosed()) return;
+	connection.markClosed();
+	mEvents->onClose(connection);
+	auto id = mIds.find(&connection);
+	if (id == mIds.end()) return;
+	unsigned int session = id->second;
+	mIds.erase(id);
+	//The session may be the last owner of the connection.
+	std::shared_ptr<Connection> keep = mSessions[session].connection;
+	mSessions.erase(session);
+	std::shared_ptr<Connection> link = mLink.lock();
+	if (!notify || link == nullptr || link->isClosed()) return;
+	link->getOutbound().pushBytes(linkHeader(LINK_CLOSE, session, 0));
+	mLoop->cork(*link);
+}
+
+void GatewayLink::acknowledge(Connection& connection, const unsigned int bytes)
+{
+	auto id = mIds.find(&connection);
+	if (id == mIds.end()) return;
+	size_t& inFlight = mSessions[id->second].inFlight;
+	inFlight -= std::min(inFlight, (size_t)bytes);
+	flush(connection);
+	if (!connection.isClosed() && !connection.getInbound().empty()) mEvents->onData(connection);
+	if (!connection.isClosed()) cork(connection);
+}
+
+void GatewayLink::addListener(SOCKET /*listener*/)
+{
+}
+
+void GatewayLink::stopAccepting()
+{
+}
+
+void GatewayLink::adopt(SOCKET /*client*/, TlsSession* /*tls*/)
+{
+}
+
+void GatewayLink::post(std::function<void()> task)
+{
+	mLoop->post(std::move(task));
+}
+
+void GatewayLink::flush(Connection& connection)
+{
+	OutboundQueue& outbound = connection.seal();
+	std::shared_ptr<Connection> link = mLink.lock();
+	auto id = mIds.find(&connection);
+	if (outbound.empty() || link == nullptr || link->isClosed() || id == mIds.end()) return;
+	size_t& inFlight = mSessions[id->second].inFlight;
+	if (inFlight >= LINK_WINDOW) return;
+	size_t len = outbound.size();
+	inFlight += len;
+	if (len <= MAX_MESSAGE_SIZE)
+	{
+		link->getOutbound().pushBytes(linkHeader(LINK_DATA, id->second, len));
+		link->getOutbound().append(outbound);
+	}
+	else
+	{
+		//Rare: only a large batch response, cut into frames the gateway accepts.
+		string bytes = outbound.copyBytes();
+		outbound.advance(len);
+		for (size_t at = 0; at < len; at += MAX_MESSAGE_SIZE)
+		{
+			size_t part = std::min((size_t)MAX_MESSAGE_SIZE, len - at);
+			link->getOutbound().pushBytes(linkHeader(LINK_DATA, id->second, part) + bytes.substr(at, part));
+		}
+	}
+	mLoop->cork(*link);
+}
+
+void GatewayLink::cork(Connection& connection)
+{
+	//The link is corked, so moving the bytes now still sends them once per pass.
+	flush(connection);
+}
+
+void GatewayLink::close(Connection& connection)
+{
+	drop(connection, true);
+}
+
+void GatewayLink::setAwaiting(Connection& connection, const bool awaiting)
+{
+	connection.setAwaiting(awaiting);
+}
+
+void GatewayLink::setOutboundLimits(const size_t /*highWatermark*/, const size_t /*lowWatermark*/, const unsigned int /*evictAfterMs*/)
+{
+}
+
+unsigned int GatewayLink::getQueueDelay() const
+{
+	return mLoop->getQueueDelay();
+}
+
+string GatewayLink::getPeerAddress(const Connection& connection) const
+{
+	auto id = mIds.find(&connection);
+	if (id == mIds.end()) return string();
+	return mSessions.at(id->second).address;
+}
+
+void GatewayLink::run()
+{
+}
+
+void GatewayLink::stop()
+{
+}
+
+void GatewayLink::handOff()
+{
+}
+
+void GatewayLink::release(std::vector<SOCKET>& /*listeners*/, std::vector<std::shared_ptr<Connection>>& /*connections*/)
+{
+}
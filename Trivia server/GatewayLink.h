@@ -0,0 +1,135 @@
+#pragma once
+
+#include "IEventLoop.h"
+#include "LinkFrame.h"
+#include <map>
+#include <memory>
+#include <string>
+
+using std::map;
+using std::string;
+
+/****
+ * @brief The client sessions a gateway multiplexes over one connection to the server.
+ *
+ * A gateway terminates the client sockets and forwards their byte streams over a few
+ * long-lived links, every LINK_DATA frame tagged with the session it belongs to. Each
+ * session is a Connection of its own whose loop is this object: the protocol layer
+ * serves it exactly like a client socket, while what it queues is moved, without copying,
+ * into the link's outbound queue behind a LINK_DATA header and sent with the link's next
+ * write. Up to LINK_WINDOW bytes a session are sent ahead of the gateway's LINK_ACK, past
+ * that they stay in the session's queue and the session counts as backed up, so a client
+ * that does not read is throttled as if it were connected to the server itself. If it
+ * sends on regardless, its session is closed once INBOUND_READ_LIMIT bytes wait in it.
+ * Everything runs on the thread of the loop that owns the link.
+ *
+ * Sessions are not reaped here, the gateway closes its idle clients. Their rate limits
+ * are kept by the client address the gateway sent with LINK_OPEN.
+ ****/
+class GatewayLink : public IEventLoop
+{
+public:
+    /****
+     * @brief Constructs the sessions of a link.
+     *
+     * @param events The receiver of the sessions' callbacks.
+     * @param link The connection of the gateway.
+     ****/
+    GatewayLink(IConnectionEvents* events, Connection& link);
+
+    /****
+     * @brief Handles every complete frame the gateway sent: opens, feeds and closes the sessions.
+     *
+     * @returns False if a frame was above MAX_MESSAGE_SIZE, the link cannot be trusted anymore.
+     ****/
+    bool receive();
+
+    /****
+     * @brief Closes every session, the link went down. They are closed like dropped clients.
+     ****/
+    void closeAll();
+
+    /****
+     * @brief Sessions are opened by LINK_OPEN frames, there is nothing to listen on or adopt.
+     ****/
+    virtual void addListener(SOCKET listener) override;
+    virtual void stopAccepting() override;
+    virtual void adopt(SOCKET client, TlsSession* tls = nullptr) override;
+
+    /****
+     * @brief Runs a task on the loop of the link. Safe to call from any thread, also once the link closed.
+     ****/
+    virtual void post(std::function<void()> task) override;
+
+    /****
+     * @brief Moves what the session queued into the link, which is written at the end of the loop's pass.
+     * Nothing moves while the session's window is used up.
+     ****/
+    virtual void flush(Connection& connection) override;
+    virtual void cork(Connection& connection) override;
+
+    /****
+     * @brief Closes a session and tells the gateway to close its client.
+     ****/
+    virtual void close(Connection& connection) override;
+
+    /****
+     * @brief Only marks the session, the link reads on for the others and closes a session at INBOUND_READ_LIMIT.
+     ****/
+    virtual void setAwaiting(Connection& connection, const bool awaiting) override;
+
+    /****
+     * @brief Sessions are bounded by LINK_WINDOW instead, the link by nothing.
+     ****/
+    virtual void setOutboundLimits(const size_t highWatermark, const size_t lowWatermark, const unsigned int evictAfterMs) override;
+
+    /****
+     * @returns The queue delay of the loop of the link.
+     ****/
+    virtual unsigned int getQueueDelay() const override;
+
+    /****
+     * @returns The client address the gateway sent with LINK_OPEN.
+     ****/
+    virtual string getPeerAddress(const Connection& connection) const override;
+
+    /****
+     * @brief The loop of the link runs, stops and hands off, the sessions go with it.
+     ****/
+    virtual void run() override;
+    virtual void stop() override;
+    virtual void handOff() override;
+    virtual void release(std::vector<SOCKET>& listeners, std::vector<std::shared_ptr<Connection>>& connections) override;
+
+private:
+    /****
+     * @brief Opens a session for a client of the gateway. A session ID that is in use is ignored.
+     ****/
+    void open(const unsigned int session, const string& address);
+
+    /****
+     * @brief Closes a session.
+     *
+     * @param notify Whether to send LINK_CLOSE, false if the gateway closed it.
+     ****/
+    void drop(Connection& connection, const bool notify);
+
+    /****
+     * @brief Reopens the window of a session by what the gateway acknowledged, sends what waited
+     * for it and handles the requests the session buffered while it was backed up.
+     ****/
+    void acknowledge(Connection& connection, const unsigned int bytes);
+
+    struct Session
+    {
+        std::shared_ptr<Connection> connection;
+        string address;
+        size_t inFlight; // Bytes sent and not acknowledged yet.
+    };
+
+    IConnectionEvents* mEvents;
+    IEventLoop* mLoop; // The loop of the link. It outlives the link, so tasks of closed sessions still reach it.
+    std::weak_ptr<Connection> mLink;
+    map<unsigned int, Session> mSessions; // By session ID.
+    map<const Connection*, unsigned int> mIds; // Session ID by session.
+};
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "Socket.h"
+#include "Connection.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+class IEventLoop;
+
+/**
+ * Callbacks an event loop raises towards the protocol layer.
+ *
+ * The loop only moves bytes. Everything about frames, handlers and users is
+ * done by the implementer of this interface (the Communicator).
+ */
+class IConnectionEvents
+{
+public:
+	virtual ~IConnectionEvents() = default;
+
+	/**
+	* Called on the listening loop for every accepted socket.
+	* The implementer decides which loop adopts it.
+	*
+	* @param loop The loop that accepted the socket.
+	* @param listener The listening socket it came from.
+	* @param client The accepted socket, already non-blocking.
+	*/
+	virtual void onAccept(IEventLoop& loop, SOCKET listener, SOCKET client) = 0;
+
+	/**
+	* Called on the owning loop once a socket was adopted.
+	*
+	* @param connection The new connection.
+	*/
+	virtual void onOpen(Connection& connection) = 0;
+
+	/**
+	* Called on the owning loop after new bytes were appended to the inbound buffer.
+	*
+	* @param connection The connection that received data.
+	*/
+	virtual void onData(Connection& connection) = 0;
+
+	/**
+	* Called on the owning loop right before the socket is closed.
+	*
+	* @param connection The connection being closed.
+	*/
+	virtual void onClose(Connection& connection) = 0;
+
+	/**
+	* Called on the owning loop when nothing was received for the connection's idle timeout.
+	*
+	* @param connection The silent connection.
+	* @return True to keep it for another timeout (e.g. after sending a PING), false to close it.
+	*/
+	virtual bool onIdle(Connection& connection) = 0;
+
+	/**
+	* Called on the owning loop after a write left at most the low watermark of a bounded
+	* connection's queue unsent. Lets a relay grant its source more. Does nothing by default.
+	*
+	* @param connection The connection that wrote.
+	*/
+	virtual void onDrained(Connection& /*connection*/)
+	{
+	}
+};
+
+/**
+ * An I/O loop that drives the read, dispatch and write of many connections from one thread.
+ */
+class IEventLoop
+{
+public:
+	virtual ~IEventLoop() = default;
+
+	/**
+	* Watches a listening socket. Accepted sockets are passed to IConnectionEvents::onAccept.
+	*
+	* @param listener A non-blocking listening socket.
+	*/
+	virtual void addListener(SOCKET listener) = 0;
+
+	/**
+	* Stops accepting and closes the listeners. Connections that are already open stay.
+	* Safe to call from any thread.
+	*/
+	virtual void stopAccepting() = 0;
+
+	/**
+	* Takes ownership of an accepted socket. Safe to call from any thread,
+	* on the loop's own thread the connection is opened right away.
+	*
+	* @param client The accepted socket.
+	* @param tls The TLS state of a socket that finished its handshake, owned by the connection from now on.
+	*/
+	virtual void adopt(SOCKET client, TlsSession* tls = nullptr) = 0;
+
+	/**
+	* Runs a task on the loop thread. Safe to call from any thread.
+	*
+	* @param task The task to run.
+	*/
+	virtual void post(std::function<void()> task) = 0;
+
+	/**
+	* Writes as much of the outbound queue as the socket takes, header and body segments in one vectored send.
+	* What is left is written when the socket becomes writable again.
+	*
+	* @param connection A connection owned by this loop.
+	*/
+	virtual void flush(Connection& connection) = 0;
+
+	/**
+	* Flushes a connection at the end of the loop's current pass instead of now. Whatever is
+	* queued for it until then, replies and pushes alike, goes out in that one vectored send.
+	* Safe to call again for the same connection, it is flushed once.
+	*
+	* @param connection A connection owned by this loop, called on the loop's thread.
+	*/
+	virtual void cork(Connection& connection) = 0;
+
+	/**
+	* Closes a connection owned by this loop. Raises IConnectionEvents::onClose.
+	*
+	* @param connection A connection owned by this loop.
+	*/
+	virtual void close(Connection& connection) = 0;
+
+	/**
+	* Marks a request of the connection as awaiting (see Connection::isAwaiting) or done.
+	* The requests after it wait in the inbound buffer meanwhile, so the loop stops reading
+	* from the client until it is done, then reads on.
+	*
+	* @param connection A connection owned by this loop, called on the loop's thread.
+	* @param awaiting Whether a request is awaiting.
+	*/
+	virtual void setAwaiting(Connection& connection, const bool awaiting) = 0;
+
+	/**
+	* Bounds the outbound queue of every connection of this loop. Above the high watermark the
+	* loop stops reading from the client, below the low watermark it reads again. A client that
+	* stays above the low watermark longer than evictAfterMs, or that grows its queue past
+	* OUTBOUND_HARD_LIMIT_FACTOR times the high watermark, is closed.
+	*
+	* @param highWatermark Bytes, 0 leaves the queues unbounded.
+	* @param lowWatermark Bytes.
+	* @param evictAfterMs Milliseconds.
+	*/
+	virtual void setOutboundLimits(const size_t highWatermark, const size_t lowWatermark, const unsigned int evictAfterMs) = 0;
+
+	/**
+	* Gets how long a request that becomes ready now waits before the loop gets to it:
+	* the shortest pass over the ready events in the last QUEUE_DELAY_WINDOW_MS. A burst
+	* makes a few passes long, only a loop that cannot keep up makes every pass long.
+	* Only the loop's own thread may call it.
+	*
+	* @returns Milliseconds.
+	*/
+	virtual unsigned int getQueueDelay() const = 0;
+
+	/**
+	* Gets the address of the client at the other end of a connection, which per-client limits are kept by.
+	*
+	* @param connection A connection owned by this loop.
+	* @returns The address as text, empty if it is not known or the client is local.
+	*/
+	virtual string getPeerAddress(const Connection& connection) const = 0;
+
+	/**
+	* Runs the loop on the calling thread until stop() is called.
+	*/
+	virtual void run() = 0;
+
+	/**
+	* Asks the loop to return from run(). Safe to call from any thread.
+	*/
+	virtual void stop() = 0;
+
+	/**
+	* Stops the loop for a hot upgrade: run() writes what it can, stops watching the
+	* listeners and the connections and returns with them still open, without raising
+	* IConnectionEvents::onClose. Safe to call from any thread.
+	*/
+	virtual void handOff() = 0;
+
+	/**
+	* Takes the listeners and the connections a handed off loop kept open.
+	* Only call it once run() returned.
+	*/
+	virtual void release(std::vector<SOCKET>& listeners, std::vector<std::shared_ptr<Connection>>& connections) = 0;
+};
@@ -1,5 +1,7 @@
 #pragma once
 #include "CommunicationStructs.h"
+#include "Packet.h"
+#include "Task.h"
 #include <vector>
 using std::vector;
 
@@ -11,13 +13,14 @@ class IRequestHandler;
  * IRequestHandler in the chain of responsibility (if applicable).
  */
 struct RequestResult {
-	string buffer;           // String buffer containing the response data.
+	Packet buffer;           // The serialized response, header and body.
 	IRequestHandler* nextHandler;  // Pointer to the next handler in the chain (optional).
 };
 
 class IRequestHandler 
 {
 public:
+	virtual ~IRequestHandler() = default;
 	/**
 	* Determines if a request is relevant to the current handler.
 	*
@@ -37,8 +40,40 @@ public:
 	* The RequestResult object can contain a buffer with any response data and a pointer
 	* to the next handler in the chain of responsibility (if applicable).
 	*
+	* A handler that waits on I/O is written as a coroutine: it co_awaits Offload for
+	* its database queries and co_returns the RequestResult. The loop handles other
+	* connections meanwhile, and the connection's next requests wait for the result.
+	* A coroutine takes the request by value, reqInfo is reused once it suspends.
+	* Plain handlers simply return the RequestResult.
+	*
+	* @param reqInfo A reference to a RequestInfo object containing information about the request.
+	* @return A task with the RequestResult containing the response data and potentially the next handler.
+	*/
+	virtual Task<RequestResult> handleRequest(const RequestInfo& reqInfo) = 0;
+	/**
+	* Gets the version of the state a read request returns.
+	*
+	* A conditional read whose version still matches is answered with NOT_MODIFIED_RESPONSE
+	* without calling handleRequest. Reading the version must be cheap: no JSON and no database.
+	*
+	* @param reqInfo A reference to a RequestInfo object containing information about the request.
+	* @return The current version, or NO_VERSION if the request is not versioned (the default).
+	*/
+	virtual unsigned int getVersion(const RequestInfo& /*reqInfo*/)
+	{
+		return NO_VERSION;
+	}
+	/**
+	* Gets how long a client should wait before it polls a request again.
+	*
+	* Handlers put it in the "pollAfter" field of their polled responses, and the
+	* Communicator in NOT_MODIFIED_RESPONSE.
+	*
 	* @param reqInfo A reference to a RequestInfo object containing information about the request.
-	* @return A RequestResult object containing the response data and potentially the next handler.
+	* @return The interval in milliseconds, or NO_POLL_HINT if the request is not polled (the default).
 	*/
-	virtual RequestResult handleRequest(const RequestInfo& reqInfo) = 0;
+	virtual unsigned int getPollInterval(const RequestInfo& /*reqInfo*/)
+	{
+		return NO_POLL_HINT;
+	}
 };
\ No newline at end of file
@@ -56,3 +56,31 @@ SubmitAnswerRequest JsonRequestPacketDeserializer::deserializeSubmitAnswerReques
 	request.answerId = data["answerId"];
 	return request;
 }
+
+BatchRequest JsonRequestPacketDeserializer::deserializeBatchRequest(const RequestInfo& buffer)
+{
+	BatchRequest request;
+	json data = json::parse(buffer.data);
+	for (auto& it : data["requests"])
+	{
+		string body = it.contains("data") ? it["data"].get<string>() : "";
+		request.requests.push_back(RequestInfo(body, it["code"].get<unsigned char>()));
+	}
+	return request;
+}
+
+SubscribeRequest JsonRequestPacketDeserializer::deserializeSubscribeRequest(const RequestInfo& buffer)
+{
+	SubscribeRequest request;
+	json data = json::parse(buffer.data);
+	request.topic = data["topic"];
+	return request;
+}
+
+ResumeRequest JsonRequestPacketDeserializer::deserializeResumeRequest(const RequestInfo& buffer)
+{
+	ResumeRequest request;
+	json data = json::parse(buffer.data);
+	request.token = data["token"];
+	return request;
+}
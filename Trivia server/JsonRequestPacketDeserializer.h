@@ -76,4 +76,31 @@ public:
      * @returns A SubmitAnswerRequest structure containing the deserialized data.
      ****/
     static SubmitAnswerRequest deserializeSubmitAnswerRequest(const RequestInfo& buffer);
+
+    /****
+     * @brief Deserializes a batch request from a JSON buffer.
+     *
+     * This method parses the provided JSON data buffer, {"requests": [{"code": 13, "data": "..."}, ...]},
+     * into one RequestInfo per sub-request. The data of a sub-request is its own JSON body as a string.
+     *
+     * @param buffer A reference to a RequestInfo object containing the JSON data.
+     * @returns A BatchRequest structure containing the deserialized data.
+     ****/
+    static BatchRequest deserializeBatchRequest(const RequestInfo& buffer);
+
+    /****
+     * @brief Deserializes a subscribe or unsubscribe request from a JSON buffer.
+     *
+     * @param buffer A reference to a RequestInfo object containing the JSON data.
+     * @returns A SubscribeRequest structure containing the deserialized data.
+     ****/
+    static SubscribeRequest deserializeSubscribeRequest(const RequestInfo& buffer);
+
+    /****
+     * @brief Deserializes a resume request from a JSON buffer.
+     *
+     * @param buffer A reference to a RequestInfo object containing the JSON data.
+     * @returns A ResumeRequest structure containing the deserialized data.
+     ****/
+    static ResumeRequest deserializeResumeRequest(const RequestInfo& buffer);
 };
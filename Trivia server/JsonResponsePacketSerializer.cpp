@@ -3,33 +3,35 @@
 
 using json = nlohmann::json;
 
-std::string JsonResponsePacketSerializer::serializeResponse(const LoginResponse& loginResponse)
+Packet JsonResponsePacketSerializer::serializeResponse(const LoginResponse& loginResponse)
 {
 	json jsonMsg;
 	jsonMsg["status"] = loginResponse.status;
+	jsonMsg["resumeToken"] = loginResponse.resumeToken;
 	return wrapToProtocol(CODES::LOGIN_RESPONSE, jsonMsg.dump());
 }
 
-std::string JsonResponsePacketSerializer::serializeResponse(const SignupResponse& signupResponse)
+Packet JsonResponsePacketSerializer::serializeResponse(const SignupResponse& signupResponse)
 {
 	json jsonMsg;
 	jsonMsg["status"] = signupResponse.status;
+	jsonMsg["resumeToken"] = signupResponse.resumeToken;
 	return wrapToProtocol(CODES::SIGNUP_RESPONSE, jsonMsg.dump());
 }
 
-std::string JsonResponsePacketSerializer::serializeResponse(const ErrorResponse& errorResponse)
+Packet JsonResponsePacketSerializer::serializeResponse(const ErrorResponse& errorResponse)
 {
-	return wrapToProtocol(CODES::ERROR_RESPONSE, errorResponse.message);
+	return wrapToProtocol(CODES::ERROR_RESPONSE, string(errorResponse.message));
 }
 
-std::string JsonResponsePacketSerializer::serializeResponse(const LogoutResponse& logoutResponse)
+Packet JsonResponsePacketSerializer::serializeResponse(const LogoutResponse& logoutResponse)
 {
 	json jsonMsg;
 	jsonMsg["status"] = logoutResponse.status;
 	return wrapToProtocol(CODES::LOGOUT_RESPONSE, jsonMsg.dump());
 }
 
-std::string JsonResponsePacketSerializer::serializeResponse(const GetRoomsResponse& getRoomsResponse)
+Packet JsonResponsePacketSerializer::serializeResponse(const GetRoomsResponse& getRoomsResponse)
 {
 	json jsonMsg;
 	json rooms = json::array(); //create dict.
@@ -47,10 +49,11 @@ std::string JsonResponsePacketSerializer::serializeResponse(const GetRoomsRespon
 
 	jsonMsg["Rooms"] = rooms;
 	jsonMsg["status"] = getRoomsResponse.status;
+	jsonMsg["pollAfter"] = getRoomsResponse.pollAfter;
 	return wrapToProtocol(CODES::GET_ROOMS_RESPONSE, jsonMsg.dump());
 }
 
-std::string JsonResponsePacketSerializer::serializeResponse(const GetPlayersInRoomResponse& getPlayersInRoomResponse)
+Packet JsonResponsePacketSerializer::serializeResponse(const GetPlayersInRoomResponse& getPlayersInRoomResponse)
 {
 	string players = "";
 	json jsonMsg;
@@ -59,14 +62,14 @@ std::string JsonResponsePacketSerializer::serializeResponse(const GetPlayersInRo
 	return wrapToProtocol(CODES::GET_PLAYERS_IN_ROOM_RESPONSE, jsonMsg.dump());
 }
 
-std::string JsonResponsePacketSerializer::serializeResponse(const JoinRoomResponse& joinRoomResponse)
+Packet JsonResponsePacketSerializer::serializeResponse(const JoinRoomResponse& joinRoomResponse)
 {
 	json jsonMsg;
 	jsonMsg["status"] = joinRoomResponse.status;
 	return wrapToProtocol(CODES::JOIN_ROOM_RESPONSE, jsonMsg.dump());
 }
 
-std::string JsonResponsePacketSerializer::serializeResponse(const CreateRoomResponse& createRoomResponse)
+Packet JsonResponsePacketSerializer::serializeResponse(const CreateRoomResponse& createRoomResponse)
 {
 	json jsonMsg;
 	jsonMsg["status"] = createRoomResponse.status;
@@ -74,7 +77,7 @@ std::string JsonResponsePacketSerializer::serializeResponse(const CreateRoomResp
 	return wrapToProtocol(CODES::CREATE_ROOM_RESPONSE, jsonMsg.dump());
 }
 
-std::string JsonResponsePacketSerializer::serializeResponse(const GetHighScoreResponse& getHighScoreResponse)
+Packet JsonResponsePacketSerializer::serializeResponse(const GetHighScoreResponse& getHighScoreResponse)
 {
 	json jsonMsg;
 	jsonMsg["status"] = getHighScoreResponse.status;
@@ -82,7 +85,7 @@ std::string JsonResponsePacketSerializer::serializeResponse(const GetHighScoreRe
 	return wrapToProtocol(CODES::GET_HIGH_SCORE_RESPONSE, jsonMsg.dump());
 }
 
-std::string JsonResponsePacketSerializer::serializeResponse(const GetPersonalStatsResponse& getPersonalStatsResponse)
+Packet JsonResponsePacketSerializer::serializeResponse(const GetPersonalStatsResponse& getPersonalStatsResponse)
 {
 	json jsonMsg;
 	jsonMsg["status"] = getPersonalStatsResponse.status;
@@ -90,21 +93,21 @@ std::string JsonResponsePacketSerializer::serializeResponse(const GetPersonalSta
 	return wrapToProtocol(CODES::GET_PERSONAL_STATS_RESPONSE, jsonMsg.dump());
 }
 
-string JsonResponsePacketSerializer::serializeResponse(const CloseRoomResponse& response)
+Packet JsonResponsePacketSerializer::serializeResponse(const CloseRoomResponse& response)
 {
 	json jsonMsg;
 	jsonMsg["status"] = response.status;
 	return wrapToProtocol(CODES::CLOSE_ROOM_RESPONSE, jsonMsg.dump());
 }
 
-string JsonResponsePacketSerializer::serializeResponse(const StartGameResponse& response)
+Packet JsonResponsePacketSerializer::serializeResponse(const StartGameResponse& response)
 {
 	json jsonMsg;
 	jsonMsg["status"] = response.status;
 	return wrapToProtocol(CODES::START_GAME_RESPONSE, jsonMsg.dump());
 }
 
-string JsonResponsePacketSerializer::serializeResponse(const GetRoomStateResponse& response)
+Packet JsonResponsePacketSerializer::serializeResponse(const GetRoomStateResponse& response)
 {
 	json jsonMsg;
 	jsonMsg["status"] = response.status;
@@ -112,17 +115,18 @@ string JsonResponsePacketSerializer::serializeResponse(const GetRoomStateRespons
 	jsonMsg["answerTimeout"] = response.answerTimeout;
 	jsonMsg["state"] = response.state;
 	jsonMsg["players"] = response.players;
+	jsonMsg["pollAfter"] = response.pollAfter;
 	return wrapToProtocol(CODES::GET_ROOM_STATE_RESPONSE, jsonMsg.dump());
 }
 
-string JsonResponsePacketSerializer::serializeResponse(LeaveRoomResponse& response)
+Packet JsonResponsePacketSerializer::serializeResponse(LeaveRoomResponse& response)
 {
 	json jsonMsg;
 	jsonMsg["status"] = response.status;
 	return wrapToProtocol(CODES::LEAVE_ROOM_RESPONSE, jsonMsg.dump());
 }
 
-string JsonResponsePacketSerializer::serializeResponse(GetGameResultsResponse& response)
+Packet JsonResponsePacketSerializer::serializeResponse(GetGameResultsResponse& response)
 {
 	json jsonMsg;
 	jsonMsg["status"] = response.status;
@@ -141,15 +145,16 @@ string JsonResponsePacketSerializer::serializeResponse(GetGameResultsResponse& r
 	return wrapToProtocol(CODES::GET_GAME_RESULT_RESPONSE, jsonMsg.dump());
 }
 
-string JsonResponsePacketSerializer::serializeResponse(SubmitAnswerResponse& response)
+Packet JsonResponsePacketSerializer::serializeResponse(SubmitAnswerResponse& response)
 {
 	json jsonMsg;
 	jsonMsg["status"] = response.status;
 	jsonMsg["correctAnswerId"] = response.correctAnswerId;
+	jsonMsg["pollAfter"] = response.pollAfter;
 	return wrapToProtocol(CODES::SUBMIT_ANSWER_RESPONSE, jsonMsg.dump());
 }
 
-string JsonResponsePacketSerializer::serializeResponse(GetQuestionResponse& response)
+Packet JsonResponsePacketSerializer::serializeResponse(GetQuestionResponse& response)
 {
 	json jsonMsg;
 	jsonMsg["status"] = response.status;
@@ -165,21 +170,130 @@ string JsonResponsePacketSerializer::serializeResponse(GetQuestionResponse& resp
 	return wrapToProtocol(CODES::GET_QUESTION_RESPONSE, jsonMsg.dump());
 }
 
-string JsonResponsePacketSerializer::serializeResponse(LeaveGameResponse& response)
+Packet JsonResponsePacketSerializer::serializeResponse(LeaveGameResponse& response)
 {
 	json jsonMsg;
 	jsonMsg["status"] = response.status;
 	return wrapToProtocol(CODES::LEAVE_GAME_RESPONSE, jsonMsg.dump());
 }
 
-std::string JsonResponsePacketSerializer::wrapToProtocol(const int code, const std::string message)
+Packet JsonResponsePacketSerializer::serializeResponse(const BatchResponse& response)
 {
-	std::string response = "";
-	response += code;
-	unsigned int size = message.size();
-	char* c = (char*)&size;
-	response += std::string(c, sizeof(int));
-	response += message;
+	json jsonMsg;
+	json responses = json::array();
+	for (auto it = response.responses.begin(); it != response.responses.end(); ++it)
+	{
+		json sub;
+		sub["code"] = it->code();
+		sub["data"] = it->body;
+		responses.push_back(sub);
+	}
+	jsonMsg["responses"] = responses;
+	jsonMsg["status"] = response.status;
+	return wrapToProtocol(CODES::BATCH_RESPONSE, jsonMsg.dump());
+}
+
+Packet JsonResponsePacketSerializer::serializeResponse(const SubscribeResponse& response, const CODES code)
+{
+	json jsonMsg;
+	jsonMsg["status"] = response.status;
+	return wrapToProtocol(code, jsonMsg.dump());
+}
+
+Packet JsonResponsePacketSerializer::serializeResponse(const RoomStateEvent& event)
+{
+	json jsonMsg;
+	jsonMsg["roomId"] = event.roomId;
+	jsonMsg["status"] = event.roomState.status;
+	jsonMsg["questionCount"] = event.roomState.questionCount;
+	jsonMsg["answerTimeout"] = event.roomState.answerTimeout;
+	jsonMsg["state"] = event.roomState.state;
+	jsonMsg["players"] = event.roomState.players;
+	return wrapToProtocol(CODES::ROOM_STATE_EVENT, jsonMsg.dump());
+}
+
+Packet JsonResponsePacketSerializer::serializeResponse(const AnswerRevealedEvent& event)
+{
+	json jsonMsg;
+	jsonMsg["gameId"] = event.gameId;
+	jsonMsg["questionIndex"] = event.questionIndex;
+	jsonMsg["correctAnswerId"] = event.correctAnswerId;
+	return wrapToProtocol(CODES::ANSWER_REVEALED_EVENT, jsonMsg.dump());
+}
+
+Packet JsonResponsePacketSerializer::serializeResponse(const NextQuestionEvent& event)
+{
+	json jsonMsg;
+	jsonMsg["gameId"] = event.gameId;
+	jsonMsg["questionIndex"] = event.questionIndex;
+	jsonMsg["status"] = event.question.status;
+	jsonMsg["question"] = event.question.question;
+
+	json answers = json::object();
+	for (auto& it : event.question.answers)
+	{
+		answers[std::to_string((int)it.first)] = it.second;
+	}
+
+	jsonMsg["answers"] = answers;
+	return wrapToProtocol(CODES::NEXT_QUESTION_EVENT, jsonMsg.dump());
+}
+
+Packet JsonResponsePacketSerializer::serializeResponse(const GameOverEvent& event)
+{
+	json jsonMsg;
+	jsonMsg["gameId"] = event.gameId;
+	jsonMsg["status"] = event.results.status;
+	json results = json::array();
+	for (auto& it : event.results.results)
+	{
+		json player;
+		player["username"] = it.username;
+		player["correctAnswerCount"] = it.correctAnswerCount;
+		player["wrongAnswerCount"] = it.wrongAnswerCount;
+		player["averageAnswerTime"] = it.averageAnswerTime;
+		player["hasRetired"] = it.hasRetired;
+		results.push_back(player);
+	}
+	jsonMsg["results"] = results;
+	return wrapToProtocol(CODES::GAME_OVER_EVENT, jsonMsg.dump());
+}
+
+Packet JsonResponsePacketSerializer::serializeResponse(const NotModifiedResponse& response)
+{
+	if (response.pollAfter == NO_POLL_HINT) return wrapToProtocol(CODES::NOT_MODIFIED_RESPONSE, string());
+	// Built by hand: a conditional read that matched does no JSON work.
+	return wrapToProtocol(CODES::NOT_MODIFIED_RESPONSE, "{\"pollAfter\":" + std::to_string(response.pollAfter) + "}");
+}
+
+Packet JsonResponsePacketSerializer::serializeResponse(const HeartbeatMessage& /*message*/, const CODES code)
+{
+	return wrapToProtocol(code, string());
+}
+
+Packet JsonResponsePacketSerializer::serializeResponse(const BusyResponse& response)
+{
+	// Built by hand: shedding a request must stay cheaper than handling it.
+	return wrapToProtocol(CODES::BUSY_RESPONSE, "{\"retryAfter\":" + std::to_string(response.retryAfter) + "}");
+}
+
+Packet JsonResponsePacketSerializer::serializeResponse(const RateLimitedResponse& response)
+{
+	return wrapToProtocol(CODES::RATE_LIMITED_RESPONSE, "{\"retryAfter\":" + std::to_string(response.retryAfter) + "}");
+}
 
-	return response;
+Packet JsonResponsePacketSerializer::serializeResponse(const ResumeResponse& response)
+{
+	json jsonMsg;
+	jsonMsg["status"] = response.status;
+	jsonMsg["resumeToken"] = response.resumeToken;
+	jsonMsg["username"] = response.username;
+	jsonMsg["state"] = response.state;
+	return wrapToProtocol(CODES::RESUME_RESPONSE, jsonMsg.dump());
+}
+
+Packet JsonResponsePacketSerializer::wrapToProtocol(const int code, std::string&& message)
+{
+	// The body is moved, not copied: the header is a separate segment of the packet.
+	return Packet((unsigned char)code, std::move(message));
 }
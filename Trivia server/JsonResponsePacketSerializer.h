@@ -1,207 +1,309 @@
 #pragma once
 
 #include "CommunicationStructs.h"
+#include "Packet.h"
 #include "json.hpp"
 
 /****
  * @brief The JsonResponsePacketSerializer class is responsible for serializing response structures into JSON format.
  *
  * This class contains static methods for converting response data structures, such as LoginResponse, SignupResponse, etc.,
- * into JSON-formatted strings suitable for network transmission.
+ * into JSON-formatted packets suitable for network transmission.
  ****/
 class JsonResponsePacketSerializer
 {
 public:
     /****
-     * @brief Serializes a LoginResponse structure into a JSON string.
+     * @brief Serializes a LoginResponse structure into a JSON packet.
      *
-     * This method converts the provided LoginResponse object into a JSON-formatted string.
+     * This method converts the provided LoginResponse object into a JSON-formatted packet.
      *
      * @param loginResponse A reference to a LoginResponse object.
-     * @returns A JSON-formatted string representing the login response.
+     * @returns A packet whose JSON-formatted body represents the login response.
      ****/
-    static std::string serializeResponse(const LoginResponse& loginResponse);
+    static Packet serializeResponse(const LoginResponse& loginResponse);
 
     /****
-     * @brief Serializes a SignupResponse structure into a JSON string.
+     * @brief Serializes a SignupResponse structure into a JSON packet.
      *
-     * This method converts the provided SignupResponse object into a JSON-formatted string.
+     * This method converts the provided SignupResponse object into a JSON-formatted packet.
      *
      * @param signupResponse A reference to a SignupResponse object.
-     * @returns A JSON-formatted string representing the signup response.
+     * @returns A packet whose JSON-formatted body represents the signup response.
      ****/
-    static std::string serializeResponse(const SignupResponse& signupResponse);
+    static Packet serializeResponse(const SignupResponse& signupResponse);
 
     /****
-     * @brief Serializes an ErrorResponse structure into a JSON string.
+     * @brief Serializes an ErrorResponse structure into a JSON packet.
      *
-     * This method converts the provided ErrorResponse object into a JSON-formatted string.
+     * This method converts the provided ErrorResponse object into a JSON-formatted packet.
      *
      * @param errorResponse A reference to an ErrorResponse object.
-     * @returns A JSON-formatted string representing the error response.
+     * @returns A packet whose JSON-formatted body represents the error response.
      ****/
-    static std::string serializeResponse(const ErrorResponse& errorResponse);
+    static Packet serializeResponse(const ErrorResponse& errorResponse);
 
     /****
-     * @brief Serializes a LogoutResponse structure into a JSON string.
+     * @brief Serializes a LogoutResponse structure into a JSON packet.
      *
-     * This method converts the provided LogoutResponse object into a JSON-formatted string.
+     * This method converts the provided LogoutResponse object into a JSON-formatted packet.
      *
      * @param logoutResponse A reference to a LogoutResponse object.
-     * @returns A JSON-formatted string representing the logout response.
+     * @returns A packet whose JSON-formatted body represents the logout response.
      ****/
-    static std::string serializeResponse(const LogoutResponse& logoutResponse);
+    static Packet serializeResponse(const LogoutResponse& logoutResponse);
 
     /****
-     * @brief Serializes a GetRoomsResponse structure into a JSON string.
+     * @brief Serializes a GetRoomsResponse structure into a JSON packet.
      *
-     * This method converts the provided GetRoomsResponse object into a JSON-formatted string.
+     * This method converts the provided GetRoomsResponse object into a JSON-formatted packet.
      *
      * @param getRoomsResponse A reference to a GetRoomsResponse object.
-     * @returns A JSON-formatted string representing the get rooms response.
+     * @returns A packet whose JSON-formatted body represents the get rooms response.
      ****/
-    static std::string serializeResponse(const GetRoomsResponse& getRoomsResponse);
+    static Packet serializeResponse(const GetRoomsResponse& getRoomsResponse);
 
     /****
-     * @brief Serializes a GetPlayersInRoomResponse structure into a JSON string.
+     * @brief Serializes a GetPlayersInRoomResponse structure into a JSON packet.
      *
-     * This method converts the provided GetPlayersInRoomResponse object into a JSON-formatted string.
+     * This method converts the provided GetPlayersInRoomResponse object into a JSON-formatted packet.
      *
      * @param getPlayersInRoomResponse A reference to a GetPlayersInRoomResponse object.
-     * @returns A JSON-formatted string representing the get players in room response.
+     * @returns A packet whose JSON-formatted body represents the get players in room response.
      ****/
-    static std::string serializeResponse(const GetPlayersInRoomResponse& getPlayersInRoomResponse);
+    static Packet serializeResponse(const GetPlayersInRoomResponse& getPlayersInRoomResponse);
 
     /****
-     * @brief Serializes a JoinRoomResponse structure into a JSON string.
+     * @brief Serializes a JoinRoomResponse structure into a JSON packet.
      *
-     * This method converts the provided JoinRoomResponse object into a JSON-formatted string.
+     * This method converts the provided JoinRoomResponse object into a JSON-formatted packet.
      *
      * @param joinRoomResponse A reference to a JoinRoomResponse object.
-     * @returns A JSON-formatted string representing the join room response.
+     * @returns A packet whose JSON-formatted body represents the join room response.
      ****/
-    static std::string serializeResponse(const JoinRoomResponse& joinRoomResponse);
+    static Packet serializeResponse(const JoinRoomResponse& joinRoomResponse);
 
     /****
-     * @brief Serializes a CreateRoomResponse structure into a JSON string.
+     * @brief Serializes a CreateRoomResponse structure into a JSON packet.
      *
-     * This method converts the provided CreateRoomResponse object into a JSON-formatted string.
+     * This method converts the provided CreateRoomResponse object into a JSON-formatted packet.
      *
      * @param createRoomResponse A reference to a CreateRoomResponse object.
-     * @returns A JSON-formatted string representing the create room response.
+     * @returns A packet whose JSON-formatted body represents the create room response.
      ****/
-    static std::string serializeResponse(const CreateRoomResponse& createRoomResponse);
+    static Packet serializeResponse(const CreateRoomResponse& createRoomResponse);
 
     /****
-     * @brief Serializes a GetHighScoreResponse structure into a JSON string.
+     * @brief Serializes a GetHighScoreResponse structure into a JSON packet.
      *
-     * This method converts the provided GetHighScoreResponse object into a JSON-formatted string.
+     * This method converts the provided GetHighScoreResponse object into a JSON-formatted packet.
      *
      * @param getHighScoreResponse A reference to a GetHighScoreResponse object.
-     * @returns A JSON-formatted string representing the get high score response.
+     * @returns A packet whose JSON-formatted body represents the get high score response.
      ****/
-    static std::string serializeResponse(const GetHighScoreResponse& getHighScoreResponse);
+    static Packet serializeResponse(const GetHighScoreResponse& getHighScoreResponse);
 
     /****
-     * @brief Serializes a GetPersonalStatsResponse structure into a JSON string.
+     * @brief Serializes a GetPersonalStatsResponse structure into a JSON packet.
      *
-     * This method converts the provided GetPersonalStatsResponse object into a JSON-formatted string.
+     * This method converts the provided GetPersonalStatsResponse object into a JSON-formatted packet.
      *
      * @param getPersonalStatsResponse A reference to a GetPersonalStatsResponse object.
-     * @returns A JSON-formatted string representing the get personal stats response.
+     * @returns A packet whose JSON-formatted body represents the get personal stats response.
      ****/
-    static std::string serializeResponse(const GetPersonalStatsResponse& getPersonalStatsResponse);
+    static Packet serializeResponse(const GetPersonalStatsResponse& getPersonalStatsResponse);
 
     /****
-     * @brief Serializes a CloseRoomResponse structure into a JSON string.
+     * @brief Serializes a CloseRoomResponse structure into a JSON packet.
      *
-     * This method converts the provided CloseRoomResponse object into a JSON-formatted string.
+     * This method converts the provided CloseRoomResponse object into a JSON-formatted packet.
      *
      * @param response A reference to a CloseRoomResponse object.
-     * @returns A JSON-formatted string representing the close room response.
+     * @returns A packet whose JSON-formatted body represents the close room response.
      ****/
-    static std::string serializeResponse(const CloseRoomResponse& response);
+    static Packet serializeResponse(const CloseRoomResponse& response);
 
     /****
-     * @brief Serializes a StartGameResponse structure into a JSON string.
+     * @brief Serializes a StartGameResponse structure into a JSON packet.
      *
-     * This method converts the provided StartGameResponse object into a JSON-formatted string.
+     * This method converts the provided StartGameResponse object into a JSON-formatted packet.
      *
      * @param response A reference to a StartGameResponse object.
-     * @returns A JSON-formatted string representing the start game response.
+     * @returns A packet whose JSON-formatted body represents the start game response.
      ****/
-    static std::string serializeResponse(const StartGameResponse& response);
+    static Packet serializeResponse(const StartGameResponse& response);
 
     /****
-     * @brief Serializes a GetRoomStateResponse structure into a JSON string.
+     * @brief Serializes a GetRoomStateResponse structure into a JSON packet.
      *
-     * This method converts the provided GetRoomStateResponse object into a JSON-formatted string.
+     * This method converts the provided GetRoomStateResponse object into a JSON-formatted packet.
      *
      * @param response A reference to a GetRoomStateResponse object.
-     * @returns A JSON-formatted string representing the get room state response.
+     * @returns A packet whose JSON-formatted body represents the get room state response.
      ****/
-    static std::string serializeResponse(const GetRoomStateResponse& response);
+    static Packet serializeResponse(const GetRoomStateResponse& response);
 
     /****
-     * @brief Serializes a LeaveRoomResponse structure into a JSON string.
+     * @brief Serializes a LeaveRoomResponse structure into a JSON packet.
      *
-     * This method converts the provided LeaveRoomResponse object into a JSON-formatted string.
+     * This method converts the provided LeaveRoomResponse object into a JSON-formatted packet.
      *
      * @param response A reference to a LeaveRoomResponse object.
-     * @returns A JSON-formatted string representing the leave room response.
+     * @returns A packet whose JSON-formatted body represents the leave room response.
      ****/
-    static std::string serializeResponse(LeaveRoomResponse& response);
+    static Packet serializeResponse(LeaveRoomResponse& response);
 
     /****
-     * @brief Serializes a GetGameResultsResponse structure into a JSON string.
+     * @brief Serializes a GetGameResultsResponse structure into a JSON packet.
      *
-     * This method converts the provided GetGameResultsResponse object into a JSON-formatted string.
+     * This method converts the provided GetGameResultsResponse object into a JSON-formatted packet.
      *
      * @param response A reference to a GetGameResultsResponse object.
-     * @returns A JSON-formatted string representing the get game results response.
+     * @returns A packet whose JSON-formatted body represents the get game results response.
      ****/
-    static std::string serializeResponse(GetGameResultsResponse& response);
+    static Packet serializeResponse(GetGameResultsResponse& response);
 
     /****
-     * @brief Serializes a SubmitAnswerResponse structure into a JSON string.
+     * @brief Serializes a SubmitAnswerResponse structure into a JSON packet.
      *
-     * This method converts the provided SubmitAnswerResponse object into a JSON-formatted string.
+     * This method converts the provided SubmitAnswerResponse object into a JSON-formatted packet.
      *
      * @param response A reference to a SubmitAnswerResponse object.
-     * @returns A JSON-formatted string representing the submit answer response.
+     * @returns A packet whose JSON-formatted body represents the submit answer response.
      ****/
-    static std::string serializeResponse(SubmitAnswerResponse& response);
+    static Packet serializeResponse(SubmitAnswerResponse& response);
 
     /****
-     * @brief Serializes a GetQuestionResponse structure into a JSON string.
+     * @brief Serializes a GetQuestionResponse structure into a JSON packet.
      *
-     * This method converts the provided GetQuestionResponse object into a JSON-formatted string.
+     * This method converts the provided GetQuestionResponse object into a JSON-formatted packet.
      *
      * @param response A reference to a GetQuestionResponse object.
-     * @returns A JSON-formatted string representing the get question response.
+     * @returns A packet whose JSON-formatted body represents the get question response.
      ****/
-    static std::string serializeResponse(GetQuestionResponse& response);
+    static Packet serializeResponse(GetQuestionResponse& response);
 
     /****
-     * @brief Serializes a LeaveGameResponse structure into a JSON string.
+     * @brief Serializes a LeaveGameResponse structure into a JSON packet.
      *
-     * This method converts the provided LeaveGameResponse object into a JSON-formatted string.
+     * This method converts the provided LeaveGameResponse object into a JSON-formatted packet.
      *
      * @param response A reference to a LeaveGameResponse object.
-     * @returns A JSON-formatted string representing the leave game response.
+     * @returns A packet whose JSON-formatted body represents the leave game response.
      ****/
-    static std::string serializeResponse(LeaveGameResponse& response);
+    static Packet serializeResponse(LeaveGameResponse& response);
+
+    /****
+     * @brief Serializes a BatchResponse structure into a JSON packet.
+     *
+     * Every sub-response becomes {"code": ..., "data": "..."}, where data is its
+     * body as a string, so it can be read with the same deserializer as a single response.
+     *
+     * @param response A reference to a BatchResponse object.
+     * @returns A packet whose JSON-formatted body represents the batch response.
+     ****/
+    static Packet serializeResponse(const BatchResponse& response);
+
+    /****
+     * @brief Serializes a SubscribeResponse structure into a JSON packet.
+     *
+     * @param response A reference to a SubscribeResponse object.
+     * @param code SUBSCRIBE_RESPONSE or UNSUBSCRIBE_RESPONSE.
+     * @returns A packet whose JSON-formatted body represents the subscribe response.
+     ****/
+    static Packet serializeResponse(const SubscribeResponse& response, const CODES code);
+
+    /****
+     * @brief Serializes a RoomStateEvent structure into a JSON packet.
+     *
+     * The body is the same as a GET_ROOM_STATE response, with the room ID added.
+     *
+     * @param event A reference to a RoomStateEvent object.
+     * @returns A packet whose JSON-formatted body represents the room state event.
+     ****/
+    static Packet serializeResponse(const RoomStateEvent& event);
+
+    /****
+     * @brief Serializes an AnswerRevealedEvent structure into a JSON packet.
+     *
+     * @param event A reference to an AnswerRevealedEvent object.
+     * @returns A packet whose JSON-formatted body represents the revealed answer.
+     ****/
+    static Packet serializeResponse(const AnswerRevealedEvent& event);
+
+    /****
+     * @brief Serializes a NextQuestionEvent structure into a JSON packet.
+     *
+     * The body is the same as a GET_QUESTION response, with the game ID and question index added.
+     *
+     * @param event A reference to a NextQuestionEvent object.
+     * @returns A packet whose JSON-formatted body represents the next question.
+     ****/
+    static Packet serializeResponse(const NextQuestionEvent& event);
+
+    /****
+     * @brief Serializes a GameOverEvent structure into a JSON packet.
+     *
+     * The body is the same as a GET_GAME_RESULT response, with the game ID added.
+     *
+     * @param event A reference to a GameOverEvent object.
+     * @returns A packet whose JSON-formatted body represents the game results.
+     ****/
+    static Packet serializeResponse(const GameOverEvent& event);
+
+    /****
+     * @brief Serializes a NotModifiedResponse structure into a packet.
+     *
+     * The packet has no body, only the header that the version is added to.
+     *
+     * @param response A reference to a NotModifiedResponse object.
+     * @returns A packet with the NOT_MODIFIED_RESPONSE code and an empty body.
+     ****/
+    static Packet serializeResponse(const NotModifiedResponse& response);
+
+    /****
+     * @brief Serializes a HeartbeatMessage structure into a packet.
+     *
+     * @param message A reference to a HeartbeatMessage object.
+     * @param code PING or PONG.
+     * @returns A packet with the code and an empty body.
+     ****/
+    static Packet serializeResponse(const HeartbeatMessage& message, const CODES code);
+
+    /****
+     * @brief Serializes a BusyResponse structure into a packet.
+     *
+     * @param response A reference to a BusyResponse object.
+     * @returns A packet with the BUSY_RESPONSE code and the retry hint.
+     ****/
+    static Packet serializeResponse(const BusyResponse& response);
+
+    /****
+     * @brief Serializes a RateLimitedResponse structure into a packet.
+     *
+     * @param response A reference to a RateLimitedResponse object.
+     * @returns A packet with the RATE_LIMITED_RESPONSE code and the retry hint.
+     ****/
+    static Packet serializeResponse(const RateLimitedResponse& response);
+
+    /****
+     * @brief Serializes a ResumeResponse structure into a JSON packet.
+     *
+     * @param response A reference to a ResumeResponse object.
+     * @returns A packet whose JSON-formatted body represents the resume response.
+     ****/
+    static Packet serializeResponse(const ResumeResponse& response);
 
 private:
     /****
      * @brief Wraps a JSON message with protocol-specific information.
      *
-     * This method adds protocol-specific headers, such as response code and message size,
-     * to the JSON-formatted message string.
+     * This method builds the protocol-specific header (response code and message size)
+     * and moves the JSON-formatted message in as the body, without copying it.
      *
      * @param code An integer representing the response code.
      * @param message A string containing the JSON-formatted message.
-     * @returns A string representing the wrapped protocol message.
+     * @returns A packet representing the wrapped protocol message.
      ****/
-    static std::string wrapToProtocol(const int code, const std::string message);
+    static Packet wrapToProtocol(const int code, std::string&& message);
 };
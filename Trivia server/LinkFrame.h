@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Packet.h"
+#include <string>
+
+using std::string;
+
+/*
+* The frames a gateway and the server exchange over a link. They are client frames with
+* the request ID extension, the ID naming the session: [kind | REQUEST_ID_FLAG][len][session][payload].
+* Session IDs are chosen by the gateway and are unique per link.
+*/
+enum LINK_FRAMES
+{
+	LINK_OPEN = 1, // A client connected to the gateway, the payload is its address.
+	LINK_DATA, // Bytes of the session's stream as they came, at most MAX_MESSAGE_SIZE per frame.
+	LINK_CLOSE, // To the server: the client went away. To the gateway: close the client. No payload.
+	LINK_ACK // To the server: the gateway passed that many more bytes of the session on to its client, four bytes little endian.
+};
+
+#define LINK_HEADER_SIZE (FRAME_HEADER_SIZE + REQUEST_ID_SIZE)
+/*
+* Bytes of a session the server sends ahead of the gateway's acknowledgements. Past it the
+* session's responses stay queued on the server, which then stops handling its requests like
+* it does for a client that does not read. The gateway acknowledges in steps of LINK_ACK_STEP.
+*/
+#define LINK_WINDOW (1 << 20)
+#define LINK_ACK_STEP (LINK_WINDOW / 4)
+
+/*
+* Builds the header of a link frame, the payload follows it.
+*/
+inline string linkHeader(const unsigned char kind, const unsigned int session, const size_t len)
+{
+	string header(LINK_HEADER_SIZE, '\0');
+	header[0] = (char)(kind | REQUEST_ID_FLAG);
+	for (int i = 0; i < 4; i++)
+	{
+		header[1 + i] = (char)((len >> (8 * i)) & 0xff);
+		header[FRAME_HEADER_SIZE + i] = (char)((session >> (8 * i)) & 0xff);
+	}
+	return header;
+}
+
+/*
+* Builds a LINK_ACK frame.
+*/
+inline string linkAck(const unsigned int session, const unsigned int bytes)
+{
+	string frame = linkHeader(LINK_ACK, session, 4);
+	for (int i = 0; i < 4; i++)
+	{
+		frame += (char)((bytes >> (8 * i)) & 0xff);
+	}
+	return frame;
+}
@@ -1,6 +1,7 @@
 #include "LoginManager.h"
 #include <algorithm>
 #include "SqliteDataBase.h"
+#include "RequestContext.h"
 LoginManager* LoginManager::instancePtr = nullptr;
 IDataBase* LoginManager::mDb = SqliteDataBase::getInstance();
 
@@ -13,36 +14,36 @@ LoginManager* LoginManager::getInstance()
     return instancePtr;
 }
 
-bool LoginManager::signup(const string& username, const string& password, const string& email)
+Task<bool> LoginManager::signup(string username, string password, string email)
 {
-    if (mDb->doesUserExists(username))
-        return false;
-
-    bool res = mDb->addUser(username, password, email);
+    // One query for both: the primary key refuses the second of two signups racing for a name.
+    bool res = co_await Offload<bool>([&]() {
+        return !mDb->doesUserExists(username) && mDb->addUser(username, password, email);
+        });
     if (res)
     {
         LoggedUser user(username);
         mLoggedUsers.push_back(user);
     }
-    return res;
+    co_return res;
 }
 
-RESULTS LoginManager::login(const string& username, const string& password)
+Task<RESULTS> LoginManager::login(string username, string password)
 {
-    if (mDb->doesPasswordMatch(username, password))
+    if (co_await Offload<bool>([&]() { return mDb->doesPasswordMatch(username, password); }))
     {
         if (std::find_if(mLoggedUsers.begin(), mLoggedUsers.end(), [&](const LoggedUser& obj) {
             return obj.getUsername() == username;
             }) != mLoggedUsers.end()
                 )
         {
-            return RESULTS::LOGGED;
+            co_return RESULTS::LOGGED;
         }
         LoggedUser user(username);
         mLoggedUsers.push_back(user);
-        return RESULTS::VALID;
+        co_return RESULTS::VALID;
     }
-    return RESULTS::MISMATCH;
+    co_return RESULTS::MISMATCH;
 }
 
 void LoginManager::logout(const string& username)
@@ -2,6 +2,7 @@
 
 #include "LoggedUser.h"
 #include "IDatabase.h"
+#include "Task.h"
 #include <vector>
 
 using std::vector;
@@ -48,24 +49,26 @@ public:
      * @brief Registers a new user.
      *
      * This method adds a new user to the database and logs them in if successful.
+     * The database is awaited off the loop, the user is logged in after it resumed.
      *
      * @param username The username of the new user.
      * @param password The password of the new user.
      * @param email The email of the new user.
      * @returns True if the user was successfully registered, otherwise false.
      ****/
-    bool signup(const string& username, const string& password, const string& email);
+    Task<bool> signup(string username, string password, string email);
 
     /****
      * @brief Logs in an existing user.
      *
      * This method checks the user's credentials and logs them in if they match.
+     * The database is awaited off the loop, the user is logged in after it resumed.
      *
      * @param username The username of the user.
      * @param password The password of the user.
      * @returns 'v' if login is successful, 'm' if the password does not match, 'e' if the user is already logged in.
      ****/
-    RESULTS login(const string& username, const string& password);
+    Task<RESULTS> login(string username, string password);
 
     /****
      * @brief Logs out an existing user.
@@ -77,6 +80,7 @@ public:
     void logout(const string& username);
 
 private:
+    friend class Snapshot; //Saves and restores the state for a hot upgrade.
     vector<LoggedUser> mLoggedUsers; ///< List of currently logged-in users.
     static IDataBase* mDb;           ///< Pointer to the database instance.
     static LoginManager* instancePtr;///< Pointer to the singleton instance.
@@ -13,7 +13,7 @@ bool LoginRequestHandler::isRequestRelevant(const RequestInfo& reqInfo)
 	return reqInfo.code == CODES::LOGIN_REQUEST || reqInfo.code == CODES::SIGNUP_REQUEST;
 }
 
-RequestResult LoginRequestHandler::handleRequest(const RequestInfo& reqInfo)
+Task<RequestResult> LoginRequestHandler::handleRequest(const RequestInfo& reqInfo)
 {
 	switch (reqInfo.code)
 	{
@@ -32,18 +32,24 @@ RequestResult LoginRequestHandler::handleRequest(const RequestInfo& reqInfo)
 	return result;
 }
 
-RequestResult LoginRequestHandler::login(const RequestInfo& reqInfo)
+Task<RequestResult> LoginRequestHandler::login(RequestInfo reqInfo)
 {
 	LoginRequest request = JsonRequestPacketDeserializer::deserializeLoginRequest(reqInfo);
 	RequestResult reqResult;
-	char res;
-	if ((res = mHandlerFactory->getLoginManager()->login(request.username, request.password)) == RESULTS::VALID)
+	RESULTS res = co_await mHandlerFactory->getLoginManager()->login(request.username, request.password);
+	//The user dropped and came back without its token: the password ends the parked session.
+	if (res == RESULTS::LOGGED && mHandlerFactory->getSessionManager()->discard(request.username))
+	{
+		res = co_await mHandlerFactory->getLoginManager()->login(request.username, request.password);
+	}
+	if (res == RESULTS::VALID)
 	{
 		LoginResponse loginResponse;
 		loginResponse.status = SUCCESS;
+		loginResponse.resumeToken = mHandlerFactory->getSessionManager()->issue(request.username);
 		reqResult.buffer = JsonResponsePacketSerializer::serializeResponse(loginResponse);
 		reqResult.nextHandler = mHandlerFactory->createMenuRequestHandler(LoggedUser(request.username));
-		return reqResult;
+		co_return reqResult;
 	}
 	RequestResult result;
 	ErrorResponse response;
@@ -51,10 +57,10 @@ RequestResult LoginRequestHandler::login(const RequestInfo& reqInfo)
 	if(res == RESULTS::LOGGED)	response.message = "User already logged in.";
 	result.buffer = JsonResponsePacketSerializer::serializeResponse(response);
 	result.nextHandler = this;
-	return result;
+	co_return result;
 }
 
-RequestResult LoginRequestHandler::signup(const RequestInfo& reqInfo)
+Task<RequestResult> LoginRequestHandler::signup(RequestInfo reqInfo)
 {
 	SignupRequest request = JsonRequestPacketDeserializer::deserializeSignupRequest(reqInfo);
 	RequestResult reqResult;
@@ -76,22 +82,23 @@ RequestResult LoginRequestHandler::signup(const RequestInfo& reqInfo)
 		}
 		reqResult.buffer = JsonResponsePacketSerializer::serializeResponse(response);
 		reqResult.nextHandler = this;
-		return reqResult;
+		co_return reqResult;
 	}
-	if (mHandlerFactory->getLoginManager()->signup(request.username, request.password, request.email))
+	if (co_await mHandlerFactory->getLoginManager()->signup(request.username, request.password, request.email))
 	{
 		SignupResponse signupResponse;
 		signupResponse.status = SUCCESS;
+		signupResponse.resumeToken = mHandlerFactory->getSessionManager()->issue(request.username);
 		reqResult.buffer = JsonResponsePacketSerializer::serializeResponse(signupResponse);
 		reqResult.nextHandler = mHandlerFactory->createMenuRequestHandler(LoggedUser(request.username));
-		return reqResult;
+		co_return reqResult;
 	}
 	RequestResult result;
 	ErrorResponse response;
 	response.message = "Username already exists.";
 	result.buffer = JsonResponsePacketSerializer::serializeResponse(response);
 	result.nextHandler = this;
-	return result;
+	co_return result;
 }
 
 RESULTS LoginRequestHandler::validRegistaration(const SignupRequest& request) const
@@ -9,7 +9,7 @@ class LoginRequestHandler : public IRequestHandler
 public:
 	LoginRequestHandler();
 	virtual bool isRequestRelevant(const RequestInfo& reqInfo) override;
-	virtual RequestResult handleRequest(const RequestInfo& reqInfo) override;
+	virtual Task<RequestResult> handleRequest(const RequestInfo& reqInfo) override;
 
 private:
 	RequestHandlerFactory* mHandlerFactory;
@@ -21,11 +21,14 @@ private:
 	* On successful login, it creates a LoginResponse object and sets the next handler in the chain
 	* to the MenuRequestHandler for the logged-in user. On failure, it creates an ErrorResponse object
 	* with an appropriate error message and sets the next handler back to itself.
+	* The response carries a resume token; a parked session of the user is closed first.
 	*
-	* @param reqInfo A reference to a RequestInfo object containing the login request information.
-	* @return A RequestResult object containing the login response and potentially the next handler.
+	* It suspends while the LoginManager awaits the database.
+	*
+	* @param reqInfo A copy of the login request information, the coroutine outlives the caller's.
+	* @return A task with the RequestResult containing the login response and potentially the next handler.
 	*/
-	RequestResult login(const RequestInfo& reqInfo);
+	Task<RequestResult> login(RequestInfo reqInfo);
 	/**
 	* Handles a signup request.
 	*
@@ -39,10 +42,12 @@ private:
 	* it creates an ErrorResponse object with an appropriate error message and sets the next handler
 	* back to itself.
 	*
-	* @param reqInfo A reference to a RequestInfo object containing the signup request information.
-	* @return A RequestResult object containing the signup response and potentially the next handler.
+	* It suspends while the LoginManager awaits the database.
+	*
+	* @param reqInfo A copy of the signup request information, the coroutine outlives the caller's.
+	* @return A task with the RequestResult containing the signup response and potentially the next handler.
 	*/
-	RequestResult signup(const RequestInfo& reqInfo);
+	Task<RequestResult> signup(RequestInfo reqInfo);
 	/**
 	* Validates user registration data.
 	*
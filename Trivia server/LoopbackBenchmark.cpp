@@ -0,0 +1,101 @@
+#include "LoopbackBenchmark.h"
+#include "CommunicationStructs.h"
+#include "Packet.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+
+LoopbackBenchmark::LoopbackBenchmark(IConnectionEvents* events) : mLoop(events)
+{
+}
+
+bool LoopbackBenchmark::run(const unsigned int flows)
+{
+	//A user of its own, so a benchmark does not collide with players or an earlier run.
+	string username = "loopback" + std::to_string(std::chrono::system_clock::now().time_since_epoch().count() % 1000000000);
+	std::shared_ptr<Connection> connection = mLoop.connect("loopback");
+	nlohmann::json response;
+	bool ok = request(*connection, SIGNUP_REQUEST, { {"username", username}, {"password", "Loop1!back"}, {"email", "loopback@bench.com"} }, response) &&
+		response["status"] == SUCCESS && request(*connection, LOGOUT_REQUEST, nullptr, response);
+	mLoop.close(*connection);
+	if (!ok)
+	{
+		std::cout << "Could not sign up " << username << std::endl;
+		return false;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	unsigned int done = 0;
+	while (done < flows && runFlow(username, done))
+	{
+		done++;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (done < flows) std::cout << "Flow " << done << " failed" << std::endl;
+	report(seconds, done);
+	return done == flows;
+}
+
+bool LoopbackBenchmark::runFlow(const string& username, const unsigned int flow)
+{
+	std::shared_ptr<Connection> connection = mLoop.connect("loopback");
+	nlohmann::json response;
+	bool ok = request(*connection, LOGIN_REQUEST, { {"username", username}, {"password", "Loop1!back"} }, response) && response["status"] == SUCCESS &&
+		request(*connection, CREATE_ROOM_REQUEST, { {"roomName", "loopback" + std::to_string(flow)}, {"maxUsers", 1}, {"answerTimeout", 30}, {"questionCount", BENCHMARK_QUESTIONS} }, response) && response["status"] == SUCCESS &&
+		request(*connection, START_GAME_REQUEST, nullptr, response) && response["status"] == SUCCESS;
+	//The GET_QUESTION after the last answer fails, the game is over then.
+	bool asked = ok;
+	while (ok && asked)
+	{
+		ok = request(*connection, GET_QUESTION_REQUEST, nullptr, response);
+		asked = ok && response["status"] == SUCCESS;
+		if (asked) ok = request(*connection, SUBMIT_ANSWER_REQUEST, { {"answerId", 0} }, response);
+	}
+	ok = ok && request(*connection, GET_GAME_RESULT_REQUEST, nullptr, response) &&
+		request(*connection, LOGOUT_REQUEST, nullptr, response) && response["status"] == SUCCESS;
+	mLoop.close(*connection);
+	return ok;
+}
+
+bool LoopbackBenchmark::request(Connection& connection, const unsigned char code, const nlohmann::json& body, nlohmann::json& response)
+{
+	// One response for the whole run, its data buffer is reused by every frame.
+	static RequestInfo frame;
+	Packet packet(code, body.is_null() ? string() : body.dump());
+	string bytes((const char*)packet.header, packet.headerSize);
+	bytes += packet.body;
+	auto start = std::chrono::steady_clock::now();
+	mLoop.send(connection, bytes);
+	if (!mLoop.receive(connection, frame, BENCHMARK_TIMEOUT_MS)) return false;
+	mLatencies[code].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+	if (frame.code == ERROR_RESPONSE || frame.code == BUSY_RESPONSE || frame.code == RATE_LIMITED_RESPONSE)
+	{
+		std::cout << get_code_string((CODES)code) << " got " << get_code_string((CODES)frame.code) << ": " << frame.data << std::endl;
+		return false;
+	}
+	response = nlohmann::json::parse(frame.data);
+	return true;
+}
+
+void LoopbackBenchmark::report(const double seconds, const unsigned int flows) const
+{
+	std::cout << flows << " flows in " << std::fixed << std::setprecision(3) << seconds << " s";
+	if (seconds > 0) std::cout << ", " << std::setprecision(1) << flows / seconds << " flows/s";
+	std::cout << std::endl;
+	std::cout << std::left << std::setw(28) << "request" << std::right << std::setw(10) << "count" << std::setw(12) << "mean us"
+		<< std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::endl;
+	for (auto& it : mLatencies)
+	{
+		vector<double> latencies = it.second;
+		std::sort(latencies.begin(), latencies.end());
+		double sum = 0;
+		for (double latency : latencies)
+		{
+			sum += latency;
+		}
+		std::cout << std::left << std::setw(28) << get_code_string((CODES)it.first) << std::right << std::setw(10) << latencies.size()
+			<< std::setprecision(1) << std::setw(12) << sum / latencies.size() << std::setw(12) << latencies[latencies.size() / 2]
+			<< std::setw(12) << latencies[(size_t)(latencies.size() * 0.99)] << std::endl;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "LoopbackEventLoop.h"
+#include "json.hpp"
+#include <map>
+#include <vector>
+#include <string>
+
+using std::map;
+using std::vector;
+using std::string;
+
+#define BENCHMARK_QUESTIONS 5 // Questions a benchmark game asks, fewer if the database has fewer.
+#define BENCHMARK_TIMEOUT_MS 10000 // Longest a request may take before the run is abandoned.
+
+/****
+ * @brief Measures the handlers and managers without sockets, through a LoopbackEventLoop.
+ *
+ * Every flow is one client that goes through the login, menu and game states the way
+ * the client application does: LOGIN, CREATE_ROOM, START_GAME, a GET_QUESTION and a
+ * SUBMIT_ANSWER per question, GET_GAME_RESULT and LOGOUT. The flows run one after
+ * another on the calling thread, so the numbers repeat from run to run, and the time
+ * of each request, from the send until its response was captured, is kept by code.
+ ****/
+class LoopbackBenchmark
+{
+public:
+    /****
+     * @brief Constructs a benchmark that sends its requests to the given protocol layer.
+     *
+     * @param events The protocol layer, the Communicator of the server.
+     ****/
+    LoopbackBenchmark(IConnectionEvents* events);
+
+    /****
+     * @brief Signs a user up and runs the flows with it, then prints the count, mean,
+     * median and 99th percentile in microseconds of every request code.
+     *
+     * @param flows How many clients go through the states.
+     * @returns False if a request failed or did not get a response, what ran until then is printed.
+     ****/
+    bool run(const unsigned int flows);
+
+private:
+    /****
+     * @brief Runs one client from login to logout.
+     ****/
+    bool runFlow(const string& username, const unsigned int flow);
+
+    /****
+     * @brief Sends a request and waits for its response, and records how long it took.
+     *
+     * @param response Receives the body of the response.
+     * @returns False if the client was closed or no response came in BENCHMARK_TIMEOUT_MS.
+     ****/
+    bool request(Connection& connection, const unsigned char code, const nlohmann::json& body, nlohmann::json& response);
+
+    /****
+     * @brief Prints the measurements of every request code.
+     ****/
+    void report(const double seconds, const unsigned int flows) const;
+
+    LoopbackEventLoop mLoop;
+    map<unsigned char, vector<double>> mLatencies; // Microseconds by request code.
+};
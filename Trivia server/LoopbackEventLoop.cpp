@@ -0,0 +1,189 @@
+#include "LoopbackEventLoop.h"
+#include <chrono>
+
+LoopbackEventLoop::LoopbackEventLoop(IConnectionEvents* events)
+{
+	mEvents = events;
+	mStopping = false;
+}
+
+LoopbackEventLoop::~LoopbackEventLoop()
+{
+	while (!mClients.empty())
+	{
+		std::shared_ptr<Connection> connection = mClients.begin()->second.connection;
+		close(*connection);
+	}
+}
+
+std::shared_ptr<Connection> LoopbackEventLoop::connect(const string& address)
+{
+	std::shared_ptr<Connection> connection = std::make_shared<Connection>(INVALID_SOCKET, this);
+	Client& client = mClients[connection.get()];
+	client.connection = connection;
+	client.address = address;
+	mEvents->onOpen(*connection);
+	return connection;
+}
+
+void LoopbackEventLoop::send(Connection& connection, const string& bytes)
+{
+	if (connection.isClosed()) return;
+	connection.getInbound().write(bytes.data(), bytes.size());
+	mEvents->onData(connection);
+	//Captured with whatever else the requests corked, as a loop writes after a read.
+	if (!connection.isClosed()) cork(connection);
+	uncork();
+}
+
+bool LoopbackEventLoop::receive(Connection& connection, RequestInfo& response, const unsigned int timeoutMs)
+{
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	while (true)
+	{
+		auto it = mClients.find(&connection);
+		if (it == mClients.end()) return false;
+		if (FrameParser::next(it->second.received, response) == FrameParser::COMPLETE) return true;
+		auto now = std::chrono::steady_clock::now();
+		if (now >= deadline) return false;
+		runTasks((unsigned int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count());
+	}
+}
+
+bool LoopbackEventLoop::runTasks(const unsigned int timeoutMs)
+{
+	vector<std::function<void()>> tasks;
+	{
+		std::unique_lock<mutex> lock(mTasksLock);
+		mTasksReady.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]() { return !mTasks.empty() || mStopping; });
+		tasks.swap(mTasks);
+	}
+	for (std::function<void()>& task : tasks)
+	{
+		task();
+	}
+	uncork();
+	return !tasks.empty();
+}
+
+void LoopbackEventLoop::addListener(SOCKET /*listener*/)
+{
+}
+
+void LoopbackEventLoop::stopAccepting()
+{
+}
+
+void LoopbackEventLoop::adopt(SOCKET /*client*/, TlsSession* /*tls*/)
+{
+}
+
+void LoopbackEventLoop::post(std::function<void()> task)
+{
+	{
+		std::lock_guard<mutex> lock(mTasksLock);
+		mTasks.push_back(std::move(task));
+	}
+	mTasksReady.notify_one();
+}
+
+void LoopbackEventLoop::flush(Connection& connection)
+{
+	OutboundQueue& outbound = connection.seal();
+	auto it = mClients.find(&connection);
+	if (it == mClients.end()) return;
+	Segment segments[SEND_SEGMENTS];
+	while (!outbound.empty())
+	{
+		int count = outbound.gather(segments, SEND_SEGMENTS);
+		size_t len = 0;
+		for (int i = 0; i < count; i++)
+		{
+			it->second.received.write(segments[i].data, segments[i].len);
+			len += segments[i].len;
+		}
+		outbound.advance(len);
+	}
+}
+
+void LoopbackEventLoop::cork(Connection& connection)
+{
+	if (connection.isCorked() || connection.isClosed()) return;
+	connection.setCorked(true);
+	mCorked.push_back(connection.shared_from_this());
+}
+
+void LoopbackEventLoop::uncork()
+{
+	// By index: a flush may run callbacks that cork others, as in EventLoop.
+	for (size_t i = 0; i < mCorked.size(); i++)
+	{
+		std::shared_ptr<Connection> connection = mCorked[i];
+		connection->setCorked(false);
+		if (!connection->isClosed()) flush(*connection);
+	}
+	mCorked.clear();
+}
+
+void LoopbackEventLoop::close(Connection& connection)
+{
+	if (connection.isClosed()) return;
+	connection.markClosed();
+	mEvents->onClose(connection);
+	//The client may be the last owner of the connection.
+	auto it = mClients.find(&connection);
+	if (it == mClients.end()) return;
+	std::shared_ptr<Connection> keep = it->second.connection;
+	mClients.erase(it);
+}
+
+void LoopbackEventLoop::setAwaiting(Connection& connection, const bool awaiting)
+{
+	connection.setAwaiting(awaiting);
+}
+
+void LoopbackEventLoop::setOutboundLimits(const size_t /*highWatermark*/, const size_t /*lowWatermark*/, const unsigned int /*evictAfterMs*/)
+{
+}
+
+unsigned int LoopbackEventLoop::getQueueDelay() const
+{
+	return 0;
+}
+
+string LoopbackEventLoop::getPeerAddress(const Connection& connection) const
+{
+	auto it = mClients.find(&connection);
+	if (it == mClients.end()) return string();
+	return it->second.address;
+}
+
+void LoopbackEventLoop::run()
+{
+	while (true)
+	{
+		{
+			std::lock_guard<mutex> lock(mTasksLock);
+			if (mStopping && mTasks.empty()) break;
+		}
+		runTasks(LOOPBACK_WAIT_MS);
+	}
+}
+
+void LoopbackEventLoop::stop()
+{
+	{
+		std::lock_guard<mutex> lock(mTasksLock);
+		mStopping = true;
+	}
+	mTasksReady.notify_one();
+}
+
+void LoopbackEventLoop::handOff()
+{
+	stop();
+}
+
+void LoopbackEventLoop::release(std::vector<SOCKET>& /*listeners*/, std::vector<std::shared_ptr<Connection>>& /*connections*/)
+{
+}
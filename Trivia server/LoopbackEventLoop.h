@@ -0,0 +1,152 @@
+#pragma once
+
+#include "IEventLoop.h"
+#include "FrameParser.h"
+#include "RingBuffer.h"
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <memory>
+#include <string>
+
+using std::map;
+using std::string;
+using std::vector;
+using std::mutex;
+
+#define LOOPBACK_WAIT_MS 100 // Longest a run() without tasks sleeps, stop() wakes it earlier.
+
+/****
+ * @brief A loop without sockets that drives the protocol layer from the calling thread.
+ *
+ * Its connections are in memory: what a test or benchmark sends is appended to the
+ * inbound buffer and handed to IConnectionEvents::onData, the same path a loop takes
+ * after a read, and what the handlers queue is captured instead of written. Requests
+ * that await the database or run on the workers come back through post(), and those
+ * tasks run on the caller's thread while it waits for a response. There is no thread
+ * per connection and no kernel in between, so it measures the handlers and managers alone.
+ *
+ * Only the thread that created the loop may call it, apart from post().
+ ****/
+class LoopbackEventLoop : public IEventLoop
+{
+public:
+    /****
+     * @brief Constructs a loop that reports to the given protocol layer.
+     *
+     * @param events The receiver of connection callbacks.
+     ****/
+    LoopbackEventLoop(IConnectionEvents* events);
+    virtual ~LoopbackEventLoop();
+
+    /****
+     * @brief Opens an in-memory connection, raises IConnectionEvents::onOpen.
+     *
+     * @param address The client address it is rate limited by.
+     * @returns The connection, owned by the loop until it is closed.
+     ****/
+    std::shared_ptr<Connection> connect(const string& address);
+
+    /****
+     * @brief Hands bytes to the connection as if its client sent them, handles the requests
+     * that are complete and captures the responses that are ready.
+     *
+     * @param bytes One or more frames, or a part of one.
+     ****/
+    void send(Connection& connection, const string& bytes);
+
+    /****
+     * @brief Takes the next response frame the connection got. While there is none, runs
+     * the posted tasks, which finish the awaited and dispatched requests.
+     *
+     * @param response Receives the code, the request ID and the body.
+     * @param timeoutMs How long to wait for the workers in total.
+     * @returns False if no response came in time, or the connection was closed without one.
+     ****/
+    bool receive(Connection& connection, RequestInfo& response, const unsigned int timeoutMs);
+
+    /****
+     * @brief Sessions are opened by connect(), there is nothing to listen on or adopt.
+     ****/
+    virtual void addListener(SOCKET listener) override;
+    virtual void stopAccepting() override;
+    virtual void adopt(SOCKET client, TlsSession* tls = nullptr) override;
+
+    /****
+     * @brief Queues a task for the caller's thread. Safe to call from any thread.
+     ****/
+    virtual void post(std::function<void()> task) override;
+
+    /****
+     * @brief Captures the connection's queued responses. Nothing blocks, so nothing is ever left.
+     ****/
+    virtual void flush(Connection& connection) override;
+    virtual void cork(Connection& connection) override;
+
+    /****
+     * @brief Closes a connection. Raises IConnectionEvents::onClose, what it did not receive is dropped.
+     ****/
+    virtual void close(Connection& connection) override;
+
+    /****
+     * @brief Only marks the connection, its client sends the next request once it got the responses.
+     ****/
+    virtual void setAwaiting(Connection& connection, const bool awaiting) override;
+
+    /****
+     * @brief Responses are captured as they come, so the queues are not bounded.
+     ****/
+    virtual void setOutboundLimits(const size_t highWatermark, const size_t lowWatermark, const unsigned int evictAfterMs) override;
+
+    /****
+     * @returns 0, no request waits for other connections.
+     ****/
+    virtual unsigned int getQueueDelay() const override;
+
+    /****
+     * @returns The address passed to connect().
+     ****/
+    virtual string getPeerAddress(const Connection& connection) const override;
+
+    /****
+     * @brief Runs the posted tasks until stop() is called.
+     ****/
+    virtual void run() override;
+    virtual void stop() override;
+
+    /****
+     * @brief Nothing can be handed to another process, handOff() only stops the loop.
+     ****/
+    virtual void handOff() override;
+    virtual void release(std::vector<SOCKET>& listeners, std::vector<std::shared_ptr<Connection>>& connections) override;
+
+private:
+    /****
+     * @brief Runs the tasks posted until now, then captures what they corked.
+     *
+     * @param timeoutMs How long to wait for the first task.
+     * @returns False if none came in time.
+     ****/
+    bool runTasks(const unsigned int timeoutMs);
+
+    /****
+     * @brief Captures the responses of every corked connection.
+     ****/
+    void uncork();
+
+    struct Client
+    {
+        std::shared_ptr<Connection> connection;
+        string address;
+        RingBuffer received; // Response frames not taken by receive() yet.
+    };
+
+    IConnectionEvents* mEvents;
+    map<const Connection*, Client> mClients;
+    vector<std::shared_ptr<Connection>> mCorked;
+    mutex mTasksLock;
+    std::condition_variable mTasksReady;
+    vector<std::function<void()>> mTasks; // Guarded by mTasksLock.
+    bool mStopping; // Guarded by mTasksLock.
+};
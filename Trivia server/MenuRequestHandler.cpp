@@ -1,6 +1,29 @@
 #include "MenuRequestHandler.h"
 #include "JsonResponsePacketSerializer.h"
 #include "JsonRequestPacketDeserializer.h"
+#include "StatisticsManager.h"
+#include "RoomManager.h"
+#include "PollAdvisor.h"
+unsigned int MenuRequestHandler::getVersion(const RequestInfo& reqInfo)
+{
+	switch (reqInfo.code)
+	{
+	case GET_ROOMS_REQUEST:
+		return RoomManager::getInstance()->getVersion();
+	case GET_HIGH_SCORE_REQUEST:
+	case GET_PERSONAL_STATS_REQUEST:
+		return StatisticsManager::getInstance()->getVersion();
+	default:
+		return NO_VERSION;
+	}
+}
+
+unsigned int MenuRequestHandler::getPollInterval(const RequestInfo& reqInfo)
+{
+	if (reqInfo.code != GET_ROOMS_REQUEST) return NO_POLL_HINT;
+	return PollAdvisor::getInstance()->forRoomList(RoomManager::getInstance()->getLastChange());
+}
+
 bool MenuRequestHandler::isRequestRelevant(const RequestInfo& reqInfo)
 {
 	switch (reqInfo.code)
@@ -18,7 +41,7 @@ bool MenuRequestHandler::isRequestRelevant(const RequestInfo& reqInfo)
 	}
 }
 
-RequestResult MenuRequestHandler::handleRequest(const RequestInfo& reqInfo)
+Task<RequestResult> MenuRequestHandler::handleRequest(const RequestInfo& reqInfo)
 {
 	switch (reqInfo.code)
 	{
@@ -72,6 +95,7 @@ RequestResult MenuRequestHandler::getRooms(const RequestInfo& reqInfo)
 	GetRoomsResponse response;
 	response.rooms = mFactory->getRoomManager()->getRooms();
 	response.status = SUCCESS;
+	response.pollAfter = getPollInterval(reqInfo);
 	RequestResult result;
 	result.buffer = JsonResponsePacketSerializer::serializeResponse(response);
 	result.nextHandler = this;
@@ -138,6 +162,15 @@ RequestResult MenuRequestHandler::joinRoom(const RequestInfo& reqInfo)
 RequestResult MenuRequestHandler::createRoom(const RequestInfo& reqInfo)
 {
 	CreateRoomRequest request = JsonRequestPacketDeserializer::deserializeCreateRoomRequest(reqInfo);
+	if (mFactory->getRoomManager()->isDraining())
+	{
+		ErrorResponse response;
+		response.message = "The server is shutting down!";
+		RequestResult result;
+		result.buffer = JsonResponsePacketSerializer::serializeResponse(response);
+		result.nextHandler = this;
+		return result;
+	}
 	RoomData roomData;
 	roomData.maxPlayers = request.maxUsers;
 	roomData.name = request.roomName;
@@ -37,7 +37,23 @@ public:
 	* @param reqInfo A reference to a RequestInfo object containing information about the request.
 	* @return A RequestResult object containing the response data and potentially the next handler.
 	*/
-	virtual RequestResult handleRequest(const RequestInfo& reqInfo) override;
+	virtual Task<RequestResult> handleRequest(const RequestInfo& reqInfo) override;
+
+	/**
+	* Gets the version of the state a read request returns.
+	*
+	* @param reqInfo A reference to a RequestInfo object containing information about the request.
+	* @return The current version, or NO_VERSION if the request is not versioned.
+	*/
+	virtual unsigned int getVersion(const RequestInfo& reqInfo) override;
+
+	/**
+	* Gets how long a client should wait before it polls a request again.
+	*
+	* @param reqInfo A reference to a RequestInfo object containing information about the request.
+	* @return The interval in milliseconds, or NO_POLL_HINT if the request is not polled.
+	*/
+	virtual unsigned int getPollInterval(const RequestInfo& reqInfo) override;
 
 	/**
    * @brief Constructor for the MenuRequestHandler.
@@ -0,0 +1,118 @@
+#include "NotificationCenter.h"
+#include "IEventLoop.h"
+#include <algorithm>
+
+NotificationCenter* NotificationCenter::instancePtr = nullptr;
+
+NotificationCenter::NotificationCenter()
+{
+	mListener = nullptr;
+}
+
+NotificationCenter* NotificationCenter::getInstance()
+{
+	if (instancePtr == nullptr)
+	{
+		instancePtr = new NotificationCenter();
+	}
+	return instancePtr;
+}
+
+void NotificationCenter::setListener(INotificationListener* listener)
+{
+	mListener = listener;
+}
+
+void NotificationCenter::registerUser(const string& username, std::weak_ptr<Connection> connection)
+{
+	std::lock_guard<mutex> lock(mLock);
+	mSubscribers[username] = Subscriber{ connection, 0 };
+}
+
+void NotificationCenter::unregisterUser(const string& username)
+{
+	std::lock_guard<mutex> lock(mLock);
+	mSubscribers.erase(username);
+}
+
+std::shared_ptr<Connection> NotificationCenter::getConnection(const string& username)
+{
+	std::lock_guard<mutex> lock(mLock);
+	auto it = mSubscribers.find(username);
+	if (it == mSubscribers.end()) return nullptr;
+	return it->second.connection.lock();
+}
+
+unsigned int NotificationCenter::getTopics(const string& username)
+{
+	std::lock_guard<mutex> lock(mLock);
+	auto it = mSubscribers.find(username);
+	return it == mSubscribers.end() ? 0 : it->second.topics;
+}
+
+bool NotificationCenter::subscribe(const string& username, const Topic topic)
+{
+	std::lock_guard<mutex> lock(mLock);
+	auto it = mSubscribers.find(username);
+	if (it == mSubscribers.end()) return false;
+	it->second.topics |= topic;
+	return true;
+}
+
+void NotificationCenter::unsubscribe(const string& username, const Topic topic)
+{
+	std::lock_guard<mutex> lock(mLock);
+	auto it = mSubscribers.find(username);
+	if (it != mSubscribers.end()) it->second.topics &= ~topic;
+}
+
+bool NotificationCenter::hasSubscribers(const vector<string>& usernames, const Topic topic)
+{
+	std::lock_guard<mutex> lock(mLock);
+	for (const string& username : usernames)
+	{
+		auto it = mSubscribers.find(username);
+		if (it != mSubscribers.end() && (it->second.topics & topic)) return true;
+	}
+	return false;
+}
+
+void NotificationCenter::publish(const vector<string>& usernames, const Notification& notification)
+{
+	// The receivers grouped by the loop that owns them, there are only as many loops as reactors.
+	vector<std::pair<IEventLoop*, vector<std::weak_ptr<Connection>>>> batches;
+	{
+		std::lock_guard<mutex> lock(mLock);
+		for (const string& username : usernames)
+		{
+			auto it = mSubscribers.find(username);
+			if (it == mSubscribers.end() || !(it->second.topics & notification.topic)) continue;
+			std::shared_ptr<Connection> connection = it->second.connection.lock();
+			if (connection == nullptr) continue;
+			auto batch = std::find_if(batches.begin(), batches.end(), [&](const auto& batch) { return batch.first == connection->getLoop(); });
+			if (batch == batches.end())
+			{
+				batches.emplace_back(connection->getLoop(), vector<std::weak_ptr<Connection>>());
+				batch = batches.end() - 1;
+			}
+			batch->second.push_back(connection);
+		}
+	}
+	if (batches.empty()) return;
+	INotificationListener* listener = mListener;
+	std::shared_ptr<const Notification> shared = std::make_shared<const Notification>(notification);
+	for (auto& batch : batches)
+	{
+		batch.first->post([targets = std::move(batch.second), shared, listener]()
+			{
+				for (const std::weak_ptr<Connection>& weak : targets)
+				{
+					std::shared_ptr<Connection> target = weak.lock();
+					if (target == nullptr || target->isClosed()) continue;
+					if (listener != nullptr) listener->onNotify(*target, *shared);
+					target->queue(shared->packet);
+					target->getLoop()->cork(*target); //With the replies and other pushes of this pass.
+				}
+			});
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Connection.h"
+#include "Packet.h"
+#include "Room.h"
+#include <map>
+#include <mutex>
+#include <memory>
+#include <vector>
+
+using std::map;
+using std::vector;
+using std::mutex;
+
+/*
+* What a user can subscribe to. Values are bit flags.
+*/
+enum Topic { ROOM_STATE_TOPIC = 1, GAME_TOPIC = 2 };
+
+/*
+* One pushed event: the frame to send and what the receiving side needs to react to it.
+*/
+struct Notification
+{
+	Topic topic;
+	std::shared_ptr<const Packet> packet;
+	RoomData room; //The new room state, for ROOM_STATE_TOPIC.
+	unsigned int gameId; //The game whose phase changed, for GAME_TOPIC.
+};
+
+/*
+* Receives every notification on the loop of the connection it goes to, right before it is queued.
+*/
+class INotificationListener
+{
+public:
+	virtual ~INotificationListener() = default;
+	virtual void onNotify(Connection& connection, const Notification& notification) = 0;
+};
+
+/****
+ * @brief Pushes events to the connections of logged in users, instead of letting them poll.
+ *
+ * The Communicator registers every logged in user with its connection. A user
+ * subscribes to topics, and the managers publish an event to a list of usernames
+ * whenever the state behind a topic changes. Delivery is posted to the loop that
+ * owns each connection, so publishers never touch sockets of other threads.
+ ****/
+class NotificationCenter
+{
+public:
+    /****
+     * @brief Deleted copy constructor to enforce singleton pattern.
+     ****/
+    NotificationCenter(const NotificationCenter& obj) = delete;
+
+    /****
+     * @brief Gets the singleton instance of NotificationCenter.
+     *
+     * @returns A pointer to the singleton instance of NotificationCenter.
+     ****/
+    static NotificationCenter* getInstance();
+
+    /****
+     * @brief Sets who reacts to notifications before they are sent (the Communicator).
+     ****/
+    void setListener(INotificationListener* listener);
+
+    /****
+     * @brief Binds a logged in user to its connection. Previous subscriptions are dropped.
+     ****/
+    void registerUser(const string& username, std::weak_ptr<Connection> connection);
+
+    /****
+     * @brief Forgets a user and its subscriptions, on logout or disconnect.
+     ****/
+    void unregisterUser(const string& username);
+
+    /****
+     * @returns The connection a user is registered with, nullptr if it is not registered.
+     ****/
+    std::shared_ptr<Connection> getConnection(const string& username);
+
+    /****
+     * @returns The topics a user is subscribed to, as a mask of Topic values, 0 if it is not registered.
+     ****/
+    unsigned int getTopics(const string& username);
+
+    /****
+     * @brief Subscribes a registered user to a topic.
+     *
+     * @returns False if the user is not registered.
+     ****/
+    bool subscribe(const string& username, const Topic topic);
+
+    /****
+     * @brief Unsubscribes a user from a topic.
+     ****/
+    void unsubscribe(const string& username, const Topic topic);
+
+    /****
+     * @brief Checks whether any of the users is subscribed to a topic, so publishers can skip serializing.
+     ****/
+    bool hasSubscribers(const vector<string>& usernames, const Topic topic);
+
+    /****
+     * @brief Sends a notification to the users that are subscribed to its topic.
+     *
+     * The frame was serialized once by the publisher, every receiver queues that
+     * same immutable packet. Delivery is one task per loop for all of its receivers.
+     *
+     * @param usernames The users the event concerns.
+     * @param notification The event, its packet is shared by every receiver.
+     ****/
+    void publish(const vector<string>& usernames, const Notification& notification);
+
+private:
+    NotificationCenter();
+
+    struct Subscriber
+    {
+        std::weak_ptr<Connection> connection;
+        unsigned int topics;
+    };
+
+    map<string, Subscriber> mSubscribers;
+    INotificationListener* mListener;
+    mutex mLock;
+    static NotificationCenter* instancePtr;
+};
@@ -0,0 +1,134 @@
+#include "OutboundQueue.h"
+#include <algorithm>
+
+OutboundQueue::OutboundQueue()
+{
+	mOffset = 0;
+	mBytes = 0;
+}
+
+bool OutboundQueue::empty() const
+{
+	return mPackets.empty();
+}
+
+size_t OutboundQueue::size() const
+{
+	return mBytes;
+}
+
+void OutboundQueue::push(Packet&& packet)
+{
+	mBytes += packet.size();
+	mPackets.push_back(Entry{ std::move(packet), nullptr });
+}
+
+void OutboundQueue::push(std::shared_ptr<const Packet> packet)
+{
+	mBytes += packet->size();
+	mPackets.push_back(Entry{ Packet(), std::move(packet) });
+}
+
+int OutboundQueue::gather(Segment* segments, const int max) const
+{
+	int count = 0;
+	size_t skip = mOffset;
+	for (auto it = mPackets.begin(); it != mPackets.end() && count < max; ++it)
+	{
+		const Packet& packet = it->get();
+		if (skip < packet.headerSize)
+		{
+			segments[count++] = Segment{ (const char*)packet.header + skip, packet.headerSize - skip };
+			skip = 0;
+		}
+		else
+		{
+			skip -= packet.headerSize;
+		}
+		if (count < max && skip < packet.body.size())
+		{
+			segments[count++] = Segment{ packet.body.data() + skip, packet.body.size() - skip };
+		}
+		skip = 0;
+	}
+	return count;
+}
+
+void OutboundQueue::advance(size_t len)
+{
+	mBytes -= std::min(len, mBytes);
+	while (len > 0 && !mPackets.empty())
+	{
+		size_t left = mPackets.front().get().size() - mOffset;
+		if (len < left)
+		{
+			mOffset += len;
+			return;
+		}
+		len -= left;
+		mOffset = 0;
+		mPackets.pop_front();
+	}
+}
+
+void OutboundQueue::prepend(OutboundQueue& other)
+{
+	if (other.empty()) return;
+	if (!empty())
+	{
+		other.mPackets.insert(other.mPackets.end(), std::make_move_iterator(mPackets.begin()), std::make_move_iterator(mPackets.end()));
+	}
+	mPackets.swap(other.mPackets);
+	mOffset = other.mOffset;
+	mBytes += other.mBytes;
+	other.mPackets.clear();
+	other.mOffset = 0;
+	other.mBytes = 0;
+}
+
+void OutboundQueue::append(OutboundQueue& other)
+{
+	if (other.empty()) return;
+	if (other.mOffset != 0)
+	{
+		const Packet& first = other.mPackets.front().get();
+		size_t skip = other.mOffset;
+		Packet rest;
+		rest.headerSize = 0;
+		if (skip < first.headerSize) rest.body.append((const char*)first.header + skip, first.headerSize - skip);
+		skip -= std::min(skip, (size_t)first.headerSize);
+		rest.body.append(first.body, skip, string::npos);
+		other.mPackets.pop_front();
+		other.mPackets.push_front(Entry{ std::move(rest), nullptr });
+		other.mOffset = 0;
+	}
+	mPackets.insert(mPackets.end(), std::make_move_iterator(other.mPackets.begin()), std::make_move_iterator(other.mPackets.end()));
+	mBytes += other.mBytes;
+	other.mPackets.clear();
+	other.mBytes = 0;
+}
+
+string OutboundQueue::copyBytes() const
+{
+	string bytes;
+	bytes.reserve(mBytes);
+	size_t skip = mOffset;
+	for (const Entry& entry : mPackets)
+	{
+		const Packet& packet = entry.get();
+		if (skip < packet.headerSize) bytes.append((const char*)packet.header + skip, packet.headerSize - skip);
+		skip -= std::min(skip, (size_t)packet.headerSize);
+		if (skip < packet.body.size()) bytes.append(packet.body, skip, string::npos);
+		skip = 0;
+	}
+	return bytes;
+}
+
+void OutboundQueue::pushBytes(string&& bytes)
+{
+	if (bytes.empty()) return;
+	Packet packet;
+	packet.body = std::move(bytes);
+	packet.headerSize = 0;
+	push(std::move(packet));
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Packet.h"
+#include "Socket.h"
+#include <deque>
+#include <memory>
+
+using std::deque;
+
+/****
+ * @brief The responses of one connection that were not fully written yet.
+ *
+ * Packets are queued as they are, the queue hands their header and body
+ * segments to a vectored send and remembers how far the first packet got,
+ * so a partial write resumes in the middle of a segment. A broadcast packet
+ * is shared by the queues of all its receivers, it is never copied.
+ ****/
+class OutboundQueue
+{
+public:
+    OutboundQueue();
+
+    bool empty() const; //getter
+
+    /****
+     * @returns The number of bytes still to be written.
+     ****/
+    size_t size() const;
+
+    /****
+     * @brief Queues a packet after the ones already waiting.
+     ****/
+    void push(Packet&& packet);
+
+    /****
+     * @brief Queues a packet that other queues hold too. It is sent from where it is.
+     ****/
+    void push(std::shared_ptr<const Packet> packet);
+
+    /****
+     * @brief Describes the unsent bytes as segments, in order, starting from the first unsent byte.
+     *
+     * @param segments Receives the segments.
+     * @param max The capacity of segments.
+     * @returns The number of segments filled.
+     ****/
+    int gather(Segment* segments, const int max) const;
+
+    /****
+     * @brief Drops bytes that were written, releasing packets that are done.
+     *
+     * @param len The number of bytes written, at most size().
+     ****/
+    void advance(size_t len);
+
+    /****
+     * @brief Moves every packet of another queue in front of this queue's packets.
+     *
+     * @param other The queue to empty. Its partial write progress is kept.
+     ****/
+    void prepend(OutboundQueue& other);
+
+    /****
+     * @brief Moves every packet of another queue after this queue's packets. Shared packets stay shared.
+     *
+     * @param other The queue to empty. A packet it wrote part of is copied from the first unsent byte.
+     ****/
+    void append(OutboundQueue& other);
+
+    /****
+     * @returns The unsent bytes in one string, as they would go on the wire.
+     ****/
+    string copyBytes() const;
+    /****
+     * @brief Queues bytes that are already framed, such as the queue of a connection handed over by another process.
+     ****/
+    void pushBytes(string&& bytes);
+private:
+    /****
+     * @brief A queued packet, owned by the queue or shared with other queues.
+     ****/
+    struct Entry
+    {
+        Packet owned;
+        std::shared_ptr<const Packet> shared;
+
+        const Packet& get() const
+        {
+            return shared != nullptr ? *shared : owned;
+        }
+    };
+
+    deque<Entry> mPackets;
+    size_t mOffset; // Bytes of the first packet already written.
+    size_t mBytes;
+};
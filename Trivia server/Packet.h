@@ -0,0 +1,109 @@
+#pragma once
+
+#include <string>
+
+using std::string;
+
+#define FRAME_HEADER_SIZE 5 // One byte code and four bytes little endian length.
+/*
+* Protocol extension: a code byte with this bit set is followed (after the length)
+* by a four bytes little endian request ID, and the response echoes it the same way.
+* Requests that carry an ID may be answered out of order.
+*/
+#define REQUEST_ID_FLAG 0x80
+#define REQUEST_ID_SIZE 4
+/*
+* Protocol extension: a code byte with this bit set is followed (after the length and request ID)
+* by the four bytes little endian version of the state the client last saw. Responses of versioned
+* reads carry the current version the same way, and NOT_MODIFIED_RESPONSE replaces the body when it matched.
+* Codes themselves therefore stay below 0x40.
+*/
+#define VERSION_FLAG 0x40
+#define VERSION_SIZE 4
+#define NO_VERSION 0 // State that is not versioned, never matches.
+#define CODE_MASK 0x3F
+#define MAX_HEADER_SIZE (FRAME_HEADER_SIZE + REQUEST_ID_SIZE + VERSION_SIZE)
+
+/*
+* A serialized response, kept as two segments: the protocol header and the JSON body.
+* The body is moved in from the serializer and sent from where it is, never copied
+* into one contiguous frame.
+*/
+struct Packet
+{
+	unsigned char header[MAX_HEADER_SIZE];
+	unsigned char headerSize;
+	string body;
+
+	Packet()
+	{
+		setHeader(0);
+	}
+	Packet(const unsigned char code, string&& message) : body(std::move(message))
+	{
+		setHeader(code);
+	}
+	unsigned char code() const
+	{
+		return header[0] & CODE_MASK;
+	}
+	size_t size() const
+	{
+		return headerSize + body.size();
+	}
+	/*
+	* Tags the response with the ID of the request it answers.
+	*/
+	void setRequestId(const unsigned int id)
+	{
+		header[0] |= REQUEST_ID_FLAG;
+		mRequestId = id;
+		setExtensions();
+	}
+	/*
+	* Tags the response with the version of the state it was read from.
+	*/
+	void setVersion(const unsigned int version)
+	{
+		header[0] |= VERSION_FLAG;
+		mVersion = version;
+		setExtensions();
+	}
+
+private:
+	void setHeader(const unsigned char code)
+	{
+		header[0] = code;
+		writeInt(1, (unsigned int)body.size());
+		headerSize = FRAME_HEADER_SIZE;
+		mRequestId = 0;
+		mVersion = NO_VERSION;
+	}
+	/*
+	* Lays out the extension fields after the length, the request ID first.
+	*/
+	void setExtensions()
+	{
+		headerSize = FRAME_HEADER_SIZE;
+		if (header[0] & REQUEST_ID_FLAG)
+		{
+			writeInt(headerSize, mRequestId);
+			headerSize += REQUEST_ID_SIZE;
+		}
+		if (header[0] & VERSION_FLAG)
+		{
+			writeInt(headerSize, mVersion);
+			headerSize += VERSION_SIZE;
+		}
+	}
+	void writeInt(const size_t at, const unsigned int value)
+	{
+		header[at] = value & 0xFF;
+		header[at + 1] = (value >> 8) & 0xFF;
+		header[at + 2] = (value >> 16) & 0xFF;
+		header[at + 3] = (value >> 24) & 0xFF;
+	}
+
+	unsigned int mRequestId;
+	unsigned int mVersion;
+};
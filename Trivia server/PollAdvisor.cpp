@@ -0,0 +1,75 @@
+#include "PollAdvisor.h"
+#include "Config.h"
+#include <algorithm>
+
+#define LOAD_WINDOW_MS 1000
+
+PollAdvisor* PollAdvisor::instancePtr = nullptr;
+
+static long long nowMs()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+PollAdvisor* PollAdvisor::getInstance()
+{
+	if (instancePtr == nullptr)
+	{
+		instancePtr = new PollAdvisor();
+	}
+	return instancePtr;
+}
+
+PollAdvisor::PollAdvisor()
+{
+	mBudget = (unsigned int)std::max(1, Config::getInstance()->getInt("poll_budget", DEFAULT_POLL_BUDGET));
+	mCount = 0;
+	mWindowStart = nowMs();
+	mRate = 0;
+}
+
+void PollAdvisor::onRequest()
+{
+	mCount++;
+	long long now = nowMs();
+	long long start = mWindowStart;
+	if (now - start < LOAD_WINDOW_MS) return;
+	//Only the thread that moves the window publishes its rate.
+	if (mWindowStart.compare_exchange_strong(start, now))
+	{
+		mRate = (unsigned int)(mCount.exchange(0) * 1000 / (now - start));
+	}
+}
+
+unsigned int PollAdvisor::forRoomList(const steady_clock::time_point lastChange)
+{
+	return scale(fromIdle(lastChange));
+}
+
+unsigned int PollAdvisor::forRoom(Room& room)
+{
+	RoomData& data = room.getRoomData();
+	if (data.state != RoomState::OPENED || room.getAllUsers().size() >= data.maxPlayers)
+	{
+		return scale(POLL_MIN_MS); //About to start, or already running.
+	}
+	return scale(fromIdle(room.getLastChange()));
+}
+
+unsigned int PollAdvisor::forGame()
+{
+	return scale(POLL_MIN_MS);
+}
+
+unsigned int PollAdvisor::fromIdle(const steady_clock::time_point lastChange) const
+{
+	long long idle = std::chrono::duration_cast<std::chrono::milliseconds>(steady_clock::now() - lastChange).count();
+	return (unsigned int)std::min<long long>(std::max<long long>(idle / POLL_IDLE_DIVISOR, POLL_MIN_MS), POLL_IDLE_MAX_MS);
+}
+
+unsigned int PollAdvisor::scale(const unsigned int interval) const
+{
+	unsigned int rate = mRate;
+	if (rate <= mBudget) return interval;
+	return (unsigned int)std::min<unsigned long long>((unsigned long long)interval * rate / mBudget, POLL_MAX_MS);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Room.h"
+#include <atomic>
+#include <chrono>
+
+#define POLL_MIN_MS 250 // State that is about to change: a full room, a running game.
+#define POLL_IDLE_MAX_MS 5000 // The longest interval an idle state backs off to without load.
+#define POLL_MAX_MS 30000 // The longest interval under overload.
+#define POLL_IDLE_DIVISOR 4 // An idle state is polled again after a quarter of the time it has been idle.
+#define DEFAULT_POLL_BUDGET 50000 // Requests per second before every interval stretches ("poll_budget" setting).
+
+using std::chrono::steady_clock;
+
+/****
+ * @brief Tells polling clients how long to wait before they poll again.
+ *
+ * Screens without push poll GET_ROOMS, GET_ROOM_STATE and SUBMIT_ANSWER. Their
+ * responses carry a "pollAfter" hint in milliseconds: short for state that is
+ * about to change (a full room, a running game), growing with the time a state
+ * has been idle. When the server handles more requests per second than the
+ * budget, every hint stretches by the same factor, so the combined polling rate
+ * of the clients comes back to the budget without dropping any of them.
+ ****/
+class PollAdvisor
+{
+public:
+    /****
+     * @brief Deleted copy constructor to enforce singleton pattern.
+     ****/
+    PollAdvisor(const PollAdvisor& obj) = delete;
+
+    /****
+     * @brief Gets the singleton instance of PollAdvisor.
+     *
+     * @returns A pointer to the singleton instance of PollAdvisor.
+     ****/
+    static PollAdvisor* getInstance();
+
+    /****
+     * @brief Counts one handled request towards the measured load. Safe from any thread.
+     ****/
+    void onRequest();
+
+    /****
+     * @brief Gets the hint for the room list.
+     *
+     * @param lastChange When a room was last created, deleted or changed state.
+     * @returns The interval in milliseconds.
+     ****/
+    unsigned int forRoomList(const steady_clock::time_point lastChange);
+
+    /****
+     * @brief Gets the hint for a room's state: tight when the room is full or started, backing off while it idles.
+     *
+     * @param room The room.
+     * @returns The interval in milliseconds.
+     ****/
+    unsigned int forRoom(Room& room);
+
+    /****
+     * @brief Gets the hint for a player waiting for the others during a round.
+     *
+     * @returns The interval in milliseconds.
+     ****/
+    unsigned int forGame();
+
+private:
+    PollAdvisor();
+
+    /****
+     * @brief Gets the interval of a state by the time it has been idle.
+     ****/
+    unsigned int fromIdle(const steady_clock::time_point lastChange) const;
+
+    /****
+     * @brief Stretches an interval by the current overload factor.
+     ****/
+    unsigned int scale(const unsigned int interval) const;
+
+    unsigned int mBudget;
+    std::atomic<unsigned int> mCount; // Requests since the window started.
+    std::atomic<long long> mWindowStart; // Milliseconds on the steady clock.
+    std::atomic<unsigned int> mRate; // Requests per second of the last full window.
+    static PollAdvisor* instancePtr;
+};
@@ -0,0 +1,103 @@
+#include "PollEventLoop.h"
+#include <algorithm>
+
+PollEventLoop::PollEventLoop(IConnectionEvents* events) : EventLoop(events)
+{
+	Socket::createWakeupPair(mWakeRead, mWakeWrite);
+}
+
+PollEventLoop::~PollEventLoop()
+{
+	Socket::closeSocket(mWakeRead);
+	if (mWakeWrite != mWakeRead) Socket::closeSocket(mWakeWrite);
+}
+
+void PollEventLoop::addListener(SOCKET listener)
+{
+	post([this, listener]() { mListeners.push_back(listener); });
+}
+
+void PollEventLoop::run()
+{
+	mThreadId = std::this_thread::get_id();
+	vector<pollfd> fds;
+	while (!mStopping)
+	{
+		uncork(); //Before the set is built, so what did not fit asks for POLLOUT.
+		fds.clear();
+		fds.push_back(pollfd{ mWakeRead, POLLIN, 0 });
+		for (SOCKET listener : mListeners)
+		{
+			fds.push_back(pollfd{ listener, POLLIN, 0 });
+		}
+		for (auto& it : mConnections)
+		{
+			short events = it.second->isReadStopped() ? 0 : POLLIN;
+			if (it.second->getUnsentBytes() != 0) events |= POLLOUT;
+			fds.push_back(pollfd{ it.first, events, 0 });
+		}
+
+		endPass();
+		int count = POLL_FUNCTION(fds.data(), (unsigned long)fds.size(), mTimers.getTimeout());
+		beginPass();
+		if (count < 0)
+		{
+			if (Socket::wouldBlock()) continue;
+			break;
+		}
+		expireTimers();
+
+		if (fds[0].revents & POLLIN)
+		{
+			char drain[64];
+			while (Socket::receive(mWakeRead, drain, sizeof(drain)) > 0);
+			runTasks();
+		}
+		for (size_t i = 1; i < fds.size(); i++)
+		{
+			if (fds[i].revents == 0) continue;
+			if (i <= mListeners.size())
+			{
+				acceptAll(fds[i].fd);
+				continue;
+			}
+			shared_ptr<Connection> connection = find(fds[i].fd);
+			if (connection == nullptr) continue;
+			if (fds[i].revents & (POLLERR | POLLNVAL))
+			{
+				close(*connection);
+				continue;
+			}
+			if (fds[i].revents & (POLLIN | POLLHUP))
+			{
+				handleReadable(connection, false);
+			}
+			if ((fds[i].revents & POLLOUT) && !connection->isClosed())
+			{
+				flush(*connection);
+			}
+		}
+	}
+	runTasks();
+	closeAll();
+}
+
+void PollEventLoop::watch(Connection& /*connection*/)
+{
+	// The poll set is rebuilt from the connection table on every iteration.
+}
+
+void PollEventLoop::unwatch(Connection& /*connection*/)
+{
+}
+
+void PollEventLoop::setReading(Connection& /*connection*/, const bool /*reading*/)
+{
+	//The descriptors are rebuilt every iteration from isReadPaused().
+}
+
+void PollEventLoop::wake()
+{
+	char byte = 0;
+	Socket::sendSome(mWakeWrite, &byte, 1);
+}
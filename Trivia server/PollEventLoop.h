@@ -0,0 +1,41 @@
+#pragma once
+
+#include "EventLoop.h"
+
+#ifdef _WIN32
+#define POLL_FUNCTION WSAPoll
+#else
+#include <poll.h>
+#define POLL_FUNCTION poll
+#endif
+
+/****
+ * @brief A level-triggered loop on poll (WSAPoll on Windows).
+ *
+ * Used where epoll is not available. The poll set is rebuilt every iteration,
+ * so it is O(connections) per wakeup, which is fine for a development box.
+ ****/
+class PollEventLoop : public EventLoop
+{
+public:
+    /****
+     * @brief Creates the wakeup socket pair.
+     *
+     * @param events The receiver of connection callbacks.
+     ****/
+    PollEventLoop(IConnectionEvents* events);
+    virtual ~PollEventLoop();
+
+    virtual void addListener(SOCKET listener) override;
+    virtual void run() override;
+
+protected:
+    virtual void watch(Connection& connection) override;
+    virtual void unwatch(Connection& connection) override;
+    virtual void wake() override;
+    virtual void setReading(Connection& connection, const bool reading) override;
+
+private:
+    SOCKET mWakeRead;
+    SOCKET mWakeWrite;
+};
@@ -0,0 +1,113 @@
+#include "RateLimiter.h"
+#include "Config.h"
+#include <algorithm>
+#include <chrono>
+
+#define TOKEN 1000 // One request, buckets count thousandths so slow rates refill smoothly.
+#define ADDRESS_SWEEP_INTERVAL 1024 // Connections opened between sweeps of the addresses that went quiet.
+
+static const char* CLASS_NAMES[REQUEST_CLASSES] = { "gameplay", "lobby", "auth", "statistics" };
+static const int DEFAULT_RATES[REQUEST_CLASSES] = { 100, 50, 5, 10 };
+// Many players may share one address behind a NAT, a game is only limited per connection.
+static const int DEFAULT_ADDRESS_RATES[REQUEST_CLASSES] = { 0, 1000, 20, 100 };
+
+RateLimiter* RateLimiter::instancePtr = nullptr;
+
+static long long nowMs()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+RateLimiter* RateLimiter::getInstance()
+{
+	if (instancePtr == nullptr)
+	{
+		instancePtr = new RateLimiter();
+	}
+	return instancePtr;
+}
+
+RateLimiter::RateLimiter()
+{
+	Config* config = Config::getInstance();
+	mEnabled = config->getInt("rate_limits", 1) != 0;
+	mBurst = (unsigned int)std::max(1, config->getInt("rate_burst", DEFAULT_RATE_BURST));
+	for (int i = 0; i < REQUEST_CLASSES; i++)
+	{
+		mRates[i] = (unsigned int)std::max(0, config->getInt(string("rate_") + CLASS_NAMES[i], DEFAULT_RATES[i]));
+		mAddressRates[i] = (unsigned int)std::max(0, config->getInt(string("address_rate_") + CLASS_NAMES[i], DEFAULT_ADDRESS_RATES[i]));
+	}
+	mOpened = 0;
+}
+
+ClientLimits* RateLimiter::open(const string& address)
+{
+	if (!mEnabled) return nullptr;
+	long long now = nowMs();
+	ClientLimits* limits = new ClientLimits();
+	limits->retryAfter = 0;
+	for (int i = 0; i < REQUEST_CLASSES; i++)
+	{
+		fill(limits->buckets[i], mRates[i], now);
+	}
+	if (address.empty()) return limits;
+
+	std::lock_guard<mutex> lock(mAddressesLock);
+	if (++mOpened % ADDRESS_SWEEP_INTERVAL == 0)
+	{
+		// Only buckets that had a full refill go, a new one for the address starts the same.
+		long long refill = (long long)mBurst * 1000;
+		for (auto it = mAddresses.begin(); it != mAddresses.end();)
+		{
+			bool idle = it->second.use_count() == 1 && now - it->second->lastUsed.load() > refill;
+			it = idle ? mAddresses.erase(it) : std::next(it);
+		}
+	}
+	std::shared_ptr<AddressLimits>& shared = mAddresses[address];
+	if (shared == nullptr)
+	{
+		shared = std::make_shared<AddressLimits>();
+		for (int i = 0; i < REQUEST_CLASSES; i++)
+		{
+			fill(shared->buckets[i], mAddressRates[i], now);
+		}
+	}
+	shared->lastUsed = now;
+	limits->address = shared;
+	return limits;
+}
+
+bool RateLimiter::take(ClientLimits* limits, const unsigned char code)
+{
+	if (limits == nullptr) return true;
+	RequestClass requestClass = AdmissionController::classify(code);
+	long long now = nowMs();
+	limits->retryAfter = take(limits->buckets[requestClass], mRates[requestClass], now);
+	if (limits->retryAfter != 0) return false;
+	if (mAddressRates[requestClass] == 0 || limits->address == nullptr) return true;
+	limits->address->lastUsed = now;
+	std::lock_guard<mutex> lock(limits->address->lock);
+	limits->retryAfter = take(limits->address->buckets[requestClass], mAddressRates[requestClass], now);
+	// The connection's token is spent all the same, a refused client should not retry at once.
+	return limits->retryAfter == 0;
+}
+
+unsigned int RateLimiter::take(TokenBucket& bucket, const unsigned int rate, const long long now) const
+{
+	if (rate == 0) return 0;
+	long long capacity = (long long)rate * mBurst * TOKEN;
+	bucket.tokens = std::min(capacity, bucket.tokens + (now - bucket.last) * rate);
+	bucket.last = now;
+	if (bucket.tokens >= TOKEN)
+	{
+		bucket.tokens -= TOKEN;
+		return 0;
+	}
+	return (unsigned int)((TOKEN - bucket.tokens + rate - 1) / rate);
+}
+
+void RateLimiter::fill(TokenBucket& bucket, const unsigned int rate, const long long now) const
+{
+	bucket.tokens = (long long)rate * mBurst * TOKEN;
+	bucket.last = now;
+}
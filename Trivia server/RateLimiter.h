@@ -0,0 +1,113 @@
+#pragma once
+
+#include "AdmissionController.h"
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+using std::string;
+using std::map;
+using std::mutex;
+
+#define DEFAULT_RATE_BURST 2 // Seconds of a class's rate a bucket holds ("rate_burst" setting).
+
+/****
+ * @brief A token bucket in thousandths of a request, refilled continuously.
+ ****/
+struct TokenBucket
+{
+	long long tokens;
+	long long last; // Milliseconds on the steady clock of the last refill.
+};
+
+/****
+ * @brief The buckets of every source address, shared by all its connections. They outlive
+ * the connections, so a client that reconnects for every request keeps its spent tokens.
+ ****/
+struct AddressLimits
+{
+	mutex lock; // Connections of one address may live on different loops.
+	TokenBucket buckets[REQUEST_CLASSES];
+	std::atomic<long long> lastUsed; // Milliseconds on the steady clock of the last open or request.
+};
+
+/****
+ * @brief The buckets of one connection. Only its loop's thread touches them.
+ ****/
+struct ClientLimits
+{
+	TokenBucket buckets[REQUEST_CLASSES];
+	std::shared_ptr<AddressLimits> address; // nullptr without an address.
+	unsigned int retryAfter; // Milliseconds until the last refused class has a token again.
+};
+
+/****
+ * @brief Rate limits requests per connection and per source address with token buckets.
+ *
+ * Every request class has its own rate for a single connection ("rate_<class>",
+ * requests per second) and for all connections of one address ("address_rate_<class>"),
+ * where the class is gameplay, lobby, auth or statistics; 0 leaves it unlimited.
+ * A request takes a token from both of its buckets. The frame parser charges a
+ * frame by its header alone, so a refused request is dropped before its body is
+ * copied or parsed. "rate_limits=0" turns the limiter off.
+ ****/
+class RateLimiter
+{
+public:
+    /****
+     * @brief Deleted copy constructor to enforce singleton pattern.
+     ****/
+    RateLimiter(const RateLimiter& obj) = delete;
+
+    /****
+     * @brief Gets the singleton instance of RateLimiter.
+     *
+     * @returns A pointer to the singleton instance of RateLimiter.
+     ****/
+    static RateLimiter* getInstance();
+
+    /****
+     * @brief Creates the buckets of a new connection. Safe from any thread.
+     *
+     * @param address The source address of the connection. Without one, as for the clients of
+     * the Unix socket, it is only limited per connection: they would all share one bucket.
+     * @returns The buckets, owned by the caller, or nullptr when rate limiting is off.
+     ****/
+    ClientLimits* open(const string& address);
+
+    /****
+     * @brief Takes a token for one request from the connection's and its address's bucket.
+     * On refusal limits.retryAfter tells when the class has a token again.
+     *
+     * @param limits The buckets of the connection, nullptr admits everything.
+     * @param code The request code.
+     * @returns False if either bucket is empty.
+     ****/
+    bool take(ClientLimits* limits, const unsigned char code);
+
+private:
+    RateLimiter();
+
+    /****
+     * @brief Refills a bucket and takes a token from it when there is one.
+     *
+     * @returns 0 if a token was taken, otherwise the milliseconds until there is one.
+     ****/
+    unsigned int take(TokenBucket& bucket, const unsigned int rate, const long long now) const;
+
+    /****
+     * @brief Sets a new bucket full.
+     ****/
+    void fill(TokenBucket& bucket, const unsigned int rate, const long long now) const;
+
+    bool mEnabled;
+    unsigned int mBurst; // Seconds.
+    unsigned int mRates[REQUEST_CLASSES]; // Requests per second of one connection, 0 unlimited.
+    unsigned int mAddressRates[REQUEST_CLASSES]; // Requests per second of one address.
+    map<string, std::shared_ptr<AddressLimits>> mAddresses; // Kept until they refilled, see open().
+    unsigned long long mOpened; // Connections opened, paces the sweeps of mAddresses.
+    mutex mAddressesLock;
+    static RateLimiter* instancePtr;
+};
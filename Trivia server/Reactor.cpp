@@ -0,0 +1,63 @@
+#include "Reactor.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+Reactor::Reactor(IEventLoop* loop, const int core)
+{
+	mLoop = loop;
+	mCore = core;
+}
+
+Reactor::~Reactor()
+{
+	stop();
+	delete mLoop;
+}
+
+IEventLoop* Reactor::getLoop() const
+{
+	return mLoop;
+}
+
+void Reactor::listen(SOCKET listener)
+{
+	mLoop->addListener(listener);
+}
+
+void Reactor::start()
+{
+	mThread = std::thread(&Reactor::run, this);
+}
+
+void Reactor::run()
+{
+	if (mCore != NO_CORE)
+	{
+		pinThread(mCore);
+	}
+	mLoop->run();
+}
+
+void Reactor::stop()
+{
+	mLoop->stop();
+	if (mThread.joinable() && mThread.get_id() != std::this_thread::get_id())
+	{
+		mThread.join();
+	}
+}
+
+void Reactor::pinThread(const int core)
+{
+#ifdef _WIN32
+	SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << core);
+#elif defined(__linux__)
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+}
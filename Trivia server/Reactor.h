@@ -0,0 +1,66 @@
+#pragma once
+
+#include "IEventLoop.h"
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+#define NO_CORE (-1)
+
+/****
+ * @brief One shard of the server: an event loop, the listeners it accepts on and the thread that runs it.
+ *
+ * Every reactor keeps its own connection table (inside its loop) and, where the
+ * platform allows it, its own listener on the shared port, so accepting and
+ * serving clients never goes through another reactor.
+ ****/
+class Reactor
+{
+public:
+    /****
+     * @brief Constructs a reactor around a loop.
+     *
+     * @param loop The event loop of the reactor, owned by the reactor from now on.
+     * @param core The CPU to pin the reactor thread to, or NO_CORE.
+     ****/
+    Reactor(IEventLoop* loop, const int core);
+    ~Reactor();
+
+    IEventLoop* getLoop() const; //getter
+
+    /****
+     * @brief Accepts the connections of a listener on this reactor.
+     * The loop closes the listener when it stops.
+     *
+     * @param listener A non-blocking listening socket.
+     ****/
+    void listen(SOCKET listener);
+
+    /****
+     * @brief Runs the reactor on a new thread.
+     ****/
+    void start();
+
+    /****
+     * @brief Runs the reactor on the calling thread until it is stopped.
+     ****/
+    void run();
+
+    /****
+     * @brief Stops the loop and waits for the thread started by start().
+     ****/
+    void stop();
+
+private:
+    /****
+     * @brief Pins the calling thread to a CPU. Failures are ignored, pinning is only a hint.
+     *
+     * @param core The CPU index.
+     ****/
+    static void pinThread(const int core);
+
+    IEventLoop* mLoop;
+    int mCore;
+    std::thread mThread;
+};
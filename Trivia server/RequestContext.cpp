@@ -0,0 +1,19 @@
+#include "RequestContext.h"
+
+thread_local RequestContext* RequestContext::mCurrent = nullptr;
+
+RequestContext* RequestContext::getCurrent()
+{
+	return mCurrent;
+}
+
+RequestContext::Scope::Scope(RequestContext* context)
+{
+	mPrevious = mCurrent;
+	mCurrent = context;
+}
+
+RequestContext::Scope::~Scope()
+{
+	mCurrent = mPrevious;
+}
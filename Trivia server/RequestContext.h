@@ -0,0 +1,107 @@
+#pragma once
+
+#include <coroutine>
+#include <functional>
+#include <optional>
+#include <exception>
+#include <utility>
+
+/****
+ * @brief Where the coroutine of a suspended request continues.
+ *
+ * The Communicator makes a request's context current while the handler's code
+ * runs. Awaitables such as Offload use it to run blocking work off the loop and
+ * to resume the coroutine later on the connection's loop, with the handlers'
+ * lock held again. Without a current context (a sub-request of a batch, or a
+ * handler called outside the Communicator) they finish inline instead.
+ ****/
+class RequestContext
+{
+public:
+    virtual ~RequestContext() = default;
+
+    /****
+     * @brief Runs blocking work on a worker thread, then resumes the coroutine on the connection's loop.
+     *
+     * If the connection closes meanwhile, the coroutine is destroyed instead of resumed.
+     *
+     * @param work The blocking work. It must not touch the handlers or the managers.
+     * @param next The suspended coroutine.
+     ****/
+    virtual void offload(std::function<void()> work, std::coroutine_handle<> next) = 0;
+
+    /****
+     * @returns The context of the request running on this thread, nullptr if there is none.
+     ****/
+    static RequestContext* getCurrent();
+
+    /****
+     * @brief Makes a context current on this thread for as long as it lives.
+     ****/
+    class Scope
+    {
+    public:
+        Scope(RequestContext* context);
+        ~Scope();
+
+    private:
+        RequestContext* mPrevious;
+    };
+
+private:
+    static thread_local RequestContext* mCurrent;
+};
+
+/****
+ * @brief Awaits blocking work, a database query, without blocking the loop:
+ *
+ *     bool exists = co_await Offload<bool>([&]() { return db->doesUserExists(username); });
+ *
+ * The work may use the coroutine's locals, they live until it resumes. An
+ * exception thrown by the work is rethrown by the co_await.
+ ****/
+template<typename T>
+class Offload
+{
+public:
+    Offload(std::function<T()> work) : mWork(std::move(work)), mContext(nullptr)
+    {
+    }
+
+    bool await_ready()
+    {
+        mContext = RequestContext::getCurrent();
+        if (mContext != nullptr) return false;
+        run();
+        return true;
+    }
+
+    void await_suspend(std::coroutine_handle<> next)
+    {
+        mContext->offload([this]() { run(); }, next);
+    }
+
+    T await_resume()
+    {
+        if (mError) std::rethrow_exception(mError);
+        return std::move(*mValue);
+    }
+
+private:
+    void run()
+    {
+        try
+        {
+            mValue.emplace(mWork());
+        }
+        catch (...)
+        {
+            mError = std::current_exception();
+        }
+    }
+
+    std::function<T()> mWork;
+    RequestContext* mContext;
+    std::optional<T> mValue;
+    std::exception_ptr mError;
+};
@@ -57,6 +57,11 @@ GameManager* RequestHandlerFactory::getGameManager()
 	return GameManager::getInstance();
 }
 
+SessionManager* RequestHandlerFactory::getSessionManager()
+{
+	return SessionManager::getInstance();
+}
+
 RequestHandlerFactory* RequestHandlerFactory::getInstance()
 {
 	if (instancePtr == nullptr)
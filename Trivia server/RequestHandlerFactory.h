@@ -9,6 +9,7 @@
 #include "RoomMemberRequestHandler.h"
 #include "RoomAdminRequestHandler.h"
 #include "GameRequestHandler.h"
+#include "SessionManager.h"
 
 class LoginRequestHandler;
 class MenuRequestHandler;
@@ -99,6 +100,13 @@ public:
      ****/
     GameManager* getGameManager();
 
+    /****
+     * @brief Gets the SessionManager instance.
+     *
+     * @returns A pointer to the SessionManager instance.
+     ****/
+    SessionManager* getSessionManager();
+
     /****
      * @brief Deleted copy constructor to prevent copying.
      ****/
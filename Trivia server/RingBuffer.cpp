@@ -0,0 +1,88 @@
+#include "RingBuffer.h"
+#include <cstring>
+#include <algorithm>
+
+RingBuffer::RingBuffer()
+{
+	mHead = 0;
+	mTail = 0;
+}
+
+size_t RingBuffer::size() const
+{
+	return mTail - mHead;
+}
+
+bool RingBuffer::empty() const
+{
+	return mTail == mHead;
+}
+
+size_t RingBuffer::prepare(char*& data)
+{
+	if (size() == mData.size())
+	{
+		grow();
+	}
+	size_t mask = mData.size() - 1;
+	size_t tail = mTail & mask;
+	size_t head = mHead & mask;
+	data = mData.data() + tail;
+	// Free space runs to the end of the array, or up to the head once the data wrapped.
+	return (tail < head) ? head - tail : mData.size() - tail;
+}
+
+void RingBuffer::commit(const size_t len)
+{
+	mTail += len;
+}
+
+void RingBuffer::write(const char* data, const size_t len)
+{
+	size_t written = 0;
+	while (written < len)
+	{
+		char* space = nullptr;
+		size_t count = std::min(prepare(space), len - written);
+		std::memcpy(space, data + written, count);
+		commit(count);
+		written += count;
+	}
+}
+
+void RingBuffer::peek(const size_t offset, char* out, const size_t len) const
+{
+	if (len == 0) return;
+	size_t mask = mData.size() - 1;
+	size_t start = (mHead + offset) & mask;
+	size_t first = std::min(len, mData.size() - start);
+	std::memcpy(out, mData.data() + start, first);
+	std::memcpy(out + first, mData.data(), len - first);
+}
+
+void RingBuffer::peek(const size_t offset, string& out, const size_t len) const
+{
+	out.resize(len);
+	peek(offset, &out[0], len);
+}
+
+void RingBuffer::consume(const size_t len)
+{
+	mHead += len;
+	if (mHead == mTail)
+	{
+		// Empty again: start over so the next read gets the whole buffer in one piece.
+		mHead = 0;
+		mTail = 0;
+	}
+}
+
+void RingBuffer::grow()
+{
+	vector<char> data(std::max((size_t)RING_INITIAL_SIZE, mData.size() * 2));
+	size_t count = size();
+	peek(0, data.data(), count);
+	mData.swap(data);
+	mHead = 0;
+	mTail = count;
+}
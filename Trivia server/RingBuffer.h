@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#define RING_INITIAL_SIZE 4096 // Must be a power of two.
+
+/****
+ * @brief A growable circular byte buffer for received data.
+ *
+ * The socket reads straight into the free space of the buffer and parsed
+ * frames are dropped from the front without moving the bytes behind them.
+ * Memory is allocated on the first read and only again when a burst does not fit.
+ ****/
+class RingBuffer
+{
+public:
+    RingBuffer();
+
+    size_t size() const; //getter
+    bool empty() const; //getter
+
+    /****
+     * @brief Gets the contiguous free space at the end of the data, growing the buffer when it is full.
+     *
+     * @param data Receives where the next bytes should be written.
+     * @returns How many bytes can be written there.
+     ****/
+    size_t prepare(char*& data);
+
+    /****
+     * @brief Marks bytes written into the space given by prepare() as data.
+     *
+     * @param len The number of bytes written.
+     ****/
+    void commit(const size_t len);
+
+    /****
+     * @brief Appends a copy of some bytes.
+     ****/
+    void write(const char* data, const size_t len);
+
+    /****
+     * @brief Copies bytes without consuming them.
+     *
+     * @param offset Where to start, counted from the front of the data.
+     * @param out Receives the bytes, must hold len bytes.
+     * @param len The number of bytes, offset + len must not exceed size().
+     ****/
+    void peek(const size_t offset, char* out, const size_t len) const;
+
+    /****
+     * @brief Same as peek() but replaces the content of a string, reusing its capacity.
+     ****/
+    void peek(const size_t offset, string& out, const size_t len) const;
+
+    /****
+     * @brief Drops bytes from the front of the data.
+     *
+     * @param len The number of bytes to drop, at most size().
+     ****/
+    void consume(const size_t len);
+
+private:
+    /****
+     * @brief Moves the data to a buffer twice as large, from index 0.
+     ****/
+    void grow();
+
+    vector<char> mData;
+    size_t mHead; // Position of the first byte, positions only grow and are masked on access.
+    size_t mTail; // Position after the last byte.
+};
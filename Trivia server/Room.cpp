@@ -1,13 +1,22 @@
 #include "Room.h"
+#include "VersionCounter.h"
+#include "RoomManager.h"
+#include "NotificationCenter.h"
+#include "JsonResponsePacketSerializer.h"
+#include <algorithm>
 
 Room::Room()
 {
 	mMetaData = {0, "", 0, 0, 0, 0};
+	mVersion = VersionCounter::next();
+	mLastChange = std::chrono::steady_clock::now();
 }
 
 Room::Room(const RoomData& MetaData)
 {
 	mMetaData = MetaData;
+	mVersion = VersionCounter::next();
+	mLastChange = std::chrono::steady_clock::now();
 }
 
 bool Room::addUser(const LoggedUser& user)
@@ -20,12 +29,14 @@ bool Room::addUser(const LoggedUser& user)
 		}
 	}
 	mUsers.push_back(user);
+	notifyChanged();
 	return true;
 }
 
 void Room::removeUser(const LoggedUser& user)
 {
 	mUsers.erase(std::find(mUsers.begin(), mUsers.end(), user));
+	notifyChanged();
 }
 
 vector<string> Room::getAllUsers() const
@@ -47,5 +58,40 @@ RoomData& Room::getRoomData()
 
 void Room::setState(const RoomState state)
 {
+	if (mMetaData.state == (unsigned int)state) return;
 	mMetaData.state = state;
+	RoomManager::getInstance()->markChanged(); //The state is part of the room list.
+	notifyChanged();
+}
+
+unsigned int Room::getVersion() const
+{
+	return mVersion;
+}
+
+std::chrono::steady_clock::time_point Room::getLastChange() const
+{
+	return mLastChange;
+}
+
+void Room::notifyChanged()
+{
+	mVersion = VersionCounter::next();
+	mLastChange = std::chrono::steady_clock::now();
+	NotificationCenter* center = NotificationCenter::getInstance();
+	vector<string> users = getAllUsers();
+	if (!center->hasSubscribers(users, ROOM_STATE_TOPIC)) return;
+
+	RoomStateEvent event;
+	event.roomId = mMetaData.id;
+	event.roomState.status = SUCCESS;
+	event.roomState.questionCount = mMetaData.numOfQuestionsInGame;
+	event.roomState.answerTimeout = mMetaData.timePerQuestion;
+	event.roomState.state = mMetaData.state;
+	event.roomState.players = users;
+	Notification notification;
+	notification.topic = ROOM_STATE_TOPIC;
+	notification.packet = std::make_shared<const Packet>(JsonResponsePacketSerializer::serializeResponse(event));
+	notification.room = mMetaData;
+	center->publish(users, notification);
 }
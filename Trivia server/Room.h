@@ -3,6 +3,7 @@
 #include "LoggedUser.h"
 #include <iostream>
 #include <vector>
+#include <chrono>
 
 using std::string;
 using std::vector;
@@ -69,7 +70,26 @@ public:
 	*/
 	void setState(const RoomState state);
 
+	/*
+	* @returns the version of the room state, it grows on every change of the roster or the state.
+	*/
+	unsigned int getVersion() const;
+
+	/*
+	* @returns when the roster or the state last changed.
+	*/
+	std::chrono::steady_clock::time_point getLastChange() const;
+
 private:
+	friend class Snapshot; //Saves and restores the state for a hot upgrade.
+	/*
+	* Pushes the room state to the users of the room that subscribed to it.
+	* Nothing is serialized when none of them did.
+	*/
+	void notifyChanged();
+
 	RoomData mMetaData;
 	vector<LoggedUser> mUsers;
+	unsigned int mVersion;
+	std::chrono::steady_clock::time_point mLastChange;
 };
\ No newline at end of file
@@ -1,14 +1,29 @@
 #include "RoomAdminRequestHandler.h"
 #include "JsonResponsePacketSerializer.h"
+#include "PollAdvisor.h"
 
 RoomAdminRequestHandler::RoomAdminRequestHandler(Room* room, const LoggedUser& user)
 {
 	mRoom = room;
+	mRoomId = room->getRoomData().id;
 	mUser = user;
 	mRoomManager = RoomManager::getInstance();
 	mFactory = RequestHandlerFactory::getInstance();
 }
 
+unsigned int RoomAdminRequestHandler::getVersion(const RequestInfo& reqInfo)
+{
+	return reqInfo.code == GET_ROOM_STATE_REQUEST ? mRoomManager->getRoomVersion(mRoomId) : NO_VERSION;
+}
+
+unsigned int RoomAdminRequestHandler::getPollInterval(const RequestInfo& reqInfo)
+{
+	if (reqInfo.code != GET_ROOM_STATE_REQUEST) return NO_POLL_HINT;
+	//A deleted room is not polled again, the response moves the user to the menu.
+	if (mRoomManager->getRoomVersion(mRoomId) == NO_VERSION) return NO_POLL_HINT;
+	return PollAdvisor::getInstance()->forRoom(*mRoom);
+}
+
 bool RoomAdminRequestHandler::isRequestRelevant(const RequestInfo& reqInfo)
 {
 	switch (reqInfo.code)
@@ -22,7 +37,7 @@ bool RoomAdminRequestHandler::isRequestRelevant(const RequestInfo& reqInfo)
 	};
 }
 
-RequestResult RoomAdminRequestHandler::handleRequest(const RequestInfo& reqInfo)
+Task<RequestResult> RoomAdminRequestHandler::handleRequest(const RequestInfo& reqInfo)
 {
 	switch (reqInfo.code)
 	{
@@ -39,6 +54,15 @@ RequestResult RoomAdminRequestHandler::handleRequest(const RequestInfo& reqInfo)
 RequestResult RoomAdminRequestHandler::startGame(const RequestInfo request)
 {
 	RequestResult result;
+	if (mRoomManager->isDraining())
+	{
+		//A game started now could not finish before the server goes down.
+		ErrorResponse response;
+		response.message = "The server is shutting down!";
+		result.buffer = JsonResponsePacketSerializer::serializeResponse(response);
+		result.nextHandler = this;
+		return result;
+	}
 	mRoom->setState(RoomState::STARTED);
 	StartGameResponse response;
 	response.status = SUCCESS;
@@ -50,8 +74,7 @@ RequestResult RoomAdminRequestHandler::startGame(const RequestInfo request)
 RequestResult RoomAdminRequestHandler::closeRoom(const RequestInfo request)
 {
 	RequestResult result;
-	mRoomManager->deleteRoom(mRoom->getRoomData().id);
-	mRoom->getRoomData().state = RoomState::CLOSED;
+	mRoomManager->deleteRoom(mRoom->getRoomData().id); //Also marks the room CLOSED for its members.
 	CloseRoomResponse response;
 	response.status = SUCCESS;
 	result.buffer = JsonResponsePacketSerializer::serializeResponse(response);
@@ -64,11 +87,23 @@ RequestResult RoomAdminRequestHandler::getRoomState(const RequestInfo request)
 	RequestResult result;
 	GetRoomStateResponse response;
 	response.status = SUCCESS;
+	//mRoom dangles once the room is deleted, only its ID can tell.
+	if (mRoomManager->getRoomVersion(mRoomId) == NO_VERSION)
+	{
+		response.answerTimeout = 0;
+		response.questionCount = 0;
+		response.state = RoomState::CLOSED;
+		response.pollAfter = getPollInterval(request);
+		result.buffer = JsonResponsePacketSerializer::serializeResponse(response);
+		result.nextHandler = mFactory->createMenuRequestHandler(mUser);
+		return result;
+	}
 	RoomData roomData = mRoom->getRoomData();
 	response.answerTimeout = roomData.timePerQuestion;
 	response.questionCount = roomData.numOfQuestionsInGame;
 	response.state = roomData.state;
 	response.players = mRoom->getAllUsers();
+	response.pollAfter = getPollInterval(request);
 	result.buffer = JsonResponsePacketSerializer::serializeResponse(response);
 	result.nextHandler = this;
 	return result;
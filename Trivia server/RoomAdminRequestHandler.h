@@ -44,9 +44,26 @@ public:
      * @param reqInfo A reference to a RequestInfo object containing information about the request.
      * @return A RequestResult object containing the response data and potentially the next handler.
      */
-    virtual RequestResult handleRequest(const RequestInfo& reqInfo) override;
+    virtual Task<RequestResult> handleRequest(const RequestInfo& reqInfo) override;
+
+    /**
+    * Gets the version of the state a read request returns.
+    *
+    * @param reqInfo A reference to a RequestInfo object containing information about the request.
+    * @return The current version, or NO_VERSION if the request is not versioned.
+    */
+    virtual unsigned int getVersion(const RequestInfo& reqInfo) override;
+
+    /**
+    * Gets how long a client should wait before it polls a request again.
+    *
+    * @param reqInfo A reference to a RequestInfo object containing information about the request.
+    * @return The interval in milliseconds, or NO_POLL_HINT if the request is not polled.
+    */
+    virtual unsigned int getPollInterval(const RequestInfo& reqInfo) override;
 
 private:
+    friend class Snapshot; //Saves and restores the state for a hot upgrade.
     /****
      * @brief Handles the start game request.
      *
@@ -72,6 +89,7 @@ private:
     RequestResult getRoomState(const RequestInfo request);
 
     Room* mRoom;
+    unsigned int mRoomId; // Kept apart from mRoom, which dangles once the room is deleted.
     LoggedUser mUser;
     RoomManager* mRoomManager;
     RequestHandlerFactory* mFactory;
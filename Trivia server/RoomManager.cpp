@@ -1,5 +1,7 @@
 #include "RoomManager.h"
+#include "VersionCounter.h"
 #include "SqliteDataBase.h"
+#include "Packet.h"
 
 RoomManager* RoomManager::instancePtr = nullptr;
 
@@ -15,6 +17,9 @@ RoomManager* RoomManager::getInstance()
 RoomManager::RoomManager() 
 {
 	mId = SqliteDataBase::getInstance()->getNextId();
+	mVersion = VersionCounter::next();
+	mLastChange = std::chrono::steady_clock::now();
+	mDraining = false;
 }
 
 void RoomManager::createRoom(const LoggedUser& user, const RoomData& roomData)
@@ -22,11 +27,16 @@ void RoomManager::createRoom(const LoggedUser& user, const RoomData& roomData)
 	Room room(roomData);
 	room.addUser(user);
 	mRooms.insert({roomData.id, room});
+	markChanged();
 }
 
 void RoomManager::deleteRoom(const unsigned int id)
 {
-	mRooms.erase(id);
+	auto it = mRooms.find(id);
+	if (it == mRooms.end()) return;
+	it->second.setState(RoomState::CLOSED); //Tells the subscribed members before the room is gone.
+	mRooms.erase(it);
+	markChanged();
 }
 
 unsigned int RoomManager::getRoomState(const unsigned int id)
@@ -56,6 +66,38 @@ int RoomManager::getNextId()
 	return mId++;
 }
 
+unsigned int RoomManager::getVersion() const
+{
+	return mVersion;
+}
+
+unsigned int RoomManager::getRoomVersion(const unsigned int id) const
+{
+	auto it = mRooms.find(id);
+	return it == mRooms.end() ? NO_VERSION : it->second.getVersion();
+}
+
+void RoomManager::markChanged()
+{
+	mVersion = VersionCounter::next();
+	mLastChange = std::chrono::steady_clock::now();
+}
+
+std::chrono::steady_clock::time_point RoomManager::getLastChange() const
+{
+	return mLastChange;
+}
+
+void RoomManager::setDraining()
+{
+	mDraining = true;
+}
+
+bool RoomManager::isDraining() const
+{
+	return mDraining;
+}
+
 RoomManager::~RoomManager()
 {
 	delete instancePtr;
@@ -46,7 +46,9 @@ public:
     /****
      * @brief Deletes an existing room.
      *
-     * This method deletes a room with the specified ID.
+     * This method deletes a room with the specified ID. It publishes the room's CLOSED
+     * state and changes the room versions, so like every handler call it runs under the
+     * handlers' lock.
      *
      * @param id The ID of the room to be deleted.
      ****/
@@ -90,7 +92,45 @@ public:
      ****/
     int getNextId();
 
+    /****
+     * @brief Gets the version of the room list, it grows whenever a room is created, deleted or changes state.
+     *
+     * @returns The current version.
+     ****/
+    unsigned int getVersion() const;
+
+    /****
+     * @brief Gets the version of a room's state.
+     *
+     * @param id The ID of the room.
+     * @returns The room's version, or NO_VERSION if the room does not exist anymore.
+     ****/
+    unsigned int getRoomVersion(const unsigned int id) const;
+
+    /****
+     * @brief Marks the room list as changed, so conditional reads of it fetch it again.
+     ****/
+    void markChanged();
+
+    /****
+     * @brief Gets when the room list last changed, for the poll interval of GET_ROOMS.
+     *
+     * @returns The time of the last change.
+     ****/
+    std::chrono::steady_clock::time_point getLastChange() const;
+
+    /****
+     * @brief Marks the server as shutting down: no room is created or started from now on.
+     ****/
+    void setDraining();
+
+    /****
+     * @returns Whether the server is shutting down.
+     ****/
+    bool isDraining() const;
+
 private:
+    friend class Snapshot; //Saves and restores the state for a hot upgrade.
     map<unsigned int, Room> mRooms; ///< Map of rooms with their IDs as keys.
     static RoomManager* instancePtr; ///< Pointer to the singleton instance.
 
@@ -109,4 +149,7 @@ private:
     ~RoomManager();
 
     int mId; ///< Counter for the next available room ID.
+    unsigned int mVersion; ///< Version of the room list.
+    std::chrono::steady_clock::time_point mLastChange; ///< When the version last grew.
+    bool mDraining; ///< The server is shutting down.
 };
@@ -1,15 +1,30 @@
 #include "RoomMemberRequestHandler.h"
 #include "JsonResponsePacketSerializer.h"
+#include "PollAdvisor.h"
 #include "RequestHandlerFactory.h"
 
 RoomMemberRequestHandler::RoomMemberRequestHandler(Room* room, const LoggedUser& user)
 {
     mRoom = room;
+    mRoomId = room->getRoomData().id;
     mUser = user;
     mRoomManager = RoomManager::getInstance();
     mFactory = RequestHandlerFactory::getInstance();
 }
 
+unsigned int RoomMemberRequestHandler::getVersion(const RequestInfo& reqInfo)
+{
+	return reqInfo.code == GET_ROOM_STATE_REQUEST ? mRoomManager->getRoomVersion(mRoomId) : NO_VERSION;
+}
+
+unsigned int RoomMemberRequestHandler::getPollInterval(const RequestInfo& reqInfo)
+{
+	if (reqInfo.code != GET_ROOM_STATE_REQUEST) return NO_POLL_HINT;
+	//A deleted room is not polled again, the response moves the user to the menu.
+	if (mRoomManager->getRoomVersion(mRoomId) == NO_VERSION) return NO_POLL_HINT;
+	return PollAdvisor::getInstance()->forRoom(*mRoom);
+}
+
 bool RoomMemberRequestHandler::isRequestRelevant(const RequestInfo& reqInfo)
 {
 	switch (reqInfo.code)
@@ -22,7 +37,7 @@ bool RoomMemberRequestHandler::isRequestRelevant(const RequestInfo& reqInfo)
 	}
 }
 
-RequestResult RoomMemberRequestHandler::handleRequest(const RequestInfo& reqInfo)
+Task<RequestResult> RoomMemberRequestHandler::handleRequest(const RequestInfo& reqInfo)
 {
 	switch (reqInfo.code)
 	{
@@ -49,19 +64,29 @@ RequestResult RoomMemberRequestHandler::getRoomState(const RequestInfo request)
 	RequestResult result;
 	GetRoomStateResponse response;
 	response.status = SUCCESS;
-	RoomData roomData;
-	try {
-		roomData = mRoom->getRoomData();
-		response.players = mRoom->getAllUsers();
-	}
-	catch(std::exception e)
+	RoomData roomData = {};
+	//mRoom dangles once the room is deleted, only its ID can tell.
+	if (mRoomManager->getRoomVersion(mRoomId) == NO_VERSION)
 	{
+		roomData.id = mRoomId;
 		roomData.state = RoomState::CLOSED;
 	}
+	else
+	{
+		roomData = mRoom->getRoomData();
+		response.players = mRoom->getAllUsers();
+	}
 	response.answerTimeout = roomData.timePerQuestion;
 	response.questionCount = roomData.numOfQuestionsInGame;
 	response.state = roomData.state;
+	response.pollAfter = getPollInterval(request);
 	result.buffer = JsonResponsePacketSerializer::serializeResponse(response);
+	result.nextHandler = applyRoomState(roomData);
+	return result;
+}
+
+IRequestHandler* RoomMemberRequestHandler::applyRoomState(RoomData& roomData)
+{
 	IRequestHandler* next = nullptr;
 	Game* game = nullptr;
 	switch (roomData.state)
@@ -73,13 +98,24 @@ RequestResult RoomMemberRequestHandler::getRoomState(const RequestInfo request)
 		next = this;
 		break;
 	case RoomState::STARTED:
-		game = &(GameManager::getInstance()->createGame(mRoom->getRoomData()));
-		next = mFactory->createGameRequestHandler(game, mUser, mRoom->getRoomData().timePerQuestion);
+		game = &(GameManager::getInstance()->createGame(roomData));
+		next = mFactory->createGameRequestHandler(game, mUser, roomData.timePerQuestion);
 		break;
 	default:
 		next = nullptr;
 		break;
 	}
-	result.nextHandler = next;
-	return result;
+	return next;
+}
+
+IRequestHandler* RoomMemberRequestHandler::rejoin()
+{
+	//mRoom dangles once the room is deleted, only its ID can tell.
+	if (mRoomManager->getRoomVersion(mRoomId) == NO_VERSION) return mFactory->createMenuRequestHandler(mUser);
+	return this;
+}
+
+unsigned int RoomMemberRequestHandler::getRoomId() const
+{
+	return mRoomId;
 }
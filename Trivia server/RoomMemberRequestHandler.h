@@ -43,9 +43,47 @@ public:
      * @param reqInfo A reference to a RequestInfo object containing information about the request.
      * @return A RequestResult object containing the response data and potentially the next handler.
      */
-    virtual RequestResult handleRequest(const RequestInfo& reqInfo) override;
+    virtual Task<RequestResult> handleRequest(const RequestInfo& reqInfo) override;
+
+    /**
+    * Gets the version of the state a read request returns.
+    *
+    * @param reqInfo A reference to a RequestInfo object containing information about the request.
+    * @return The current version, or NO_VERSION if the request is not versioned.
+    */
+    virtual unsigned int getVersion(const RequestInfo& reqInfo) override;
+
+    /**
+    * Gets how long a client should wait before it polls a request again.
+    *
+    * @param reqInfo A reference to a RequestInfo object containing information about the request.
+    * @return The interval in milliseconds, or NO_POLL_HINT if the request is not polled.
+    */
+    virtual unsigned int getPollInterval(const RequestInfo& reqInfo) override;
+
+    /****
+     * @brief Gets the handler that fits a room state: the menu once the room closed,
+     * the game once it started, this handler while it is open.
+     *
+     * Used for polled and for pushed room states alike.
+     *
+     * @param roomData The current data of the room.
+     * @returns The next handler.
+     ****/
+    IRequestHandler* applyRoomState(RoomData& roomData);
+
+    /****
+     * @brief Gets the handler for a member whose session was parked and missed the
+     * pushed room states: the menu if the room is gone meanwhile, this handler otherwise.
+     *
+     * @returns The next handler.
+     ****/
+    IRequestHandler* rejoin();
+
+    unsigned int getRoomId() const; //getter
 
 private:
+    friend class Snapshot; //Saves and restores the state for a hot upgrade.
     /****
      * @brief Handles the get room state request.
      *
@@ -63,6 +101,7 @@ private:
     RequestResult leaveRoom(const RequestInfo request);
 
     Room* mRoom;
+    unsigned int mRoomId; // Kept apart from mRoom, which dangles once the room is deleted.
     LoggedUser mUser;
     RoomManager* mRoomManager;
     RequestHandlerFactory* mFactory;
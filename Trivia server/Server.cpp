@@ -1,38 +1,134 @@
 #include "Server.h"
+#include "Config.h"
+#include "LoopbackBenchmark.h"
 #include <iostream>
 #include <fstream>
+#include <algorithm>
+#include <chrono>
 using std::cout;
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "the shutdown flag is set from a signal handler");
 Server* Server::instancePtr = nullptr;
+std::atomic<int> Server::sShutdown(NO_SHUTDOWN);
 
 Server::Server()
 {
 	mDb = SqliteDataBase::getInstance();
+	mUpgradeChannel = INVALID_SOCKET;
 }
 
 void Server::run()
 {
-	int port = PORT;
-	std::ifstream configFile("config.txt");
-	if (configFile.good()) {
-		string content = "";
-		std::getline(configFile, content);
-		try {
-			port = atoi(content.c_str() + 7);
-			if (port == 0 || content.rfind("port = ") != 0) port = PORT;
-		}catch (std::exception& e) {}
+	//A benchmark drives the handlers in memory and never listens.
+	int flows = Config::getInstance()->getInt("loopback_benchmark", 0);
+	if (flows > 0)
+	{
+		//Its users and games must not show up in the real high scores.
+		if (!SqliteDataBase::getInstance()->openInMemoryCopy())
+		{
+			return;
+		}
+		LoopbackBenchmark(&mCommunicator).run((unsigned int)flows);
+		mDb->close();
+		return;
+	}
+	int port = Config::getInstance()->getInt("port", PORT);
+	unsigned int drainTimeout = (unsigned int)std::max(0, Config::getInstance()->getInt("drain_timeout", DEFAULT_DRAIN_TIMEOUT)) * 1000;
+	std::signal(SIGINT, &Server::onSignal);
+	std::signal(SIGTERM, &Server::onSignal);
+
+	//A process that is already running hands its clients over, the socket is ours after that.
+	SOCKET upgradeListener = INVALID_SOCKET;
+	string upgradeSocket = Config::getInstance()->getString("upgrade_socket", "");
+	if (!upgradeSocket.empty())
+	{
+		SOCKET channel = Socket::connectLocal(upgradeSocket);
+		if (channel != INVALID_SOCKET)
+		{
+			if (!mCommunicator.takeOver(channel)) cout << "Could not take over, starting afresh" << std::endl;
+			Socket::closeSocket(channel);
+		}
+		upgradeListener = Socket::createLocalListener(upgradeSocket);
+		if (upgradeListener != INVALID_SOCKET)
+		{
+			thread(&Server::waitForUpgrade, this, upgradeListener).detach();
+		}
 	}
+
 	//Init servewr on different thread.
-	thread(&Communicator::startHandleRequests, &mCommunicator, port).detach();
+	thread communicator(&Communicator::startHandleRequests, &mCommunicator, port);
+	//The console blocks, so it gets its own thread and a signal can still stop the server.
+	thread(&Server::readCommands, this).detach();
 
+	int shutdown;
+	while ((shutdown = sShutdown.load(std::memory_order_acquire)) == NO_SHUTDOWN)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_POLL_MS));
+		mCommunicator.expireSessions();
+	}
+	if (shutdown == UPGRADE_SHUTDOWN)
+	{
+		upgradeListener = INVALID_SOCKET; //Closed once the new process connected.
+		mCommunicator.beginHandOff();
+		communicator.join();
+		mCommunicator.handOff(mUpgradeChannel);
+		//Only closed, the socket file belongs to the new process now.
+		Socket::closeSocket(mUpgradeChannel);
+	}
+	else
+	{
+		mCommunicator.drain(shutdown == EXIT_SHUTDOWN ? 0 : drainTimeout);
+		communicator.join();
+	}
+	if (upgradeListener != INVALID_SOCKET) Socket::closeSocket(upgradeListener);
+	mDb->close();
+	cout << "Server stopped" << std::endl;
+}
+
+void Server::waitForUpgrade(SOCKET listener)
+{
+	SOCKET channel = Socket::acceptLocal(listener);
+	if (channel == INVALID_SOCKET) return;
+	//Stored first, setting the flag publishes it to run().
+	mUpgradeChannel.store(channel, std::memory_order_relaxed);
+	if (!requestShutdown(UPGRADE_SHUTDOWN))
+	{
+		//Already draining, the new process finds nothing to take over and starts afresh.
+		mUpgradeChannel.store(INVALID_SOCKET, std::memory_order_relaxed);
+		Socket::closeSocket(channel);
+		return;
+	}
+	//The new process finds the path refusing connections and listens on it in turn.
+	Socket::closeSocket(listener);
+}
+
+void Server::readCommands()
+{
 	string input = "";
-	//Run until user enters exit;
-	while (input != "EXIT")
+	while (std::getline(std::cin, input))
 	{
-		std::getline(std::cin, input);
+		if (input == "EXIT")
+		{
+			requestShutdown(EXIT_SHUTDOWN);
+			return;
+		}
+		if (input == "DRAIN")
+		{
+			requestShutdown(DRAIN_SHUTDOWN);
+			return;
+		}
 	}
+}
 
-	system("PAUSE");
+void Server::onSignal(int signal)
+{
+	std::signal(signal, SIG_DFL);
+	requestShutdown(DRAIN_SHUTDOWN);
+}
 
+bool Server::requestShutdown(int kind)
+{
+	int expected = NO_SHUTDOWN;
+	return sShutdown.compare_exchange_strong(expected, kind, std::memory_order_release, std::memory_order_relaxed);
 }
 
 Server* Server::getInstance()
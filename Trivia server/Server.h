@@ -2,7 +2,14 @@
 
 #include "Communicator.h"
 #include "SqliteDataBase.h"
+#include <csignal>
+#include <atomic>
 #define PORT 8175
+#define DEFAULT_DRAIN_TIMEOUT 120 // Seconds running games get to finish on DRAIN or SIGTERM.
+#define NO_SHUTDOWN 0
+#define DRAIN_SHUTDOWN 1 // Let the running games finish first.
+#define EXIT_SHUTDOWN 2 // End the running games right away, their scores are still saved.
+#define UPGRADE_SHUTDOWN 3 // A new process connected to the upgrade socket and takes the clients over.
 
 /*
 * A singelton class that describes a server.
@@ -11,7 +18,16 @@ class Server
 {
 public:
 	/*
-	* Runs the server socket and waits for user input for stop.
+	* Runs the server socket until it is shut down, then closes the database and returns.
+	* "DRAIN" on the console, SIGTERM or SIGINT shut down gracefully (see Communicator::drain,
+	* "drain_timeout" setting in seconds); "EXIT" does not wait for the running games.
+	* A second signal kills the process. A closed console keeps the server running.
+	* With the "upgrade_socket" setting (a path, Linux and other POSIX systems only) a new
+	* process started with the same setting takes the listeners, the clients, the rooms and
+	* the games over from the running one, which then exits (see Communicator::handOff).
+	* With the "loopback_benchmark" setting (a number of flows) it opens no socket: it runs
+	* that many clients through the handlers in memory, prints the latency of every request
+	* code and returns (see LoopbackBenchmark).
 	*/
 	void run();
 	Server(const Server& obj) = delete; //no copy ctor in singelton class
@@ -19,8 +35,29 @@ public:
 private:
 	Server();
 	~Server();
+	/*
+	* Reads shutdown commands from the console until one is entered or the input ends.
+	*/
+	void readCommands();
+	/*
+	* Requests a graceful shutdown, later signals get the default action.
+	*/
+	static void onSignal(int signal);
+	/*
+	* Waits for the next process to connect to the upgrade socket and starts the hand off.
+	*/
+	void waitForUpgrade(SOCKET listener);
+	/*
+	* Sets the kind of shutdown unless one was already requested, the first request wins.
+	* Safe in a signal handler.
+	*
+	* @return True if this request was the first.
+	*/
+	static bool requestShutdown(int kind);
+	static std::atomic<int> sShutdown; //Lock-free, so a signal handler may change it; publishes mUpgradeChannel.
 	static Server* instancePtr;
 	Communicator mCommunicator;
 	IDataBase* mDb;
+	std::atomic<SOCKET> mUpgradeChannel; //The new process, once it connected.
 };
 
@@ -0,0 +1,124 @@
+#include "SessionManager.h"
+#include "Config.h"
+#include <algorithm>
+#include <random>
+
+SessionManager* SessionManager::instancePtr = nullptr;
+
+SessionManager* SessionManager::getInstance()
+{
+	if (instancePtr == nullptr)
+	{
+		instancePtr = new SessionManager();
+	}
+	return instancePtr;
+}
+
+SessionManager::SessionManager()
+{
+	mGrace = std::chrono::seconds(std::max(0, Config::getInstance()->getInt("resume_grace", DEFAULT_RESUME_GRACE)));
+	mParked = 0;
+}
+
+void SessionManager::setCloser(std::function<void(IRequestHandler*)> closer)
+{
+	mCloser = closer;
+}
+
+string SessionManager::issue(const string& username)
+{
+	if (mGrace.count() == 0) return "";
+	revoke(username);
+	string token = createToken();
+	mSessions[username] = Session{ token, nullptr, std::chrono::steady_clock::time_point() };
+	mTokens[token] = username;
+	return token;
+}
+
+void SessionManager::revoke(const string& username)
+{
+	auto it = mSessions.find(username);
+	if (it == mSessions.end()) return;
+	if (it->second.handler != nullptr) mParked--;
+	mTokens.erase(it->second.token);
+	mSessions.erase(it);
+}
+
+bool SessionManager::park(const string& username, IRequestHandler* handler)
+{
+	auto it = mSessions.find(username);
+	if (it == mSessions.end() || it->second.handler != nullptr) return false;
+	it->second.handler = handler;
+	it->second.deadline = std::chrono::steady_clock::now() + mGrace;
+	mParked++;
+	return true;
+}
+
+IRequestHandler* SessionManager::resume(const string& token, string& username)
+{
+	username = "";
+	auto it = mTokens.find(token);
+	if (it == mTokens.end()) return nullptr;
+	username = it->second;
+	Session& session = mSessions[username];
+	IRequestHandler* handler = session.handler;
+	if (handler == nullptr) return nullptr;
+	//Spent: a copy of the token that leaked cannot take the session again.
+	mTokens.erase(it);
+	mSessions.erase(username);
+	mParked--;
+	return handler;
+}
+
+bool SessionManager::discard(const string& username)
+{
+	auto it = mSessions.find(username);
+	if (it == mSessions.end() || it->second.handler == nullptr) return false;
+	IRequestHandler* handler = it->second.handler;
+	revoke(username);
+	mCloser(handler);
+	return true;
+}
+
+void SessionManager::expire(const bool all)
+{
+	if (mParked == 0) return;
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	std::vector<IRequestHandler*> expired;
+	for (auto it = mSessions.begin(); it != mSessions.end();)
+	{
+		if (it->second.handler != nullptr && (all || it->second.deadline <= now))
+		{
+			expired.push_back(it->second.handler);
+			mTokens.erase(it->second.token);
+			it = mSessions.erase(it);
+			mParked--;
+		}
+		else
+		{
+			++it;
+		}
+	}
+	//Closing a handler may publish room states, the table is consistent by then.
+	for (IRequestHandler* handler : expired)
+	{
+		mCloser(handler);
+	}
+}
+
+string SessionManager::createToken()
+{
+	static const char HEX[] = "0123456789abcdef";
+	static std::random_device random;
+	string token;
+	//Each draw gives 32 random bits, 8 hex digits.
+	for (int i = 0; i < RESUME_TOKEN_BYTES / 4; i++)
+	{
+		unsigned int bits = random();
+		for (int shift = 28; shift >= 0; shift -= 4)
+		{
+			token += HEX[(bits >> shift) & 0xf];
+		}
+	}
+	return token;
+}
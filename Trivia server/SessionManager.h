@@ -0,0 +1,122 @@
+#pragma once
+
+#include "IRequestHandler.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+
+using std::map;
+using std::string;
+
+#define DEFAULT_RESUME_GRACE 30 // Seconds a dropped session waits for its user to come back.
+#define RESUME_TOKEN_BYTES 16
+
+/****
+ * @brief Keeps the sessions of dropped connections for a grace period, so their users
+ * can come back with a resume token instead of logging in again.
+ *
+ * Every login hands out an opaque token. When the connection of a logged in user
+ * drops, its handler is parked here instead of being logged out: the user stays in
+ * its room or game. A new connection that presents the token takes the handler back
+ * without touching the database, and gets a new token. Once the grace period ("resume_grace"
+ * setting, in seconds, 0 turns resuming off) ends, the session is closed like a dropped
+ * connection used to be. Guarded by the Communicator's handlers lock, like the other managers.
+ ****/
+class SessionManager
+{
+public:
+    /****
+     * @brief Deleted copy constructor to enforce singleton pattern.
+     ****/
+    SessionManager(const SessionManager& obj) = delete;
+
+    /****
+     * @brief Gets the singleton instance of SessionManager.
+     *
+     * @returns A pointer to the singleton instance of SessionManager.
+     ****/
+    static SessionManager* getInstance();
+
+    /****
+     * @brief Sets what logs the user of a parked handler out and frees it, once its session ends.
+     ****/
+    void setCloser(std::function<void(IRequestHandler*)> closer);
+
+    /****
+     * @brief Gives a user that logged in a new token, the previous one is no longer valid.
+     *
+     * @param username The user.
+     * @returns The token, empty if resuming is off.
+     ****/
+    string issue(const string& username);
+
+    /****
+     * @brief Forgets the token of a user that logged out or was closed for good.
+     *
+     * @param username The user.
+     ****/
+    void revoke(const string& username);
+
+    /****
+     * @brief Keeps the handler of a user whose connection dropped until the grace period ends.
+     *
+     * @param username The user.
+     * @param handler The handler of the dropped connection.
+     * @returns False if the user has no token, the caller then closes the handler.
+     ****/
+    bool park(const string& username, IRequestHandler* handler);
+
+    /****
+     * @brief Takes a parked session back. The token is spent, issue() gives the user a new one.
+     *
+     * @param token The token the client presented.
+     * @param username Set to the user of the token, empty if the token is not valid.
+     * @returns The parked handler, nullptr if the token is not valid or its session is not parked
+     * (its connection is still open).
+     ****/
+    IRequestHandler* resume(const string& token, string& username);
+
+    /****
+     * @brief Closes a parked session right away, for a user that logged in with its password instead.
+     *
+     * @param username The user.
+     * @returns True if the user had a parked session.
+     ****/
+    bool discard(const string& username);
+
+    /****
+     * @brief Closes the parked sessions whose grace period ended.
+     *
+     * @param all Close every parked session, on shutdown and upgrade.
+     ****/
+    void expire(const bool all = false);
+
+private:
+    /****
+     * @brief Private constructor to enforce singleton pattern.
+     ****/
+    SessionManager();
+
+    /****
+     * @returns A new random token, as hex.
+     ****/
+    static string createToken();
+
+    friend class Snapshot; //Saves and restores the tokens of the connected users for a hot upgrade.
+
+    struct Session
+    {
+        string token;
+        IRequestHandler* handler; //nullptr while the user is connected.
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    map<string, Session> mSessions; //By username.
+    map<string, string> mTokens; //Username by token.
+    unsigned int mParked; //Sessions with a handler, expire() skips the scan without any.
+    std::chrono::milliseconds mGrace;
+    std::function<void(IRequestHandler*)> mCloser;
+    static SessionManager* instancePtr;
+};
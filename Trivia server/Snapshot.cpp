@@ -0,0 +1,297 @@
+#include "Snapshot.h"
+#include "RequestHandlerFactory.h"
+#include "NotificationCenter.h"
+#include "Communicator.h"
+#include "VersionCounter.h"
+#include <stdexcept>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <map>
+
+using nlohmann::json;
+
+string Snapshot::save(const vector<shared_ptr<Connection>>& connections)
+{
+	json snapshot;
+	snapshot["format"] = SNAPSHOT_FORMAT;
+	snapshot["version"] = VersionCounter::current();
+
+	json logins = json::array();
+	for (const LoggedUser& user : LoginManager::getInstance()->mLoggedUsers)
+	{
+		logins.push_back(user.getUsername());
+	}
+	snapshot["logins"] = logins;
+
+	RoomManager* roomManager = RoomManager::getInstance();
+	json rooms = json::array();
+	for (auto& it : roomManager->mRooms)
+	{
+		const RoomData& data = it.second.mMetaData;
+		rooms.push_back({
+			{"id", data.id}, {"name", data.name}, {"maxPlayers", data.maxPlayers},
+			{"questionCount", data.numOfQuestionsInGame}, {"answerTimeout", data.timePerQuestion},
+			{"state", data.state}, {"users", it.second.getAllUsers()}, {"version", it.second.mVersion} });
+	}
+	snapshot["rooms"] = { {"nextId", roomManager->mId}, {"version", roomManager->mVersion}, {"list", rooms} };
+
+	json games = json::array();
+	for (const Game& game : GameManager::getInstance()->mGames)
+	{
+		json questions = json::array();
+		for (const Question& question : game.mQuestions)
+		{
+			questions.push_back({ {"question", question.getQuestion()}, {"answers", question.getPossibleAnswers()},
+				{"correct", question.getCorrectAnswerId()} });
+		}
+		json players = json::array();
+		for (auto& it : game.mPlayers)
+		{
+			players.push_back({ {"username", it.first.getUsername()}, {"current", it.second.currentQuestion},
+				{"correct", it.second.correctAnswerCount}, {"wrong", it.second.wrongAnswerCount},
+				{"averageTime", it.second.averangeAnswerTime}, {"retired", it.second.HasRetired} });
+		}
+		games.push_back({ {"id", game.mGameId}, {"questions", questions}, {"players", players}, {"round", game.mRound},
+			{"synced", game.mSynced}, {"over", game.mOver}, {"version", game.mVersion} });
+	}
+	snapshot["games"] = games;
+
+	// Parked sessions were closed before, every token left belongs to a connection that is handed over.
+	SessionManager* sessions = SessionManager::getInstance();
+	json states = json::array();
+	for (const shared_ptr<Connection>& connection : connections)
+	{
+		auto session = sessions->mSessions.find(connection->getUsername());
+		RingBuffer& inbound = connection->getInbound();
+		string unparsed;
+		inbound.peek(0, unparsed, inbound.size());
+		string unsent = connection->getOutbound().copyBytes();
+		states.push_back({
+			{"username", connection->getUsername()},
+			{"token", session == sessions->mSessions.end() ? string() : session->second.token},
+			{"topics", NotificationCenter::getInstance()->getTopics(connection->getUsername())},
+			{"heartbeat", connection->usesHeartbeat()},
+			{"handler", saveHandler(connection->getHandler())},
+			{"inbound", json::binary(vector<uint8_t>(unparsed.begin(), unparsed.end()))},
+			{"outbound", json::binary(vector<uint8_t>(unsent.begin(), unsent.end()))} });
+	}
+	snapshot["connections"] = states;
+
+	vector<uint8_t> encoded = json::to_msgpack(snapshot);
+	return string(encoded.begin(), encoded.end());
+}
+
+vector<json> Snapshot::restore(const string& data, const size_t sockets)
+{
+	json snapshot;
+	try
+	{
+		snapshot = json::from_msgpack(data);
+		if (snapshot.at("format").get<int>() != SNAPSHOT_FORMAT)
+		{
+			throw std::runtime_error("snapshot of another format");
+		}
+		// Parsed in full first: a damaged snapshot leaves the managers as they were, for a fresh start.
+		vector<LoggedUser> logins;
+		for (const json& username : snapshot.at("logins"))
+		{
+			logins.push_back(LoggedUser(username.get<string>()));
+		}
+
+		const json& rooms = snapshot.at("rooms");
+		std::map<unsigned int, Room> roomList;
+		for (const json& saved : rooms.at("list"))
+		{
+			RoomData data = { saved.at("id"), saved.at("name"), saved.at("maxPlayers"), saved.at("questionCount"),
+				saved.at("answerTimeout"), saved.at("state") };
+			Room room(data);
+			for (const json& username : saved.at("users"))
+			{
+				room.mUsers.push_back(LoggedUser(username.get<string>()));
+			}
+			room.mVersion = saved.at("version");
+			roomList.insert({ data.id, room });
+		}
+		int nextId = rooms.at("nextId");
+		unsigned int roomListVersion = rooms.at("version");
+
+		std::list<Game> games;
+		for (const json& saved : snapshot.at("games"))
+		{
+			vector<Question> questions;
+			for (const json& question : saved.at("questions"))
+			{
+				questions.push_back(Question(question.at("question"), question.at("answers").get<vector<string>>(), question.at("correct")));
+			}
+			Game game(questions, saved.at("id"));
+			for (const json& player : saved.at("players"))
+			{
+				GameData data = { player.at("current"), player.at("correct"), player.at("wrong"), player.at("averageTime"), player.at("retired") };
+				game.mPlayers[LoggedUser(player.at("username").get<string>())] = data;
+			}
+			game.mRound = saved.at("round");
+			game.mSynced = saved.at("synced");
+			game.mOver = saved.at("over");
+			game.mVersion = saved.at("version");
+			games.push_back(game);
+		}
+		unsigned int version = snapshot.at("version");
+		vector<json> connections = snapshot.at("connections").get<vector<json>>();
+		if (connections.size() > sockets)
+		{
+			throw std::runtime_error("snapshot of more connections than sockets");
+		}
+
+		// The saved versions were handed out by the old process, new ones go on after them.
+		VersionCounter::restore(version);
+		StatisticsManager::getInstance()->markChanged();
+		LoginManager* loginManager = LoginManager::getInstance();
+		loginManager->mLoggedUsers.insert(loginManager->mLoggedUsers.end(), logins.begin(), logins.end());
+		RoomManager* roomManager = RoomManager::getInstance();
+		roomManager->mRooms.insert(roomList.begin(), roomList.end());
+		roomManager->mId = std::max(roomManager->mId, nextId);
+		roomManager->mVersion = roomListVersion;
+		// Handlers point into the game list, so it is complete before any of them is rebuilt.
+		GameManager::getInstance()->mGames.splice(GameManager::getInstance()->mGames.end(), games);
+		return connections;
+	}
+	catch (const json::exception& e)
+	{
+		throw std::runtime_error(string("damaged snapshot: ") + e.what());
+	}
+}
+
+bool Snapshot::send(SOCKET channel, const string& snapshot, const vector<SOCKET>& sockets)
+{
+	unsigned char header[SNAPSHOT_HEADER_SIZE];
+	unsigned int fields[] = { (unsigned int)snapshot.size(), (unsigned int)sockets.size() };
+	for (int i = 0; i < SNAPSHOT_HEADER_SIZE; i++)
+	{
+		header[i] = (unsigned char)(fields[i / 4] >> (8 * (i % 4)));
+	}
+	char ack = 0;
+	return Socket::sendAll(channel, (const char*)header, SNAPSHOT_HEADER_SIZE) &&
+		Socket::sendAll(channel, snapshot.data(), snapshot.size()) &&
+		Socket::sendSockets(channel, sockets) &&
+		Socket::receiveAll(channel, &ack, 1) && ack == SNAPSHOT_ACK;
+}
+
+bool Snapshot::receive(SOCKET channel, string& snapshot, vector<SOCKET>& sockets)
+{
+	unsigned char header[SNAPSHOT_HEADER_SIZE];
+	if (!Socket::receiveAll(channel, (char*)header, SNAPSHOT_HEADER_SIZE)) return false;
+	unsigned int fields[2] = { 0, 0 };
+	for (int i = 0; i < SNAPSHOT_HEADER_SIZE; i++)
+	{
+		fields[i / 4] |= (unsigned int)header[i] << (8 * (i % 4));
+	}
+	if (fields[0] > MAX_SNAPSHOT_SIZE) return false;
+	snapshot.resize(fields[0]);
+	return Socket::receiveAll(channel, &snapshot[0], snapshot.size()) && Socket::receiveSockets(channel, fields[1], sockets);
+}
+
+void Snapshot::acknowledge(SOCKET channel)
+{
+	char ack = SNAPSHOT_ACK;
+	Socket::sendAll(channel, &ack, 1);
+}
+
+void Snapshot::restoreConnection(Connection& connection, const json& state)
+{
+	string username = state.at("username");
+	connection.setUsername(username);
+	connection.setHandler(restoreHandler(state.at("handler"), username));
+	connection.setUsesHeartbeat(state.at("heartbeat"));
+
+	if (username != NO_USER)
+	{
+		NotificationCenter* center = NotificationCenter::getInstance();
+		center->registerUser(username, connection.shared_from_this());
+		unsigned int topics = state.at("topics");
+		if (topics & ROOM_STATE_TOPIC) center->subscribe(username, ROOM_STATE_TOPIC);
+		if (topics & GAME_TOPIC) center->subscribe(username, GAME_TOPIC);
+
+		// The token the client holds stays valid, it resumes with it after its next drop.
+		string token = state.at("token");
+		SessionManager* sessions = SessionManager::getInstance();
+		if (!token.empty() && sessions->mGrace.count() != 0)
+		{
+			sessions->mSessions[username] = SessionManager::Session{ token, nullptr, std::chrono::steady_clock::time_point() };
+			sessions->mTokens[token] = username;
+		}
+	}
+
+	const json::binary_t& inbound = state.at("inbound").get_binary();
+	connection.getInbound().write((const char*)inbound.data(), inbound.size());
+	const json::binary_t& outbound = state.at("outbound").get_binary();
+	connection.getOutbound().pushBytes(string(outbound.begin(), outbound.end()));
+}
+
+json Snapshot::saveHandler(IRequestHandler* handler)
+{
+	if (dynamic_cast<MenuRequestHandler*>(handler) != nullptr)
+	{
+		return { {"type", "menu"} };
+	}
+	if (dynamic_cast<RoomAdminRequestHandler*>(handler) != nullptr)
+	{
+		return { {"type", "admin"}, {"roomId", ((RoomAdminRequestHandler*)handler)->mRoomId} };
+	}
+	if (dynamic_cast<RoomMemberRequestHandler*>(handler) != nullptr)
+	{
+		return { {"type", "member"}, {"roomId", ((RoomMemberRequestHandler*)handler)->mRoomId} };
+	}
+	if (dynamic_cast<GameRequestHandler*>(handler) != nullptr)
+	{
+		GameRequestHandler* game = (GameRequestHandler*)handler;
+		long long waited = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - game->mLastTime).count();
+		return { {"type", "game"}, {"gameId", game->getGameId()}, {"answerTimeout", game->mAnswerTimeout},
+			{"answered", game->mAnswered}, {"lastRequest", game->mLastRequest}, {"waited", waited} };
+	}
+	return { {"type", "login"} };
+}
+
+IRequestHandler* Snapshot::restoreHandler(const json& state, const string& username)
+{
+	RequestHandlerFactory* factory = RequestHandlerFactory::getInstance();
+	string type = state.at("type");
+	LoggedUser user(username);
+	if (type == "admin" || type == "member")
+	{
+		RoomManager* roomManager = factory->getRoomManager();
+		unsigned int roomId = state.at("roomId");
+		if (roomManager->mRooms.count(roomId))
+		{
+			Room* room = &roomManager->getRoom(roomId);
+			if (type == "admin") return factory->createRoomAdminRequestHandler(user, room);
+			return factory->createRoomMemberRequestHandler(user, room);
+		}
+	}
+	else if (type == "game")
+	{
+		unsigned int gameId = state.at("gameId");
+		for (Game& game : factory->getGameManager()->mGames)
+		{
+			if (game.getGameId() != gameId) continue;
+			// Not through the constructor, which would add the player again and lose its progress.
+			GameRequestHandler* handler = new GameRequestHandler();
+			handler->mGame = &game;
+			game.retain();
+			handler->mUser = user;
+			handler->mGameManager = factory->getGameManager();
+			handler->mFacroty = factory;
+			handler->mLastTime = std::chrono::steady_clock::now() - std::chrono::milliseconds(state.at("waited").get<long long>());
+			handler->mAnswered = state.at("answered");
+			handler->mLastRequest = state.at("lastRequest");
+			handler->mAnswerTimeout = state.at("answerTimeout");
+			return handler;
+		}
+	}
+	if (type == "login" || username == NO_USER)
+	{
+		return factory->createLoginRequestHandler();
+	}
+	//The room or the game is gone, the menu is the state the player would be in by now.
+	return factory->createMenuRequestHandler(user);
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Connection.h"
+#include "json.hpp"
+#include <memory>
+#include <vector>
+
+using std::vector;
+using std::shared_ptr;
+
+#define SNAPSHOT_FORMAT 3 // Grows whenever the layout changes, a process refuses a snapshot of another format.
+#define SNAPSHOT_HEADER_SIZE 8 // Four bytes little endian snapshot length, four bytes socket count.
+#define MAX_SNAPSHOT_SIZE (1 << 30)
+#define SNAPSHOT_ACK 'K' // The new process took over, the old one may exit.
+
+/****
+ * @brief The state a hot upgrade carries from the old process to the new one.
+ *
+ * Holds the version counter, the logged in users, the rooms, the games and, per connection, the
+ * user, the resume token, the handler state, the subscriptions and the bytes that were read but
+ * not parsed or queued but not written. It is encoded in MessagePack, the
+ * sockets themselves travel next to it (see Socket::sendSockets).
+ ****/
+class Snapshot
+{
+public:
+    /****
+     * @brief Captures the managers and the given connections. The loops of the connections must be stopped.
+     *
+     * @param connections The connections, in the order their sockets are passed.
+     * @returns The encoded snapshot.
+     ****/
+    static string save(const vector<shared_ptr<Connection>>& connections);
+
+    /****
+     * @brief Restores the logged in users, the rooms and the games. Call it before any client is served.
+     * The managers are only changed once the whole snapshot parsed.
+     *
+     * @param data A snapshot made by save().
+     * @param sockets How many sockets came with it.
+     * @returns The state of every connection, in the order of save(), for restoreConnection().
+     * @throws std::runtime_error If the snapshot is of another format, damaged or describes more
+     * connections than there are sockets. The managers are left untouched then.
+     ****/
+    static vector<nlohmann::json> restore(const string& data, const size_t sockets);
+
+    /****
+     * @brief Puts a handed over connection back where it was: user, resume token, handler, subscriptions and buffers.
+     * Runs on the connection's loop, in place of the login state a new client gets.
+     *
+     * @param connection The reopened connection.
+     * @param state Its state from restore().
+     ****/
+    static void restoreConnection(Connection& connection, const nlohmann::json& state);
+
+    /****
+     * @brief Sends a snapshot and the sockets it describes to the new process and waits until it took over.
+     *
+     * @param channel The connection of the new process.
+     * @param snapshot The encoded snapshot.
+     * @param sockets The sockets of the connections, in the order of the snapshot, then the listeners.
+     * @returns True once the new process acknowledged, false if it failed or went away.
+     ****/
+    static bool send(SOCKET channel, const string& snapshot, const vector<SOCKET>& sockets);
+
+    /****
+     * @brief Receives what send() sends. Call acknowledge() once the state is restored.
+     *
+     * @returns False if the old process failed or went away.
+     ****/
+    static bool receive(SOCKET channel, string& snapshot, vector<SOCKET>& sockets);
+
+    /****
+     * @brief Tells the old process that the new one took over.
+     ****/
+    static void acknowledge(SOCKET channel);
+
+private:
+    /****
+     * @brief Describes the handler of a connection: its type and what it points at.
+     ****/
+    static nlohmann::json saveHandler(IRequestHandler* handler);
+
+    /****
+     * @brief Rebuilds a handler from saveHandler().
+     *
+     * @returns The handler, or a login handler if its room or game is gone.
+     ****/
+    static IRequestHandler* restoreHandler(const nlohmann::json& state, const string& username);
+};
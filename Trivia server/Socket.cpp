@@ -0,0 +1,414 @@
+#include "Socket.h"
+#include <stdexcept>
+#include <algorithm>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+
+SOCKET Socket::createListener(const int port, const bool reusePort, const string& address)
+{
+	struct sockaddr_in sa = {};
+	sa.sin_port = htons(port); // port that server will listen for
+	sa.sin_family = AF_INET;   // must be AF_INET
+	sa.sin_addr.s_addr = INADDR_ANY;    // when there are few ip's for the machine. We will use always "INADDR_ANY"
+	if (!address.empty() && inet_pton(AF_INET, address.c_str(), &sa.sin_addr) != 1)
+		throw std::runtime_error("createListener - address " + address);
+
+	// this server use TCP. that why SOCK_STREAM & IPPROTO_TCP
+	SOCKET listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (listener == INVALID_SOCKET)
+		throw std::runtime_error("createListener - socket");
+
+	int reuse = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+#ifdef SO_REUSEPORT
+	if (reusePort && setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, (const char*)&reuse, sizeof(reuse)) == SOCKET_ERROR)
+	{
+		closeSocket(listener);
+		throw std::runtime_error("createListener - SO_REUSEPORT");
+	}
+#endif
+
+	// Connects between the socket and the configuration (port and etc..)
+	if (bind(listener, (struct sockaddr*)&sa, sizeof(sa)) == SOCKET_ERROR)
+	{
+		closeSocket(listener);
+		throw std::runtime_error("createListener - bind");
+	}
+
+	// Start listening for incoming requests of clients
+	if (listen(listener, SOMAXCONN) == SOCKET_ERROR)
+	{
+		closeSocket(listener);
+		throw std::runtime_error("createListener - listen");
+	}
+	setNonBlocking(listener);
+	return listener;
+}
+
+bool Socket::supportsReusePort()
+{
+	// BSDs accept the option but hand every connection to the last listener, only Linux balances.
+#if defined(SO_REUSEPORT) && defined(__linux__)
+	return true;
+#else
+	return false;
+#endif
+}
+
+SOCKET Socket::acceptClient(SOCKET listener)
+{
+	SOCKET client = accept(listener, NULL, NULL);
+	if (client == INVALID_SOCKET)
+		return INVALID_SOCKET;
+	setNonBlocking(client);
+	setNoDelay(client);
+	return client;
+}
+
+void Socket::closeSocket(SOCKET socket)
+{
+#ifdef _WIN32
+	closesocket(socket);
+#else
+	close(socket);
+#endif
+}
+
+bool Socket::setNonBlocking(SOCKET socket)
+{
+#ifdef _WIN32
+	u_long mode = 1;
+	return ioctlsocket(socket, FIONBIO, &mode) == 0;
+#else
+	int flags = fcntl(socket, F_GETFL, 0);
+	return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+void Socket::setNoDelay(SOCKET socket)
+{
+	int noDelay = 1;
+	setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+}
+
+string Socket::getPeerAddress(SOCKET socket)
+{
+	sockaddr_storage address = {};
+	socklen_t size = sizeof(address);
+	if (getpeername(socket, (sockaddr*)&address, &size) == SOCKET_ERROR) return string();
+	char text[INET6_ADDRSTRLEN] = { 0 };
+	if (address.ss_family == AF_INET)
+	{
+		inet_ntop(AF_INET, &((sockaddr_in*)&address)->sin_addr, text, sizeof(text));
+	}
+	else if (address.ss_family == AF_INET6)
+	{
+		inet_ntop(AF_INET6, &((sockaddr_in6*)&address)->sin6_addr, text, sizeof(text));
+	}
+	return string(text);
+}
+
+int Socket::getLocalPort(SOCKET socket)
+{
+	sockaddr_storage address = {};
+	socklen_t size = sizeof(address);
+	if (getsockname(socket, (sockaddr*)&address, &size) == SOCKET_ERROR) return 0;
+	if (address.ss_family == AF_INET) return ntohs(((sockaddr_in*)&address)->sin_port);
+	if (address.ss_family == AF_INET6) return ntohs(((sockaddr_in6*)&address)->sin6_port);
+	return 0;
+}
+
+int Socket::receive(SOCKET socket, char* data, const int len)
+{
+	return recv(socket, data, len, 0);
+}
+
+int Socket::sendSome(SOCKET socket, const char* data, const int len)
+{
+#ifdef MSG_NOSIGNAL
+	return send(socket, data, len, MSG_NOSIGNAL);
+#else
+	return send(socket, data, len, 0);
+#endif
+}
+
+int Socket::sendSegments(SOCKET socket, const Segment* segments, const int count)
+{
+#ifdef _WIN32
+	WSABUF buffers[SEND_SEGMENTS];
+	for (int i = 0; i < count; i++)
+	{
+		buffers[i].buf = (CHAR*)segments[i].data;
+		buffers[i].len = (ULONG)segments[i].len;
+	}
+	DWORD sent = 0;
+	if (WSASend(socket, buffers, count, &sent, 0, NULL, NULL) == SOCKET_ERROR)
+		return SOCKET_ERROR;
+	return (int)sent;
+#else
+	iovec buffers[SEND_SEGMENTS];
+	for (int i = 0; i < count; i++)
+	{
+		buffers[i].iov_base = (void*)segments[i].data;
+		buffers[i].iov_len = segments[i].len;
+	}
+	msghdr message = {};
+	message.msg_iov = buffers;
+	message.msg_iovlen = count;
+#ifdef MSG_NOSIGNAL
+	return (int)sendmsg(socket, &message, MSG_NOSIGNAL);
+#else
+	return (int)sendmsg(socket, &message, 0);
+#endif
+#endif
+}
+
+bool Socket::wouldBlock()
+{
+#ifdef _WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+}
+
+void Socket::createWakeupPair(SOCKET& readEnd, SOCKET& writeEnd)
+{
+#ifdef _WIN32
+	// No socketpair on Windows: a loopback UDP socket connected to itself does the job.
+	SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (s == INVALID_SOCKET)
+		throw std::runtime_error("createWakeupPair - socket");
+	struct sockaddr_in sa = {};
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	int len = sizeof(sa);
+	if (bind(s, (struct sockaddr*)&sa, sizeof(sa)) == SOCKET_ERROR ||
+		getsockname(s, (struct sockaddr*)&sa, &len) == SOCKET_ERROR ||
+		connect(s, (struct sockaddr*)&sa, sizeof(sa)) == SOCKET_ERROR)
+	{
+		closeSocket(s);
+		throw std::runtime_error("createWakeupPair - bind");
+	}
+	setNonBlocking(s);
+	readEnd = s;
+	writeEnd = s;
+#else
+	int fds[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+		throw std::runtime_error("createWakeupPair - socketpair");
+	setNonBlocking(fds[0]);
+	setNonBlocking(fds[1]);
+	readEnd = fds[0];
+	writeEnd = fds[1];
+#endif
+}
+
+SOCKET Socket::createLocalListener(const string& path, const bool forClients)
+{
+#ifdef _WIN32
+	return INVALID_SOCKET;
+#else
+	sockaddr_un address = {};
+	if (path.size() >= sizeof(address.sun_path)) return INVALID_SOCKET;
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.c_str(), path.size());
+	SOCKET listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (listener == INVALID_SOCKET) return INVALID_SOCKET;
+	// Only a socket file that refuses connections is left over, a live one or any other file stays.
+	struct stat status;
+	if (lstat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+	{
+		SOCKET probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0); //A full backlog fails instead of blocking.
+		if (probe != INVALID_SOCKET)
+		{
+			bool stale = connect(probe, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR && lastError() == ECONNREFUSED;
+			closeSocket(probe);
+			if (stale) unlink(path.c_str());
+		}
+	}
+	if (bind(listener, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR ||
+		::listen(listener, forClients ? SOMAXCONN : 1) == SOCKET_ERROR ||
+		(forClients && !setNonBlocking(listener)))
+	{
+		closeSocket(listener);
+		return INVALID_SOCKET;
+	}
+	return listener;
+#endif
+}
+
+bool Socket::isLocal(SOCKET socket)
+{
+#ifdef _WIN32
+	return false;
+#else
+	sockaddr_storage address = {};
+	socklen_t size = sizeof(address);
+	return getsockname(socket, (sockaddr*)&address, &size) != SOCKET_ERROR && address.ss_family == AF_UNIX;
+#endif
+}
+
+SOCKET Socket::acceptLocal(SOCKET listener)
+{
+	SOCKET channel;
+	do
+	{
+		channel = accept(listener, NULL, NULL);
+	} while (channel == INVALID_SOCKET && lastError() == EINTR);
+	return channel;
+}
+
+SOCKET Socket::connectLocal(const string& path)
+{
+#ifdef _WIN32
+	return INVALID_SOCKET;
+#else
+	sockaddr_un address = {};
+	if (path.size() >= sizeof(address.sun_path)) return INVALID_SOCKET;
+	address.sun_family = AF_UNIX;
+	std::memcpy(address.sun_path, path.c_str(), path.size());
+	SOCKET channel = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (channel == INVALID_SOCKET) return INVALID_SOCKET;
+	if (connect(channel, (sockaddr*)&address, sizeof(address)) == SOCKET_ERROR)
+	{
+		closeSocket(channel);
+		return INVALID_SOCKET;
+	}
+	return channel;
+#endif
+}
+
+SOCKET Socket::connectTo(const string& host, const int port)
+{
+	addrinfo hints = {};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_protocol = IPPROTO_TCP;
+	addrinfo* addresses = nullptr;
+	if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0) return INVALID_SOCKET;
+	SOCKET connected = INVALID_SOCKET;
+	for (addrinfo* address = addresses; address != nullptr && connected == INVALID_SOCKET; address = address->ai_next)
+	{
+		SOCKET candidate = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (candidate == INVALID_SOCKET) continue;
+		if (connect(candidate, address->ai_addr, (int)address->ai_addrlen) == SOCKET_ERROR)
+		{
+			closeSocket(candidate);
+			continue;
+		}
+		connected = candidate;
+	}
+	freeaddrinfo(addresses);
+	if (connected == INVALID_SOCKET) return INVALID_SOCKET;
+	setNonBlocking(connected);
+	setNoDelay(connected);
+	return connected;
+}
+
+bool Socket::sendAll(SOCKET socket, const char* data, const size_t len)
+{
+	size_t sent = 0;
+	while (sent < len)
+	{
+		int res = sendSome(socket, data + sent, (int)std::min(len - sent, (size_t)INT_MAX));
+		if (res == SOCKET_ERROR && lastError() == EINTR) continue;
+		if (res <= 0) return false;
+		sent += res;
+	}
+	return true;
+}
+
+bool Socket::receiveAll(SOCKET socket, char* data, const size_t len)
+{
+	size_t received = 0;
+	while (received < len)
+	{
+		int res = receive(socket, data + received, (int)std::min(len - received, (size_t)INT_MAX));
+		if (res == SOCKET_ERROR && lastError() == EINTR) continue;
+		if (res <= 0) return false;
+		received += res;
+	}
+	return true;
+}
+
+bool Socket::sendSockets(SOCKET channel, const vector<SOCKET>& sockets)
+{
+#ifdef _WIN32
+	return sockets.empty();
+#else
+	for (size_t first = 0; first < sockets.size(); first += PASSED_SOCKETS_PER_MESSAGE)
+	{
+		size_t count = std::min(sockets.size() - first, (size_t)PASSED_SOCKETS_PER_MESSAGE);
+		// Descriptors only travel along with at least one byte of data.
+		char byte = 0;
+		iovec buffer = { &byte, 1 };
+		vector<char> control(CMSG_SPACE(count * sizeof(int)), 0);
+		msghdr message = {};
+		message.msg_iov = &buffer;
+		message.msg_iovlen = 1;
+		message.msg_control = control.data();
+		message.msg_controllen = control.size();
+		cmsghdr* header = CMSG_FIRSTHDR(&message);
+		header->cmsg_level = SOL_SOCKET;
+		header->cmsg_type = SCM_RIGHTS;
+		header->cmsg_len = CMSG_LEN(count * sizeof(int));
+		std::memcpy(CMSG_DATA(header), sockets.data() + first, count * sizeof(int));
+		ssize_t res;
+		do
+		{
+			res = sendmsg(channel, &message, MSG_NOSIGNAL);
+		} while (res == SOCKET_ERROR && errno == EINTR);
+		if (res != 1) return false;
+	}
+	return true;
+#endif
+}
+
+bool Socket::receiveSockets(SOCKET channel, const size_t count, vector<SOCKET>& sockets)
+{
+#ifdef _WIN32
+	return count == 0;
+#else
+	while (sockets.size() < count)
+	{
+		char byte = 0;
+		iovec buffer = { &byte, 1 };
+		vector<char> control(CMSG_SPACE(PASSED_SOCKETS_PER_MESSAGE * sizeof(int)), 0);
+		msghdr message = {};
+		message.msg_iov = &buffer;
+		message.msg_iovlen = 1;
+		message.msg_control = control.data();
+		message.msg_controllen = control.size();
+		ssize_t res;
+		do
+		{
+			res = recvmsg(channel, &message, MSG_CMSG_CLOEXEC);
+		} while (res == SOCKET_ERROR && errno == EINTR);
+		if (res != 1 || (message.msg_flags & MSG_CTRUNC)) return false;
+		for (cmsghdr* header = CMSG_FIRSTHDR(&message); header != nullptr; header = CMSG_NXTHDR(&message, header))
+		{
+			if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) continue;
+			size_t received = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+			const unsigned char* data = CMSG_DATA(header);
+			for (size_t i = 0; i < received; i++)
+			{
+				int socket;
+				std::memcpy(&socket, data + i * sizeof(int), sizeof(int));
+				sockets.push_back(socket);
+			}
+		}
+	}
+	return sockets.size() == count;
+#endif
+}
+
+int Socket::lastError()
+{
+#ifdef _WIN32
+	return WSAGetLastError();
+#else
+	return errno;
+#endif
+}
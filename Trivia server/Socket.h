@@ -0,0 +1,236 @@
+#pragma once
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#include <WS2tcpip.h>
+#include <Windows.h>
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+
+// WinSock names, so the rest of the server can use one vocabulary on every platform.
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define SOCKET_ERROR (-1)
+#endif
+
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+#define SEND_SEGMENTS 64 // Most segments given to one vectored send.
+#define PASSED_SOCKETS_PER_MESSAGE 250 // The kernel takes at most 253 descriptors per message (SCM_MAX_FD).
+
+/*
+* One contiguous piece of a vectored send.
+*/
+struct Segment
+{
+	const char* data;
+	size_t len;
+};
+
+/****
+ * @brief Portable wrappers around the platform socket API.
+ *
+ * WinSock2 and BSD sockets differ in how sockets are closed, how non-blocking
+ * mode is set and how errors are reported. This class hides those differences
+ * so the communication layer never calls closesocket/ioctlsocket/fcntl directly.
+ ****/
+class Socket
+{
+public:
+    /****
+     * @brief Creates a TCP socket that listens on every interface, or on one IPv4 address.
+     *
+     * @param port The port to listen on.
+     * @param reusePort Whether other sockets may listen on the same port (SO_REUSEPORT),
+     * the kernel then spreads incoming connections between them.
+     * @param address The IPv4 address to listen on, empty for every interface.
+     * @returns The listening socket, already in non-blocking mode.
+     * @throws std::runtime_error If the address is invalid or the socket could not be created, bound or put in listen mode.
+     ****/
+    static SOCKET createListener(const int port, const bool reusePort = false, const string& address = "");
+
+    /****
+     * @returns True if the platform balances connections between listeners that share a port.
+     ****/
+    static bool supportsReusePort();
+
+    /****
+     * @brief Accepts one pending connection.
+     *
+     * @param listener A listening socket.
+     * @returns The new socket (non-blocking, no delay), or INVALID_SOCKET when nothing is pending.
+     ****/
+    static SOCKET acceptClient(SOCKET listener);
+
+    /****
+     * @brief Closes a socket.
+     *
+     * @param socket The socket to close.
+     ****/
+    static void closeSocket(SOCKET socket);
+
+    /****
+     * @brief Puts a socket in non-blocking mode.
+     *
+     * @param socket The socket to change.
+     * @returns True on success.
+     ****/
+    static bool setNonBlocking(SOCKET socket);
+
+    /****
+     * @brief Disables Nagle's algorithm, responses are small and latency sensitive.
+     *
+     * @param socket The socket to change.
+     ****/
+    static void setNoDelay(SOCKET socket);
+
+    /****
+     * @brief Gets the address of the other side of a connected socket.
+     *
+     * @param socket A connected socket.
+     * @returns The IPv4 or IPv6 address in text form, empty for a Unix domain socket or if it is unknown.
+     ****/
+    static string getPeerAddress(SOCKET socket);
+
+    /****
+     * @brief Gets the port a socket is bound to.
+     *
+     * @returns The port, 0 if the socket is not an IPv4 or IPv6 socket.
+     ****/
+    static int getLocalPort(SOCKET socket);
+
+    /****
+     * @brief Receives at most len bytes.
+     *
+     * @returns The number of bytes received, 0 on orderly shutdown or SOCKET_ERROR.
+     ****/
+    static int receive(SOCKET socket, char* data, const int len);
+
+    /****
+     * @brief Sends at most len bytes.
+     *
+     * @returns The number of bytes sent or SOCKET_ERROR.
+     ****/
+    static int sendSome(SOCKET socket, const char* data, const int len);
+
+    /****
+     * @brief Sends several segments with one call (sendmsg, WSASend on Windows).
+     *
+     * @param segments The segments, in order.
+     * @param count The number of segments, at most SEND_SEGMENTS.
+     * @returns The number of bytes sent or SOCKET_ERROR.
+     ****/
+    static int sendSegments(SOCKET socket, const Segment* segments, const int count);
+
+    /****
+     * @brief Checks whether the last failed call only means "try again later".
+     *
+     * @returns True for EWOULDBLOCK/EAGAIN (and EINTR on POSIX).
+     ****/
+    static bool wouldBlock();
+
+    /****
+     * @brief Creates a socket pair that can be used to wake a blocked poll call.
+     *
+     * The read end becomes readable whenever a byte is written to the write end.
+     *
+     * @param readEnd Receives the socket to poll on.
+     * @param writeEnd Receives the socket to write to.
+     * @throws std::runtime_error If the pair could not be created.
+     ****/
+    static void createWakeupPair(SOCKET& readEnd, SOCKET& writeEnd);
+
+    /****
+     * @brief Creates a Unix domain stream socket that listens on a path, replacing a socket
+     * file that is left there. A socket that still accepts connections is not replaced.
+     *
+     * @param path The file system path of the socket.
+     * @param forClients Whether the event loops accept on it: non-blocking with a full backlog
+     * instead of blocking with room for one connection.
+     * @returns The listening socket, or INVALID_SOCKET on failure and where Unix sockets are not supported.
+     ****/
+    static SOCKET createLocalListener(const string& path, const bool forClients = false);
+
+    /****
+     * @returns True if the socket is a Unix domain socket.
+     ****/
+    static bool isLocal(SOCKET socket);
+
+    /****
+     * @brief Waits for a connection on a listener made by createLocalListener.
+     *
+     * @returns The connected socket, blocking, or INVALID_SOCKET if the listener failed.
+     ****/
+    static SOCKET acceptLocal(SOCKET listener);
+
+    /****
+     * @brief Connects a blocking Unix domain stream socket to a path.
+     *
+     * @param path The file system path of the listening socket.
+     * @returns The connected socket, or INVALID_SOCKET if nothing listens there.
+     ****/
+    static SOCKET connectLocal(const string& path);
+
+    /****
+     * @brief Connects a TCP socket to a host, blocking until the connection is made or refused.
+     *
+     * @param host A host name or address.
+     * @param port The port to connect to.
+     * @returns The connected socket in non-blocking mode without Nagle's delay, or INVALID_SOCKET.
+     ****/
+    static SOCKET connectTo(const string& host, const int port);
+
+    /****
+     * @brief Sends every byte, blocking.
+     *
+     * @returns True on success.
+     ****/
+    static bool sendAll(SOCKET socket, const char* data, const size_t len);
+
+    /****
+     * @brief Receives exactly len bytes, blocking.
+     *
+     * @returns False if the connection ended first or the receive failed.
+     ****/
+    static bool receiveAll(SOCKET socket, char* data, const size_t len);
+
+    /****
+     * @brief Passes open sockets to the process on the other side of a Unix socket (SCM_RIGHTS),
+     * PASSED_SOCKETS_PER_MESSAGE at a time. The sockets stay open in this process too.
+     *
+     * @param channel A connected Unix domain stream socket.
+     * @param sockets The sockets to pass, in order.
+     * @returns True on success, false on failure and on Windows.
+     ****/
+    static bool sendSockets(SOCKET channel, const vector<SOCKET>& sockets);
+
+    /****
+     * @brief Receives sockets passed by sendSockets, in order.
+     *
+     * @param channel A connected Unix domain stream socket.
+     * @param count The number of sockets the other side passes.
+     * @param sockets Receives the sockets.
+     * @returns True if every socket arrived.
+     ****/
+    static bool receiveSockets(SOCKET channel, const size_t count, vector<SOCKET>& sockets);
+
+    /****
+     * @returns The last socket error code of the calling thread.
+     ****/
+    static int lastError();
+};
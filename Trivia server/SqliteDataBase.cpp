@@ -142,6 +142,28 @@ void SqliteDataBase::close()
 	_db = nullptr;
 }
 
+bool SqliteDataBase::openInMemoryCopy()
+{
+	sqlite3* copy = nullptr;
+	if (_db == nullptr || sqlite3_open(":memory:", &copy) != SQLITE_OK)
+	{
+		sqlite3_close(copy);
+		return false;
+	}
+	sqlite3_backup* backup = sqlite3_backup_init(copy, "main", _db, "main");
+	bool copied = backup != nullptr && sqlite3_backup_step(backup, -1) == SQLITE_DONE;
+	sqlite3_backup_finish(backup);
+	if (!copied)
+	{
+		sqlite3_close(copy);
+		std::cout << "Failed to copy DB" << std::endl;
+		return false;
+	}
+	sqlite3_close(_db);
+	_db = copy;
+	return true;
+}
+
 void SqliteDataBase::clear()
 {
 }
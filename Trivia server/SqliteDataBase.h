@@ -125,7 +125,17 @@ public:
 	/**
 	* Closes the connection to the database.
 	*/
-	virtual void close() override;	/**
+	virtual void close() override;
+
+	/**
+	* Replaces the open connection with an in-memory copy of the database,
+	* nothing written afterwards reaches the file.
+	*
+	* @return True if the copy is in use, false if the file connection was kept.
+	*/
+	bool openInMemoryCopy();
+
+	/**
 	* Clears any cached data or temporary state within the database interface.
 	*/
 	virtual void clear() override;
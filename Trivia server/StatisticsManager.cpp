@@ -1,4 +1,5 @@
 #include "StatisticsManager.h"
+#include "VersionCounter.h"
 using std::to_string;
 
 StatisticsManager* StatisticsManager::instancePtr = nullptr;
@@ -6,6 +7,17 @@ StatisticsManager* StatisticsManager::instancePtr = nullptr;
 StatisticsManager::StatisticsManager()
 {
 	mDb = SqliteDataBase::getInstance();	
+	mVersion = VersionCounter::next();
+}
+
+unsigned int StatisticsManager::getVersion() const
+{
+	return mVersion;
+}
+
+void StatisticsManager::markChanged()
+{
+	mVersion = VersionCounter::next();
 }
 
 vector<string> StatisticsManager::getHighScore()
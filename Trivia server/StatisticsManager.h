@@ -3,6 +3,7 @@
 #include "SqliteDataBase.h"
 #include <vector>
 #include <string>
+#include <atomic>
 
 using std::vector;
 using std::string;
@@ -53,6 +54,20 @@ public:
      ****/
     static StatisticsManager* getInstance();
 
+    /****
+     * @brief Gets the version of the statistics, it grows whenever a game's statistics are saved.
+     *
+     * One version covers the high scores and every user's statistics.
+     *
+     * @returns The current version.
+     ****/
+    unsigned int getVersion() const;
+
+    /****
+     * @brief Marks the statistics as changed, so conditional reads of them fetch them again.
+     ****/
+    void markChanged();
+
 private:
     /****
      * @brief Private constructor to enforce singleton pattern.
@@ -62,5 +77,6 @@ private:
     StatisticsManager();
 
     IDataBase* mDb; ///< Pointer to the database instance.
+    std::atomic<unsigned int> mVersion; ///< Read by the workers as well as by the loops.
     static StatisticsManager* instancePtr; ///< Pointer to the singleton instance.
 };
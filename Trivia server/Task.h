@@ -0,0 +1,170 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+/****
+ * @brief The result of a request handler that may suspend: a value that is ready
+ * already, or a coroutine that produces it.
+ *
+ * A plain handler returns its value, which converts to a ready task without a
+ * coroutine frame. A handler written as a coroutine does not run until its task
+ * is started or awaited. An awaiting coroutine continues right where the awaited
+ * one finished, on the same thread. An exception thrown by the coroutine is
+ * rethrown by get() or by the co_await.
+ ****/
+template<typename T>
+class Task
+{
+public:
+    class promise_type
+    {
+    public:
+        Task get_return_object()
+        {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        /****
+         * @brief Continues the coroutine that awaited this one, if any.
+         ****/
+        struct Finished
+        {
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> finished) noexcept
+            {
+                std::coroutine_handle<> next = finished.promise().mContinuation;
+                return next ? next : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept
+            {
+            }
+        };
+
+        Finished final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_value(T value)
+        {
+            mValue.emplace(std::move(value));
+        }
+
+        void unhandled_exception()
+        {
+            mError = std::current_exception();
+        }
+
+    private:
+        friend class Task;
+        std::optional<T> mValue;
+        std::exception_ptr mError;
+        std::coroutine_handle<> mContinuation; // The coroutine that awaits this one.
+    };
+
+    Task() = default;
+
+    /****
+     * @brief A task that is ready with its value.
+     ****/
+    Task(T value) : mValue(std::move(value))
+    {
+    }
+
+    Task(Task&& other) noexcept : mValue(std::move(other.mValue)), mHandle(std::exchange(other.mHandle, nullptr))
+    {
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (mHandle) mHandle.destroy();
+            mValue = std::move(other.mValue);
+            mHandle = std::exchange(other.mHandle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    /****
+     * @brief Destroys the coroutine, and with it the coroutines it awaits, wherever it is suspended.
+     ****/
+    ~Task()
+    {
+        if (mHandle) mHandle.destroy();
+    }
+
+    /****
+     * @returns Whether the value (or the exception) is there, without suspending.
+     ****/
+    bool isReady() const
+    {
+        return mHandle ? mHandle.done() : mValue.has_value();
+    }
+
+    /****
+     * @brief Runs the coroutine until it finishes or first suspends. Called once, by
+     * whoever drives the task instead of awaiting it. A ready task has nothing to run.
+     ****/
+    void start()
+    {
+        if (mHandle && !mHandle.done()) mHandle.resume();
+    }
+
+    /****
+     * @brief Starts the task if it was not, and takes its value.
+     *
+     * @throws std::logic_error If the coroutine is suspended, and whatever the coroutine threw.
+     ****/
+    T get()
+    {
+        if (!mHandle) return std::move(*mValue);
+        start();
+        if (!mHandle.done())
+            throw std::logic_error("Task - get() on a suspended task");
+        promise_type& promise = mHandle.promise();
+        if (promise.mError) std::rethrow_exception(promise.mError);
+        return std::move(*promise.mValue);
+    }
+
+    bool await_ready() const noexcept
+    {
+        return !mHandle;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        mHandle.promise().mContinuation = awaiting;
+        return mHandle;
+    }
+
+    T await_resume()
+    {
+        return get();
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : mHandle(handle)
+    {
+    }
+
+    std::optional<T> mValue; // The value of a ready task, the coroutine keeps its own.
+    std::coroutine_handle<promise_type> mHandle;
+};
@@ -0,0 +1,146 @@
+#include "TimerWheel.h"
+#include <algorithm>
+
+TimerNode::TimerNode()
+{
+	mPrev = nullptr;
+	mNext = nullptr;
+	mExpires = 0;
+}
+
+TimerNode::~TimerNode()
+{
+	if (isArmed()) unlink();
+}
+
+bool TimerNode::isArmed() const
+{
+	return mNext != nullptr && mNext != this;
+}
+
+void TimerNode::unlink()
+{
+	mPrev->mNext = mNext;
+	mNext->mPrev = mPrev;
+	mPrev = nullptr;
+	mNext = nullptr;
+}
+
+TimerWheel::TimerWheel()
+{
+	for (auto& level : mSlots)
+	{
+		for (TimerNode& sentinel : level)
+		{
+			sentinel.mPrev = &sentinel;
+			sentinel.mNext = &sentinel;
+		}
+	}
+	mStart = std::chrono::steady_clock::now();
+	mCurrent = 0;
+	mCount = 0;
+}
+
+void TimerWheel::schedule(TimerNode& node, const unsigned int delayMs)
+{
+	cancel(node);
+	unsigned long long ticks = (delayMs + TIMER_TICK_MS - 1) / TIMER_TICK_MS;
+	//One tick more: the current tick is partly over, so a deadline never fires early.
+	node.mExpires = std::max(getNowTick(), mCurrent) + ticks + 1;
+	place(node);
+	mCount++;
+}
+
+void TimerWheel::cancel(TimerNode& node)
+{
+	if (!node.isArmed()) return;
+	node.unlink();
+	mCount--;
+}
+
+void TimerWheel::advance(vector<TimerNode*>& expired)
+{
+	unsigned long long now = getNowTick();
+	while (mCurrent < now)
+	{
+		mCurrent++;
+		unsigned int level = 0;
+		//Level 0 wrapped: bring the next slot of every wrapped level down.
+		while (level + 1 < TIMER_LEVELS && ((mCurrent >> (level * TIMER_SLOTS_BITS)) & TIMER_SLOTS_MASK) == 0)
+		{
+			level++;
+			if (cascade(level) != 0) break;
+		}
+		TimerNode& sentinel = mSlots[0][mCurrent & TIMER_SLOTS_MASK];
+		while (sentinel.mNext != &sentinel)
+		{
+			TimerNode* node = sentinel.mNext;
+			node->unlink();
+			mCount--;
+			expired.push_back(node);
+		}
+	}
+}
+
+bool TimerWheel::empty() const
+{
+	return mCount == 0;
+}
+
+int TimerWheel::getTimeout() const
+{
+	if (empty()) return -1;
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - mStart).count();
+	return (int)(TIMER_TICK_MS - elapsed % TIMER_TICK_MS);
+}
+
+void TimerWheel::place(TimerNode& node)
+{
+	unsigned long long delta = node.mExpires - mCurrent;
+	unsigned int level = 0;
+	while (level + 1 < TIMER_LEVELS && delta >= (1ULL << ((level + 1) * TIMER_SLOTS_BITS)))
+	{
+		level++;
+	}
+	if (delta >= (1ULL << (TIMER_LEVELS * TIMER_SLOTS_BITS)))
+	{
+		//Beyond the wheel: clamp to the farthest deadline it holds.
+		node.mExpires = mCurrent + (1ULL << (TIMER_LEVELS * TIMER_SLOTS_BITS)) - 1;
+	}
+	TimerNode& sentinel = mSlots[level][(node.mExpires >> (level * TIMER_SLOTS_BITS)) & TIMER_SLOTS_MASK];
+	node.mPrev = sentinel.mPrev;
+	node.mNext = &sentinel;
+	sentinel.mPrev->mNext = &node;
+	sentinel.mPrev = &node;
+}
+
+unsigned int TimerWheel::cascade(const unsigned int level)
+{
+	unsigned int index = (mCurrent >> (level * TIMER_SLOTS_BITS)) & TIMER_SLOTS_MASK;
+	TimerNode& sentinel = mSlots[level][index];
+	TimerNode list;
+	//Detach the whole slot first, placing may link nodes back into this level.
+	if (sentinel.mNext != &sentinel)
+	{
+		list.mNext = sentinel.mNext;
+		list.mPrev = sentinel.mPrev;
+		list.mNext->mPrev = &list;
+		list.mPrev->mNext = &list;
+		sentinel.mNext = &sentinel;
+		sentinel.mPrev = &sentinel;
+		while (list.mNext != &list)
+		{
+			TimerNode* node = list.mNext;
+			node->unlink();
+			place(*node);
+		}
+	}
+	list.mNext = nullptr;
+	return index;
+}
+
+unsigned long long TimerWheel::getNowTick() const
+{
+	auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - mStart).count();
+	return (unsigned long long)elapsed / TIMER_TICK_MS;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+
+using std::vector;
+
+#define TIMER_TICK_MS 100
+#define TIMER_LEVELS 4
+#define TIMER_SLOTS_BITS 6
+#define TIMER_SLOTS (1 << TIMER_SLOTS_BITS)
+#define TIMER_SLOTS_MASK (TIMER_SLOTS - 1)
+
+/****
+ * @brief A deadline that can sit in a TimerWheel. Objects with a deadline derive from it,
+ * so arming and cancelling never allocate.
+ ****/
+class TimerNode
+{
+public:
+    TimerNode();
+    /****
+     * @brief Leaves the wheel if the node is still armed.
+     ****/
+    virtual ~TimerNode();
+
+    bool isArmed() const; //getter
+
+private:
+    friend class TimerWheel;
+
+    /****
+     * @brief Takes the node out of its slot list.
+     ****/
+    void unlink();
+
+    TimerNode* mPrev;
+    TimerNode* mNext;
+    unsigned long long mExpires; // Tick of the deadline.
+};
+
+/****
+ * @brief A hierarchical timer wheel: TIMER_LEVELS rings of TIMER_SLOTS slots, each level
+ * TIMER_SLOTS times coarser than the one below.
+ *
+ * Arming, re-arming and cancelling a deadline are O(1): a node is linked into the slot
+ * of its deadline. Every tick the lowest ring moves one slot and its nodes expire; when
+ * it wraps, the next slot of the level above is spread over the lower ring. A loop owns
+ * its wheel, it is not thread safe.
+ ****/
+class TimerWheel
+{
+public:
+    TimerWheel();
+
+    /****
+     * @brief Arms a node, or moves it if it is armed already.
+     *
+     * @param node The node.
+     * @param delayMs The time from now to the deadline, it fires up to one tick late, never early.
+     ****/
+    void schedule(TimerNode& node, const unsigned int delayMs);
+
+    /****
+     * @brief Disarms a node. Does nothing if it is not armed.
+     ****/
+    void cancel(TimerNode& node);
+
+    /****
+     * @brief Moves the wheel to the current time.
+     *
+     * @param expired Receives the nodes whose deadline passed, they are disarmed.
+     ****/
+    void advance(vector<TimerNode*>& expired);
+
+    bool empty() const; //getter
+
+    /****
+     * @returns The milliseconds until the next tick, or -1 if nothing is armed (wait forever).
+     ****/
+    int getTimeout() const;
+
+private:
+    /****
+     * @brief Links a node into the slot its deadline falls in, relative to the current tick.
+     ****/
+    void place(TimerNode& node);
+
+    /****
+     * @brief Spreads the current slot of a level over the levels below it.
+     *
+     * @returns The index of that slot, 0 means the level wrapped as well.
+     ****/
+    unsigned int cascade(const unsigned int level);
+
+    unsigned long long getNowTick() const;
+
+    TimerNode mSlots[TIMER_LEVELS][TIMER_SLOTS]; // Sentinels of circular lists.
+    unsigned long long mCurrent; // The last tick that was processed.
+    std::chrono::steady_clock::time_point mStart;
+    size_t mCount;
+};
@@ -0,0 +1,209 @@
+#include "TlsAcceptor.h"
+#include <stdexcept>
+
+#ifdef HAS_TLS
+
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <poll.h>
+#include <algorithm>
+
+using std::chrono::steady_clock;
+
+#define SESSION_ID_CONTEXT "trivia"
+
+TlsAcceptor::TlsAcceptor(const string& certificate, const string& privateKey, std::function<void(SOCKET, TlsSession*)> onSecured)
+{
+	mContext = SSL_CTX_new(TLS_server_method());
+	if (mContext == nullptr)
+		throw std::runtime_error("TlsAcceptor - SSL_CTX_new");
+	SSL_CTX_set_min_proto_version(mContext, TLS1_2_VERSION);
+	// OpenSSL moves the record encryption to the kernel after the handshake where it can.
+	SSL_CTX_set_options(mContext, SSL_OP_ENABLE_KTLS | SSL_OP_NO_RENEGOTIATION);
+	SSL_CTX_set_mode(mContext, SSL_MODE_RELEASE_BUFFERS); //Idle connections give their buffers back.
+	// Resumption: tickets for TLS 1.3 and 1.2 clients, the session cache for 1.2 clients without them.
+	SSL_CTX_set_session_cache_mode(mContext, SSL_SESS_CACHE_SERVER);
+	SSL_CTX_set_session_id_context(mContext, (const unsigned char*)SESSION_ID_CONTEXT, sizeof(SESSION_ID_CONTEXT) - 1);
+	SSL_CTX_set_num_tickets(mContext, TLS_TICKETS);
+	if (SSL_CTX_use_certificate_chain_file(mContext, certificate.c_str()) != 1 ||
+		SSL_CTX_use_PrivateKey_file(mContext, privateKey.c_str(), SSL_FILETYPE_PEM) != 1 ||
+		SSL_CTX_check_private_key(mContext) != 1)
+	{
+		SSL_CTX_free(mContext);
+		throw std::runtime_error("TlsAcceptor - cannot load " + certificate + " and " + privateKey);
+	}
+
+	mOnSecured = onSecured;
+	mStopping = false;
+	Socket::createWakeupPair(mWakeRead, mWakeWrite);
+	mThread = std::thread(&TlsAcceptor::run, this);
+}
+
+TlsAcceptor::~TlsAcceptor()
+{
+	mStopping = true;
+	char byte = 0;
+	Socket::sendSome(mWakeWrite, &byte, 1);
+	mThread.join();
+	Socket::closeSocket(mWakeRead);
+	Socket::closeSocket(mWakeWrite);
+	SSL_CTX_free(mContext); //Sessions still open hold their own reference.
+}
+
+void TlsAcceptor::handshake(SOCKET client)
+{
+	{
+		std::lock_guard<mutex> lock(mIncomingLock);
+		mIncoming.push_back(client);
+	}
+	char byte = 0;
+	Socket::sendSome(mWakeWrite, &byte, 1);
+}
+
+void TlsAcceptor::run()
+{
+	vector<pollfd> fds;
+	while (!mStopping)
+	{
+		takeIncoming();
+		steady_clock::time_point now = steady_clock::now();
+		long long timeout = -1;
+		fds.clear();
+		fds.push_back(pollfd{ mWakeRead, POLLIN, 0 });
+		for (Handshake& handshake : mHandshakes)
+		{
+			fds.push_back(pollfd{ handshake.socket, handshake.events, 0 });
+			long long left = std::max(0LL, (long long)std::chrono::duration_cast<std::chrono::milliseconds>(handshake.deadline - now).count());
+			timeout = timeout < 0 ? left : std::min(timeout, left);
+		}
+
+		poll(fds.data(), (nfds_t)fds.size(), (int)timeout);
+		if (fds[0].revents != 0)
+		{
+			char drain[64];
+			while (Socket::receive(mWakeRead, drain, sizeof(drain)) > 0);
+		}
+
+		now = steady_clock::now();
+		size_t kept = 0;
+		for (size_t i = 0; i < mHandshakes.size(); i++)
+		{
+			Handshake& handshake = mHandshakes[i];
+			bool going = true;
+			if (fds[i + 1].revents != 0)
+			{
+				going = advance(handshake);
+			}
+			else if (now >= handshake.deadline)
+			{
+				drop(handshake);
+				going = false;
+			}
+			if (going) mHandshakes[kept++] = handshake;
+		}
+		mHandshakes.resize(kept);
+	}
+
+	takeIncoming();
+	for (Handshake& handshake : mHandshakes)
+	{
+		drop(handshake);
+	}
+	mHandshakes.clear();
+}
+
+void TlsAcceptor::takeIncoming()
+{
+	vector<SOCKET> incoming;
+	{
+		std::lock_guard<mutex> lock(mIncomingLock);
+		incoming.swap(mIncoming);
+	}
+	for (SOCKET client : incoming)
+	{
+		SSL* ssl = mHandshakes.size() < MAX_TLS_HANDSHAKES ? SSL_new(mContext) : nullptr;
+		if (ssl == nullptr || SSL_set_fd(ssl, (int)client) != 1)
+		{
+			SSL_free(ssl);
+			Socket::closeSocket(client);
+			continue;
+		}
+		SSL_set_accept_state(ssl);
+		mHandshakes.push_back(Handshake{ client, ssl, POLLIN, steady_clock::now() + std::chrono::milliseconds(TLS_HANDSHAKE_TIMEOUT_MS) });
+	}
+}
+
+bool TlsAcceptor::advance(Handshake& handshake)
+{
+	ERR_clear_error();
+	int res = SSL_do_handshake(handshake.ssl);
+	if (res == 1)
+	{
+		bool kernelSends = BIO_get_ktls_send(SSL_get_wbio(handshake.ssl)) != 0;
+		bool kernelReceives = BIO_get_ktls_recv(SSL_get_rbio(handshake.ssl)) != 0;
+		if (kernelSends && kernelReceives)
+		{
+			// The kernel does all of the record layer, to the loop it is a plain socket now.
+			SSL_free(handshake.ssl);
+			mOnSecured(handshake.socket, nullptr);
+		}
+		else
+		{
+			mOnSecured(handshake.socket, new TlsSession(handshake.ssl, kernelSends, kernelReceives));
+		}
+		return false;
+	}
+	switch (SSL_get_error(handshake.ssl, res))
+	{
+	case SSL_ERROR_WANT_READ:
+		handshake.events = POLLIN;
+		return true;
+	case SSL_ERROR_WANT_WRITE:
+		handshake.events = POLLOUT;
+		return true;
+	default:
+		drop(handshake);
+		return false;
+	}
+}
+
+void TlsAcceptor::drop(Handshake& handshake)
+{
+	SSL_free(handshake.ssl);
+	Socket::closeSocket(handshake.socket);
+}
+
+#else
+
+TlsAcceptor::TlsAcceptor(const string& certificate, const string& privateKey, std::function<void(SOCKET, TlsSession*)> onSecured)
+{
+	throw std::runtime_error("TlsAcceptor - the server was built without OpenSSL");
+}
+
+TlsAcceptor::~TlsAcceptor()
+{
+}
+
+void TlsAcceptor::handshake(SOCKET client)
+{
+	Socket::closeSocket(client);
+}
+
+void TlsAcceptor::run()
+{
+}
+
+void TlsAcceptor::takeIncoming()
+{
+}
+
+bool TlsAcceptor::advance(Handshake& handshake)
+{
+	return false;
+}
+
+void TlsAcceptor::drop(Handshake& handshake)
+{
+}
+
+#endif
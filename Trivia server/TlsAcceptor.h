@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Socket.h"
+#include "TlsSession.h"
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <chrono>
+
+using std::vector;
+using std::mutex;
+
+#define TLS_HANDSHAKE_TIMEOUT_MS 10000 // A client that does not finish its handshake by then is dropped.
+#define MAX_TLS_HANDSHAKES 4096 // Handshakes in progress, later clients are dropped until some finish.
+#define TLS_TICKETS 1 // Session tickets per full handshake, a resumed session gets a fresh one each time.
+
+struct ssl_ctx_st;
+
+/****
+ * @brief Runs the TLS handshakes of a TLS listener on a thread of its own, so
+ * certificate signatures never stall a reactor.
+ *
+ * The handshake runs on the socket itself, which lets OpenSSL hand record
+ * encryption to the kernel (kTLS) where it supports it. Clients that return
+ * with a session ticket resume without the full handshake. A finished
+ * connection is passed on with its TlsSession, or with none when the kernel
+ * took both directions over and the loop can treat it as a plain socket.
+ ****/
+class TlsAcceptor
+{
+public:
+    /****
+     * @brief Loads the certificate and its key and starts the handshake thread.
+     *
+     * @param certificate A PEM file with the certificate chain, the server certificate first.
+     * @param privateKey A PEM file with the private key of the certificate.
+     * @param onSecured Called on the handshake thread for every finished handshake.
+     * @throws std::runtime_error If the files cannot be loaded, or the server was built without OpenSSL.
+     ****/
+    TlsAcceptor(const string& certificate, const string& privateKey, std::function<void(SOCKET, TlsSession*)> onSecured);
+
+    /****
+     * @brief Stops the thread and closes the sockets whose handshake did not finish.
+     ****/
+    ~TlsAcceptor();
+
+    /****
+     * @brief Starts the handshake of an accepted socket. Safe to call from any thread.
+     *
+     * @param client The accepted socket, non-blocking. The acceptor closes it if the handshake fails.
+     ****/
+    void handshake(SOCKET client);
+
+private:
+    /****
+     * @brief A handshake in progress.
+     ****/
+    struct Handshake
+    {
+        SOCKET socket;
+        ssl_st* ssl;
+        short events; // What the handshake waits for, POLLIN or POLLOUT.
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    /****
+     * @brief Polls the handshakes in progress until the acceptor is destroyed.
+     ****/
+    void run();
+
+    /****
+     * @brief Takes the sockets handed over by handshake() since the last pass.
+     ****/
+    void takeIncoming();
+
+    /****
+     * @brief Moves a handshake forward after its socket became ready.
+     *
+     * @returns False once it is over, finished and passed on or failed and closed.
+     ****/
+    bool advance(Handshake& handshake);
+
+    /****
+     * @brief Closes a socket whose handshake failed.
+     ****/
+    void drop(Handshake& handshake);
+
+    ssl_ctx_st* mContext;
+    std::function<void(SOCKET, TlsSession*)> mOnSecured;
+    vector<Handshake> mHandshakes; // Only touched by the handshake thread.
+    mutex mIncomingLock;
+    vector<SOCKET> mIncoming;
+    SOCKET mWakeRead;
+    SOCKET mWakeWrite;
+    std::atomic<bool> mStopping;
+    std::thread mThread;
+};
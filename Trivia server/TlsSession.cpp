@@ -0,0 +1,135 @@
+#include "TlsSession.h"
+
+#ifdef HAS_TLS
+
+#include <openssl/ssl.h>
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <climits>
+#include <algorithm>
+
+TlsSession::TlsSession(SSL* ssl, const bool kernelSends, const bool kernelReceives)
+{
+	mSsl = ssl;
+	mReceived = nullptr;
+	mSent = nullptr;
+	// The handshake ran on the socket itself, from now on the loop does the socket I/O.
+	if (!kernelReceives)
+	{
+		mReceived = BIO_new(BIO_s_mem());
+		BIO_set_mem_eof_return(mReceived, -1); //Empty means "wait for more", not end of stream.
+		SSL_set0_rbio(mSsl, mReceived);
+	}
+	if (!kernelSends)
+	{
+		mSent = BIO_new(BIO_s_mem());
+		SSL_set0_wbio(mSsl, mSent);
+	}
+}
+
+TlsSession::~TlsSession()
+{
+	SSL_free(mSsl); //Frees the memory buffers too, the socket is closed by the loop.
+}
+
+bool TlsSession::decryptsReceived() const
+{
+	return mReceived != nullptr;
+}
+
+bool TlsSession::encryptsSent() const
+{
+	return mSent != nullptr;
+}
+
+bool TlsSession::decrypt(const char* data, const size_t len, RingBuffer& inbound)
+{
+	if (len > 0 && BIO_write(mReceived, data, (int)len) != (int)len) return false;
+	ERR_clear_error(); //SSL_get_error reads the thread's error queue.
+	while (true)
+	{
+		char* space = nullptr;
+		size_t room = inbound.prepare(space);
+		int res = SSL_read(mSsl, space, (int)std::min(room, (size_t)INT_MAX));
+		if (res > 0)
+		{
+			inbound.commit(res);
+			continue;
+		}
+		//Reading may have written alerts or post-handshake replies.
+		collect();
+		return SSL_get_error(mSsl, res) == SSL_ERROR_WANT_READ;
+	}
+}
+
+void TlsSession::seal(OutboundQueue& plain)
+{
+	if (plain.empty()) return;
+	// One write for the whole queue: OpenSSL cuts it into full records, not one per response.
+	string bytes = plain.copyBytes();
+	plain.advance(bytes.size());
+	// Memory buffers never block, a write only fails on a session the peer already broke,
+	// and the next read closes that connection.
+	ERR_clear_error();
+	SSL_write(mSsl, bytes.data(), (int)bytes.size());
+	collect();
+}
+
+OutboundQueue& TlsSession::getRecords()
+{
+	return mRecords;
+}
+
+void TlsSession::collect()
+{
+	if (mSent == nullptr) return;
+	size_t pending = BIO_ctrl_pending(mSent);
+	if (pending == 0) return;
+	string records(pending, '\0');
+	BIO_read(mSent, &records[0], (int)pending);
+	mRecords.pushBytes(std::move(records));
+}
+
+#else
+
+// Without OpenSSL no session is ever made, TlsAcceptor refuses to start.
+TlsSession::TlsSession(ssl_st* ssl, const bool kernelSends, const bool kernelReceives)
+{
+	mSsl = ssl;
+	mReceived = nullptr;
+	mSent = nullptr;
+}
+
+TlsSession::~TlsSession()
+{
+}
+
+bool TlsSession::decryptsReceived() const
+{
+	return false;
+}
+
+bool TlsSession::encryptsSent() const
+{
+	return false;
+}
+
+bool TlsSession::decrypt(const char* data, const size_t len, RingBuffer& inbound)
+{
+	return false;
+}
+
+void TlsSession::seal(OutboundQueue& plain)
+{
+}
+
+OutboundQueue& TlsSession::getRecords()
+{
+	return mRecords;
+}
+
+void TlsSession::collect()
+{
+}
+
+#endif
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "RingBuffer.h"
+#include "OutboundQueue.h"
+
+// TLS is built where OpenSSL is installed. The Windows project does not link it.
+#if !defined(_WIN32) && defined(__has_include)
+#if __has_include(<openssl/ssl.h>)
+#define HAS_TLS
+#endif
+#endif
+
+#define TLS_RECORD_SIZE 16384 // The largest TLS record payload.
+
+struct ssl_st;
+struct bio_st;
+
+/****
+ * @brief The TLS state of one established connection.
+ *
+ * The handshake ran before the connection reached its loop (see TlsAcceptor).
+ * A direction the kernel took over (kTLS) needs nothing from the session, the
+ * loop reads or writes plain bytes there. The other directions go through
+ * memory buffers: received records are passed to decrypt(), queued responses
+ * are turned into records by seal() and the loop writes those instead.
+ ****/
+class TlsSession
+{
+public:
+    /****
+     * @brief Takes over the TLS object of a finished handshake.
+     *
+     * @param ssl The TLS object, owned by the session from now on.
+     * @param kernelSends Whether the kernel encrypts what is sent.
+     * @param kernelReceives Whether the kernel decrypts what is received.
+     ****/
+    TlsSession(ssl_st* ssl, const bool kernelSends, const bool kernelReceives);
+    ~TlsSession();
+
+    /****
+     * @returns Whether received bytes are records for decrypt(), false if the kernel decrypts them.
+     ****/
+    bool decryptsReceived() const;
+
+    /****
+     * @returns Whether queued responses are sealed into records, false if the kernel encrypts them.
+     ****/
+    bool encryptsSent() const;
+
+    /****
+     * @brief Decrypts received records into the inbound buffer. A record cut short is kept until the rest arrives.
+     *
+     * @returns False if the records are broken or the client ended the session (close_notify).
+     ****/
+    bool decrypt(const char* data, const size_t len, RingBuffer& inbound);
+
+    /****
+     * @brief Encrypts every queued response into records, one record per TLS_RECORD_SIZE bytes
+     * however many responses they hold, and empties the queue.
+     *
+     * @param plain The outbound queue of the connection.
+     ****/
+    void seal(OutboundQueue& plain);
+
+    /****
+     * @returns The records waiting to be written, in order.
+     ****/
+    OutboundQueue& getRecords();
+
+private:
+    /****
+     * @brief Moves what the TLS object wrote to its memory buffer to the records.
+     ****/
+    void collect();
+
+    ssl_st* mSsl;
+    bio_st* mReceived; // Records waiting to be decrypted, nullptr when the kernel decrypts.
+    bio_st* mSent; // Records the TLS object wrote, nullptr when the kernel encrypts.
+    OutboundQueue mRecords;
+};
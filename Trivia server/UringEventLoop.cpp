@@ -0,0 +1,531 @@
+#include "UringEventLoop.h"
+
+#ifdef __linux__
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <stdexcept>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#define OP_SHIFT 56
+#define GENERATION_SHIFT 32
+#define GENERATION_MASK 0xFFFFFF
+
+UringEventLoop::UringEventLoop(IConnectionEvents* events) : EventLoop(events)
+{
+	mRing = -1;
+	mSqRing = MAP_FAILED;
+	mCqRing = MAP_FAILED;
+	mEntries = (io_uring_sqe*)MAP_FAILED;
+	mBufferRing = (io_uring_buf_ring*)MAP_FAILED;
+	mBuffers = nullptr;
+	mWakeFd = -1;
+	mPending = 0;
+	mWakeValue = 0;
+	mNextGeneration = 0;
+	try
+	{
+		setup();
+	}
+	catch (...)
+	{
+		release(); //The destructor does not run for a constructor that throws.
+		throw;
+	}
+}
+
+UringEventLoop::~UringEventLoop()
+{
+	release();
+}
+
+void UringEventLoop::setup()
+{
+	io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+	mRing = (int)syscall(__NR_io_uring_setup, URING_ENTRIES, &params);
+	if (mRing < 0)
+		throw std::runtime_error("UringEventLoop - io_uring_setup");
+
+	mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	mEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+	mSqRing = mmap(nullptr, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQ_RING);
+	mCqRing = mmap(nullptr, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_CQ_RING);
+	mEntries = (io_uring_sqe*)mmap(nullptr, mEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mRing, IORING_OFF_SQES);
+	if (mSqRing == MAP_FAILED || mCqRing == MAP_FAILED || mEntries == MAP_FAILED)
+		throw std::runtime_error("UringEventLoop - mmap");
+
+	char* sq = (char*)mSqRing;
+	mSqHead = (unsigned int*)(sq + params.sq_off.head);
+	mSqTail = (unsigned int*)(sq + params.sq_off.tail);
+	mSqMask = *(unsigned int*)(sq + params.sq_off.ring_mask);
+	mSqArray = (unsigned int*)(sq + params.sq_off.array);
+	char* cq = (char*)mCqRing;
+	mCqHead = (unsigned int*)(cq + params.cq_off.head);
+	mCqTail = (unsigned int*)(cq + params.cq_off.tail);
+	mCqMask = *(unsigned int*)(cq + params.cq_off.ring_mask);
+	mCqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	// Receive buffers the kernel picks from, one ring shared by every connection of the loop.
+	mBufferRing = (io_uring_buf_ring*)mmap(nullptr, URING_BUFFER_COUNT * sizeof(io_uring_buf), PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+	if (mBufferRing == MAP_FAILED)
+		throw std::runtime_error("UringEventLoop - buffer ring");
+	mBuffers = new char[(size_t)URING_BUFFER_COUNT * URING_BUFFER_SIZE];
+	io_uring_buf_reg reg;
+	std::memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (unsigned long long)mBufferRing;
+	reg.ring_entries = URING_BUFFER_COUNT;
+	reg.bgid = URING_BUFFER_GROUP;
+	if (syscall(__NR_io_uring_register, mRing, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+		throw std::runtime_error("UringEventLoop - register buffer ring");
+	mBufferRing->tail = 0;
+	for (unsigned short i = 0; i < URING_BUFFER_COUNT; i++)
+	{
+		recycle(i);
+	}
+
+	// 5.19 has buffer rings but not multishot receive, every receive would fail there.
+	if (!probeMultishotReceive())
+		throw std::runtime_error("UringEventLoop - multishot receive");
+
+	mWakeFd = eventfd(0, EFD_CLOEXEC);
+	if (mWakeFd < 0)
+		throw std::runtime_error("UringEventLoop - eventfd");
+}
+
+void UringEventLoop::release()
+{
+	if (mRing >= 0) ::close(mRing);
+	if (mEntries != MAP_FAILED) munmap(mEntries, mEntriesSize);
+	if (mCqRing != MAP_FAILED) munmap(mCqRing, mCqRingSize);
+	if (mSqRing != MAP_FAILED) munmap(mSqRing, mSqRingSize);
+	if (mBufferRing != MAP_FAILED) munmap(mBufferRing, URING_BUFFER_COUNT * sizeof(io_uring_buf));
+	delete[] mBuffers;
+	if (mWakeFd >= 0) ::close(mWakeFd);
+	mRing = -1;
+	mEntries = (io_uring_sqe*)MAP_FAILED;
+	mCqRing = MAP_FAILED;
+	mSqRing = MAP_FAILED;
+	mBufferRing = (io_uring_buf_ring*)MAP_FAILED;
+	mBuffers = nullptr;
+	mWakeFd = -1;
+}
+
+bool UringEventLoop::probeMultishotReceive()
+{
+	// A kernel that does not know the flag refuses it when preparing the entry,
+	// one that does gets as far as the invalid socket.
+	io_uring_sqe* entry = getEntry();
+	entry->opcode = IORING_OP_RECV;
+	entry->fd = -1;
+	entry->ioprio = IORING_RECV_MULTISHOT;
+	entry->flags = IOSQE_BUFFER_SELECT;
+	entry->buf_group = URING_BUFFER_GROUP;
+	entry->user_data = 0;
+	enter(1);
+	unsigned int head = *mCqHead;
+	if (head == __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE)) return false;
+	int res = mCqes[head & mCqMask].res;
+	__atomic_store_n(mCqHead, head + 1, __ATOMIC_RELEASE);
+	return res != -EINVAL;
+}
+
+void UringEventLoop::addListener(SOCKET listener)
+{
+	post([this, listener]()
+		{
+			mListeners.push_back(listener);
+			submitAccept(listener);
+		});
+}
+
+void UringEventLoop::run()
+{
+	mThreadId = std::this_thread::get_id();
+	submitWakeup();
+	submitTimer();
+	while (!mStopping)
+	{
+		uncork(); //Queues one send per corked connection, the enter below submits them all.
+		// Submitting runs the kernel side of the sends and receives, which is part of the pass.
+		// Only waiting for completions that are not there yet is idle.
+		enter(0);
+		endPass();
+		if (*mCqHead == __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE)) enter(1);
+		beginPass();
+		completeAll();
+	}
+	runTasks();
+	closeAll();
+}
+
+void UringEventLoop::detachAll()
+{
+	for (SOCKET listener : mListeners)
+	{
+		unlisten(listener);
+	}
+	steady_clock::time_point deadline = steady_clock::now() + std::chrono::milliseconds(HANDOFF_SETTLE_MS);
+	while (steady_clock::now() < deadline)
+	{
+		// Connections accepted meanwhile are paused too and go along with the others.
+		vector<shared_ptr<Connection>> connections;
+		for (auto& it : mConnections)
+		{
+			connections.push_back(it.second);
+		}
+		for (shared_ptr<Connection>& connection : connections)
+		{
+			if (!connection->isReadPaused())
+			{
+				connection->setReadPaused(true);
+				setReading(*connection, false);
+			}
+			flush(*connection);
+		}
+		if (mReceiving.empty() && mSending.empty()) break;
+		enter(1); //The timer keeps ticking while handing off, so this returns by the next tick.
+		completeAll();
+	}
+	vector<shared_ptr<Connection>> connections;
+	for (auto& it : mConnections)
+	{
+		connections.push_back(it.second);
+	}
+	for (shared_ptr<Connection>& connection : connections)
+	{
+		if (connection->getTls() != nullptr || connection->getLink() != nullptr || connection->isBusy() ||
+			mReceiving.count(connection->getSocket()) || getPendingBytes(*connection) > connection->getUnsentBytes())
+		{
+			close(*connection);
+			continue;
+		}
+		mTimers.cancel(*connection);
+		unwatch(*connection);
+	}
+}
+
+void UringEventLoop::completeAll()
+{
+	unsigned int head = *mCqHead;
+	unsigned int tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+	while (head != tail)
+	{
+		io_uring_cqe cqe = mCqes[head & mCqMask];
+		head++;
+		__atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+		complete(cqe);
+	}
+}
+
+void UringEventLoop::flush(Connection& connection)
+{
+	if (connection.isClosed()) return;
+	auto generation = mGenerations.find(connection.getSocket());
+	if (generation == mGenerations.end()) return;
+	unsigned long long userData = encode(SEND, generation->second, connection.getSocket());
+	//With a send in flight the rest goes when it completes.
+	bool inFlight = mSending.count(userData) != 0;
+	if (connection.getUnsentBytes() == 0 || inFlight)
+	{
+		if (connection.isPeerClosed() && !connection.isBusy() && !inFlight)
+		{
+			close(connection); //Everything it was owed is sent.
+			return;
+		}
+		checkBackpressure(connection);
+		return;
+	}
+
+	std::unique_ptr<Sending>& sending = mSending[userData];
+	sending.reset(new Sending());
+	sending->packets.prepend(connection.seal());
+	Segment segments[SEND_SEGMENTS];
+	int count = sending->packets.gather(segments, SEND_SEGMENTS);
+	for (int i = 0; i < count; i++)
+	{
+		sending->buffers[i].iov_base = (void*)segments[i].data;
+		sending->buffers[i].iov_len = segments[i].len;
+	}
+	std::memset(&sending->message, 0, sizeof(sending->message));
+	sending->message.msg_iov = sending->buffers;
+	sending->message.msg_iovlen = count;
+
+	io_uring_sqe* entry = getEntry();
+	entry->opcode = IORING_OP_SENDMSG;
+	entry->fd = connection.getSocket();
+	entry->addr = (unsigned long long)&sending->message;
+	entry->len = 1;
+	entry->msg_flags = MSG_NOSIGNAL;
+	entry->user_data = userData;
+	checkBackpressure(connection);
+}
+
+void UringEventLoop::watch(Connection& connection)
+{
+	mNextGeneration = (mNextGeneration + 1) & GENERATION_MASK;
+	mGenerations[connection.getSocket()] = mNextGeneration;
+	submitReceive(connection.getSocket());
+}
+
+void UringEventLoop::unwatch(Connection& connection)
+{
+	mReceiving.erase(connection.getSocket());
+	mGenerations.erase(connection.getSocket());
+	// The cancel has to reach the kernel while the descriptor is still open.
+	io_uring_sqe* entry = getEntry();
+	entry->opcode = IORING_OP_ASYNC_CANCEL;
+	entry->fd = connection.getSocket();
+	entry->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+	entry->user_data = encode(CANCEL, 0, connection.getSocket());
+	enter(0);
+}
+
+void UringEventLoop::setReading(Connection& connection, const bool reading)
+{
+	SOCKET socket = connection.getSocket();
+	auto generation = mGenerations.find(socket);
+	if (generation == mGenerations.end()) return;
+	if (reading)
+	{
+		// A receive whose cancel did not complete yet is still armed and simply keeps going.
+		if (!mReceiving.count(socket)) submitReceive(socket);
+		return;
+	}
+	if (!mReceiving.count(socket)) return;
+	io_uring_sqe* entry = getEntry();
+	entry->opcode = IORING_OP_ASYNC_CANCEL;
+	entry->addr = encode(RECEIVE, generation->second, socket);
+	entry->user_data = encode(CANCEL, 0, socket);
+}
+
+void UringEventLoop::unlisten(SOCKET listener)
+{
+	// Closing the descriptor does not end an armed accept, the ring holds its own reference.
+	io_uring_sqe* entry = getEntry();
+	entry->opcode = IORING_OP_ASYNC_CANCEL;
+	entry->fd = listener;
+	entry->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+	entry->user_data = encode(CANCEL, 0, listener);
+	enter(0);
+}
+
+size_t UringEventLoop::getPendingBytes(Connection& connection)
+{
+	size_t pending = connection.getUnsentBytes();
+	auto generation = mGenerations.find(connection.getSocket());
+	if (generation == mGenerations.end()) return pending;
+	auto sending = mSending.find(encode(SEND, generation->second, connection.getSocket()));
+	if (sending != mSending.end()) pending += sending->second->packets.size();
+	return pending;
+}
+
+void UringEventLoop::wake()
+{
+	eventfd_write(mWakeFd, 1);
+}
+
+io_uring_sqe* UringEventLoop::getEntry()
+{
+	unsigned int tail = *mSqTail;
+	if (tail - __atomic_load_n(mSqHead, __ATOMIC_ACQUIRE) > mSqMask)
+	{
+		enter(0); //Queue is full.
+	}
+	unsigned int index = tail & mSqMask;
+	io_uring_sqe* entry = &mEntries[index];
+	std::memset(entry, 0, sizeof(*entry));
+	mSqArray[index] = index;
+	__atomic_store_n(mSqTail, tail + 1, __ATOMIC_RELEASE);
+	mPending++;
+	return entry;
+}
+
+void UringEventLoop::enter(const unsigned int minComplete)
+{
+	int res = (int)syscall(__NR_io_uring_enter, mRing, mPending, minComplete, minComplete > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+	if (res > 0)
+	{
+		mPending -= std::min((unsigned int)res, mPending);
+	}
+}
+
+void UringEventLoop::submitAccept(SOCKET listener)
+{
+	io_uring_sqe* entry = getEntry();
+	entry->opcode = IORING_OP_ACCEPT;
+	entry->fd = listener;
+	entry->ioprio = IORING_ACCEPT_MULTISHOT;
+	entry->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+	entry->user_data = encode(ACCEPT, 0, listener);
+}
+
+void UringEventLoop::submitReceive(SOCKET socket)
+{
+	io_uring_sqe* entry = getEntry();
+	entry->opcode = IORING_OP_RECV;
+	entry->fd = socket;
+	entry->ioprio = IORING_RECV_MULTISHOT;
+	entry->flags = IOSQE_BUFFER_SELECT;
+	entry->buf_group = URING_BUFFER_GROUP;
+	entry->user_data = encode(RECEIVE, mGenerations[socket], socket);
+	mReceiving.insert(socket);
+}
+
+void UringEventLoop::submitWakeup()
+{
+	io_uring_sqe* entry = getEntry();
+	entry->opcode = IORING_OP_READ;
+	entry->fd = mWakeFd;
+	entry->addr = (unsigned long long)&mWakeValue;
+	entry->len = sizeof(mWakeValue);
+	entry->user_data = encode(WAKEUP, 0, mWakeFd);
+}
+
+void UringEventLoop::submitTimer()
+{
+	mTick.tv_sec = 0;
+	mTick.tv_nsec = TIMER_TICK_MS * 1000000LL;
+	io_uring_sqe* entry = getEntry();
+	entry->opcode = IORING_OP_TIMEOUT;
+	entry->fd = -1;
+	entry->addr = (unsigned long long)&mTick;
+	entry->len = 1;
+	entry->off = 0; // A pure timeout, not waiting for a count of completions.
+	entry->user_data = encode(TIMER, 0, 0);
+}
+
+void UringEventLoop::complete(const io_uring_cqe& cqe)
+{
+	Operation op = (Operation)(cqe.user_data >> OP_SHIFT);
+	unsigned int generation = (cqe.user_data >> GENERATION_SHIFT) & GENERATION_MASK;
+	SOCKET socket = (SOCKET)(cqe.user_data & 0xFFFFFFFF);
+	bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+
+	// A completion may belong to a socket that was closed and reused since.
+	shared_ptr<Connection> connection = nullptr;
+	auto live = mGenerations.find(socket);
+	if (live != mGenerations.end() && live->second == generation)
+	{
+		connection = find(socket);
+	}
+
+	switch (op)
+	{
+	case ACCEPT:
+		if (cqe.res >= 0)
+		{
+			Socket::setNoDelay(cqe.res);
+			mEvents->onAccept(*this, socket, cqe.res);
+		}
+		else if (cqe.res == -EINVAL)
+		{
+			std::cout << "io_uring multishot accept is not supported by this kernel" << std::endl;
+			break;
+		}
+		if (!more && !mStopping && std::find(mListeners.begin(), mListeners.end(), socket) != mListeners.end())
+		{
+			submitAccept(socket);
+		}
+		break;
+	case WAKEUP:
+		runTasks();
+		if (!mStopping) submitWakeup();
+		break;
+	case TIMER:
+		expireTimers();
+		if (!mStopping || mHandingOff) submitTimer();
+		break;
+	case RECEIVE:
+	{
+		bool hasBuffer = (cqe.flags & IORING_CQE_F_BUFFER) != 0;
+		unsigned short bufferId = (unsigned short)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+		bool appended = true;
+		if (cqe.res > 0 && connection != nullptr)
+		{
+			appended = connection->append(mBuffers + (size_t)bufferId * URING_BUFFER_SIZE, cqe.res);
+		}
+		if (hasBuffer) recycle(bufferId);
+		if (connection == nullptr) break;
+		if (!more) mReceiving.erase(socket);
+		if (!appended)
+		{
+			close(*connection); //Broken or closed TLS session.
+		}
+		else if (cqe.res > 0)
+		{
+			// Bytes of a receive that was being cancelled wait in the inbound buffer until the resume or
+			// until the awaiting request is done. The cancel only lands once the multishot receive comes
+			// round again, a client that keeps sending meanwhile is dropped at the read limit instead of being buffered.
+			if (!connection->isReadStopped())
+			{
+				drain(*connection);
+				touch(*connection);
+			}
+			else if (connection->getInbound().size() > INBOUND_READ_LIMIT)
+			{
+				close(*connection);
+				break;
+			}
+			if (!more && !connection->isClosed() && !connection->isReadStopped()) submitReceive(socket);
+		}
+		else if (cqe.res == -ENOBUFS || cqe.res == -ECANCELED)
+		{
+			//Every buffer was busy and they are recycled by now, or a pause cancelled the receive.
+			if (!connection->isReadStopped()) submitReceive(socket);
+		}
+		else if (cqe.res == 0)
+		{
+			closeWhenReplied(*connection); //Closing now would cancel the send of the corked replies.
+		}
+		else
+		{
+			close(*connection);
+		}
+		break;
+	}
+	case SEND:
+	{
+		auto it = mSending.find(cqe.user_data);
+		if (it == mSending.end()) break;
+		std::unique_ptr<Sending> sending = std::move(it->second);
+		mSending.erase(it);
+		if (connection == nullptr) break;
+		if (cqe.res < 0)
+		{
+			close(*connection);
+			break;
+		}
+		// Partial send: what is left goes before anything queued since.
+		sending->packets.advance(cqe.res);
+		connection->seal().prepend(sending->packets);
+		flush(*connection);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void UringEventLoop::recycle(const unsigned short bufferId)
+{
+	unsigned short tail = mBufferRing->tail;
+	// Not mBufferRing->bufs: in C++ the kernel's flexible array macro shifts it by 8 bytes.
+	io_uring_buf* buffer = (io_uring_buf*)mBufferRing + (tail & (URING_BUFFER_COUNT - 1));
+	buffer->addr = (unsigned long long)(mBuffers + (size_t)bufferId * URING_BUFFER_SIZE);
+	buffer->len = URING_BUFFER_SIZE;
+	buffer->bid = bufferId;
+	__atomic_store_n(&mBufferRing->tail, (unsigned short)(tail + 1), __ATOMIC_RELEASE);
+}
+
+unsigned long long UringEventLoop::encode(const Operation op, const unsigned int generation, const SOCKET socket)
+{
+	return ((unsigned long long)op << OP_SHIFT) | ((unsigned long long)(generation & GENERATION_MASK) << GENERATION_SHIFT) | (unsigned int)socket;
+}
+
+#endif
@@ -0,0 +1,172 @@
+#pragma once
+
+#ifdef __linux__
+
+#include "EventLoop.h"
+#include <linux/io_uring.h>
+#include <set>
+
+#define URING_ENTRIES 4096
+#define URING_BUFFER_COUNT 1024 // Must be a power of two.
+#define URING_BUFFER_SIZE 16384
+#define URING_BUFFER_GROUP 0
+#define HANDOFF_SETTLE_MS 1000 // How long a hot upgrade waits for receives to be cancelled and sends to complete.
+
+/****
+ * @brief A completion based loop on io_uring (Linux 6.0 and newer).
+ *
+ * Accept and receive are multishot: one submission keeps producing completions.
+ * Receives land in a ring of buffers registered with the kernel, so no read
+ * call is needed per message. Sends queued while handling a batch of completions
+ * are submitted together with the next wait, one io_uring_enter per iteration.
+ ****/
+class UringEventLoop : public EventLoop
+{
+public:
+    /****
+     * @brief Sets up the ring, maps it and registers the receive buffers.
+     *
+     * @param events The receiver of connection callbacks.
+     * @throws std::runtime_error If the kernel does not support the needed io_uring features.
+     ****/
+    UringEventLoop(IConnectionEvents* events);
+    virtual ~UringEventLoop();
+
+    virtual void addListener(SOCKET listener) override;
+    virtual void run() override;
+
+    /****
+     * @brief Submits the outbound queue as one sendmsg. Only one send is in flight per connection,
+     * bytes queued meanwhile go out when it completes. A connection whose peer shut down is closed
+     * by the flush after its last send completed.
+     ****/
+    virtual void flush(Connection& connection) override;
+
+protected:
+    virtual void watch(Connection& connection) override;
+    virtual void unwatch(Connection& connection) override;
+    virtual void wake() override;
+
+    /****
+     * @brief Cancels the multishot accept of a listener before it is closed.
+     ****/
+    virtual void unlisten(SOCKET listener) override;
+
+    /****
+     * @brief Cancels the accepts and the receives and waits for them and for the sends in flight,
+     * so no byte is left inside the ring, then detaches the connections. A connection whose send
+     * is still in flight after HANDOFF_SETTLE_MS is closed instead of handed over, so is a TLS connection
+     * and one with a request awaiting or on the workers.
+     ****/
+    virtual void detachAll() override;
+
+    /****
+     * @brief Cancels the multishot receive of a paused connection, or submits a new one when it resumes.
+     ****/
+    virtual void setReading(Connection& connection, const bool reading) override;
+
+    /****
+     * @returns The queued bytes plus the ones of the send in flight.
+     ****/
+    virtual size_t getPendingBytes(Connection& connection) override;
+
+private:
+    enum Operation { ACCEPT = 1, RECEIVE, SEND, WAKEUP, CANCEL, TIMER };
+
+    /****
+     * @brief A sendmsg in flight: the packets it sends and the message that points into them.
+     ****/
+    struct Sending
+    {
+        OutboundQueue packets;
+        iovec buffers[SEND_SEGMENTS];
+        msghdr message;
+    };
+
+    /****
+     * @brief Creates the ring, its buffer ring and the wake up event.
+     * @throws std::runtime_error if the kernel lacks any of them, the caller falls back to epoll then.
+     ****/
+    void setup();
+
+    /****
+     * @brief Closes and unmaps whatever setup got to create.
+     ****/
+    void release();
+
+    /****
+     * @returns Whether the kernel accepts multishot receives.
+     ****/
+    bool probeMultishotReceive();
+
+    /****
+     * @brief Gets a free submission entry, submitting the queue first if it is full.
+     ****/
+    io_uring_sqe* getEntry();
+
+    /****
+     * @brief Handles every completion the ring holds.
+     ****/
+    void completeAll();
+
+    /****
+     * @brief Submits the queued entries and waits for at least minComplete completions.
+     ****/
+    void enter(const unsigned int minComplete);
+
+    void submitAccept(SOCKET listener);
+    void submitReceive(SOCKET socket);
+    void submitWakeup();
+
+    /****
+     * @brief Submits a timeout of one timer wheel tick, the loop expires idle connections when it fires.
+     ****/
+    void submitTimer();
+
+    /****
+     * @brief Handles one completion entry.
+     ****/
+    void complete(const io_uring_cqe& cqe);
+
+    /****
+     * @brief Gives a receive buffer back to the kernel.
+     ****/
+    void recycle(const unsigned short bufferId);
+
+    /****
+     * @brief Packs an operation, a connection generation and a socket into user data.
+     * The generation tells completions of a closed socket apart from a new one with the same number.
+     ****/
+    static unsigned long long encode(const Operation op, const unsigned int generation, const SOCKET socket);
+
+    int mRing;
+    void* mSqRing;
+    void* mCqRing;
+    size_t mSqRingSize;
+    size_t mCqRingSize;
+    io_uring_sqe* mEntries;
+    size_t mEntriesSize;
+    unsigned int* mSqHead;
+    unsigned int* mSqTail;
+    unsigned int mSqMask;
+    unsigned int* mSqArray;
+    unsigned int* mCqHead;
+    unsigned int* mCqTail;
+    unsigned int mCqMask;
+    io_uring_cqe* mCqes;
+    unsigned int mPending; // Entries filled but not submitted yet.
+
+    io_uring_buf_ring* mBufferRing;
+    char* mBuffers;
+
+    int mWakeFd;
+    unsigned long long mWakeValue;
+    __kernel_timespec mTick;
+
+    unsigned int mNextGeneration;
+    map<SOCKET, unsigned int> mGenerations;
+    map<unsigned long long, std::unique_ptr<Sending>> mSending; // Keeps every in-flight send alive until its completion.
+    std::set<SOCKET> mReceiving; // Sockets with a multishot receive armed.
+};
+
+#endif
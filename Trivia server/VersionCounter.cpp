@@ -0,0 +1,28 @@
+#include "VersionCounter.h"
+#include <chrono>
+
+static unsigned int seed()
+{
+	return (unsigned int)std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Set before main, so the loops and the workers never race to create it.
+std::atomic<unsigned int> VersionCounter::sCurrent(seed());
+
+unsigned int VersionCounter::next()
+{
+	unsigned int version = ++sCurrent;
+	//NO_VERSION never matches, so it is skipped when the counter wraps.
+	return version != 0 ? version : ++sCurrent;
+}
+
+unsigned int VersionCounter::current()
+{
+	return sCurrent;
+}
+
+void VersionCounter::restore(const unsigned int version)
+{
+	unsigned int current = sCurrent;
+	while (current < version && !sCurrent.compare_exchange_weak(current, version));
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+
+/****
+ * @brief Hands out the versions of the room list, the rooms, the games and the statistics.
+ *
+ * A conditional read does not name the object its version belongs to, the handler state
+ * of the connection picks it. So every version comes from one process-wide counter and no
+ * two objects ever share one: a version cached for a room cannot match the next room the
+ * client enters. The counter starts at the wall clock in seconds, so a restarted server
+ * begins above what its clients cached unless it changed state faster than once a second,
+ * and a hot upgrade carries it over in the snapshot.
+ ****/
+class VersionCounter
+{
+public:
+    /****
+     * @returns A version no object had before. Safe from any thread.
+     ****/
+    static unsigned int next();
+
+    /****
+     * @returns The last version handed out, for the snapshot.
+     ****/
+    static unsigned int current();
+
+    /****
+     * @brief Continues after a version of another process, never going back.
+     *
+     * @param version The current() of the process that handed over.
+     ****/
+    static void restore(const unsigned int version);
+
+private:
+    static std::atomic<unsigned int> sCurrent;
+};
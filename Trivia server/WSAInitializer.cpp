@@ -1,12 +1,20 @@
 #include "WSAInitializer.h"
 #include <exception>
+#include <stdexcept>
+#ifndef _WIN32
+#include <signal.h>
+#endif
 
 
 WSAInitializer::WSAInitializer()
 {
+#ifdef _WIN32
 	WSADATA wsa_data = { };
 	if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) 
-		throw std::exception("WSAStartup Failed");
+		throw std::runtime_error("WSAStartup Failed");
+#else
+	signal(SIGPIPE, SIG_IGN);
+#endif
 }
 
 WSAInitializer::~WSAInitializer()
@@ -21,7 +29,9 @@ WSAInitializer::~WSAInitializer()
 	// exception from the destructor.
 	try
 	{
+#ifdef _WIN32
 		WSACleanup();
+#endif
 	}
 	catch (...) {}
 }
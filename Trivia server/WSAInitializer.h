@@ -1,10 +1,10 @@
 #pragma once
 
-#include <WinSock2.h>
-#include <Windows.h>
+#include "Socket.h"
 
 /*
 * A class used to run server safely.
+* Starts WinSock on Windows, elsewhere only makes sure a closed peer can't kill the process.
 */
 class WSAInitializer
 {
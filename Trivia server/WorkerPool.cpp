@@ -0,0 +1,77 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <climits>
+
+WorkerPool::WorkerPool(const unsigned int count)
+{
+	mStopping = false;
+	mWindowStart = steady_clock::now();
+	mWindowMin = UINT_MAX;
+	mQueueDelay = 0;
+	for (unsigned int i = 0; i < std::max(1u, count); i++)
+	{
+		mThreads.push_back(std::thread(&WorkerPool::work, this));
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<mutex> lock(mTasksLock);
+		mStopping = true;
+	}
+	mTaskReady.notify_all();
+	for (std::thread& t : mThreads)
+	{
+		t.join();
+	}
+}
+
+void WorkerPool::submit(std::function<void()> task)
+{
+	{
+		std::lock_guard<mutex> lock(mTasksLock);
+		mTasks.push_back(Task{ std::move(task), steady_clock::now() });
+	}
+	mTaskReady.notify_one();
+}
+
+void WorkerPool::work()
+{
+	while (true)
+	{
+		Task task;
+		{
+			std::unique_lock<mutex> lock(mTasksLock);
+			if (mTasks.empty())
+			{
+				//Ran dry, nothing is queued.
+				mQueueDelay = 0;
+				mWindowMin = UINT_MAX;
+				mWindowStart = steady_clock::now();
+			}
+			mTaskReady.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+			if (mTasks.empty()) return; //Stopping and nothing left.
+			task = std::move(mTasks.front());
+			mTasks.pop_front();
+			measure(task);
+		}
+		task.run();
+	}
+}
+
+unsigned int WorkerPool::getQueueDelay() const
+{
+	return mQueueDelay;
+}
+
+void WorkerPool::measure(const Task& task)
+{
+	steady_clock::time_point now = steady_clock::now();
+	unsigned int wait = (unsigned int)std::chrono::duration_cast<std::chrono::milliseconds>(now - task.submitted).count();
+	mWindowMin = std::min(mWindowMin, wait);
+	if (now - mWindowStart < std::chrono::milliseconds(WORKER_DELAY_WINDOW_MS)) return;
+	mQueueDelay = mWindowMin;
+	mWindowMin = UINT_MAX;
+	mWindowStart = now;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+using std::vector;
+using std::deque;
+using std::mutex;
+using std::chrono::steady_clock;
+
+#define DEFAULT_WORKERS 2
+#define WORKER_DELAY_WINDOW_MS 100
+
+/****
+ * @brief A fixed set of threads that run blocking work (database queries) off the event loops.
+ *
+ * Tasks are taken in the order they were submitted, but run concurrently, so
+ * they can finish in any order. A task that has a result for a connection
+ * posts it back to the connection's loop.
+ ****/
+class WorkerPool
+{
+public:
+    /****
+     * @brief Starts the worker threads.
+     *
+     * @param count The number of threads, at least one.
+     ****/
+    WorkerPool(const unsigned int count);
+
+    /****
+     * @brief Lets the threads finish the tasks already queued and joins them.
+     ****/
+    ~WorkerPool();
+
+    /****
+     * @brief Queues a task. Safe to call from any thread.
+     *
+     * @param task The task to run on a worker thread.
+     ****/
+    void submit(std::function<void()> task);
+
+    /****
+     * @brief Gets how long tasks wait in the queue: the shortest wait of the last
+     * WORKER_DELAY_WINDOW_MS, 0 as soon as the workers ran out of tasks. Safe from any thread.
+     *
+     * @returns Milliseconds.
+     ****/
+    unsigned int getQueueDelay() const;
+
+private:
+    struct Task
+    {
+        std::function<void()> run;
+        steady_clock::time_point submitted;
+    };
+
+    /****
+     * @brief The body of every worker thread.
+     ****/
+    void work();
+
+    /****
+     * @brief Counts the wait of a task that was just taken. Called with mTasksLock held.
+     ****/
+    void measure(const Task& task);
+
+    vector<std::thread> mThreads;
+    deque<Task> mTasks;
+    mutex mTasksLock;
+    std::condition_variable mTaskReady;
+    bool mStopping;
+    steady_clock::time_point mWindowStart;
+    unsigned int mWindowMin; // Milliseconds.
+    std::atomic<unsigned int> mQueueDelay;
+};
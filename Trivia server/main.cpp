@@ -1,4 +1,6 @@
+#ifdef _WIN32
 #pragma comment (lib, "ws2_32.lib")
+#endif
 
 #include "WSAInitializer.h"
 #include "Server.h"
@@ -6,10 +8,29 @@
 #include <exception>
 #include "CommunicationStructs.h"
 #include "WSAInitializer.h"
+#include "Config.h"
 
 
-int main()
+int main(int argc, char* argv[])
 {
+	Config* config = Config::getInstance();
+	config->load(CONFIG_FILE);
+	//Arguments in the form --key=value override config.txt, e.g. --io_backend=uring
+	for (int i = 1; i < argc; i++)
+	{
+		string arg = argv[i];
+		size_t separator = arg.find('=');
+		if (arg.rfind("--", 0) == 0 && separator != string::npos)
+		{
+			config->set(arg.substr(2, separator - 2), arg.substr(separator + 1));
+		}
+	}
+	//A benchmark measures the handlers: nothing is printed per request and nothing is rate limited.
+	if (config->getInt("loopback_benchmark", 0) > 0)
+	{
+		config->set("verbose", "0");
+		config->set("rate_limits", "0");
+	}
 	try
 	{
 		WSAInitializer wsaInit;